@@ -0,0 +1,25 @@
+#ifndef ANCHOR_ADVERTISEMENT_H
+#define ANCHOR_ADVERTISEMENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Vendor specific element carried in anchor beacons and probe responses:
+// 0xDD | length | OUI(3) | type | version | x | y | z (int32 mm, little endian)
+class AnchorAdvertisement {
+public:
+    static const uint8_t ELEMENT_ID = 0xDD;
+    static const uint8_t OUI_TYPE = 0x01;
+    static const uint8_t VERSION = 1;
+    static const size_t ELEMENT_SIZE = 19;
+    static const uint8_t OUI[3];
+
+    static size_t encode(float x, float y, float z, uint8_t* element, size_t size);
+    static bool decode(const uint8_t* element, size_t size, float& x, float& y, float& z);
+
+private:
+    static void writeInt32(uint8_t* buffer, int32_t value);
+    static int32_t readInt32(const uint8_t* buffer);
+};
+
+#endif
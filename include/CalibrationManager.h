@@ -0,0 +1,54 @@
+#ifndef CALIBRATION_MANAGER_H
+#define CALIBRATION_MANAGER_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "CalibrationTable.h"
+#include "Logger.h"
+
+class CalibrationManager {
+private:
+    CalibrationManager()
+        : loaded(false)
+        , calibrating(false)
+        , log(Logger::getInstance()) {}
+
+    static constexpr const char* CALIBRATION_FILE = "/calibration.bin";
+    static const uint32_t FILE_MAGIC = 0x314C4143;
+
+    Logger& log;
+
+    CalibrationTable table;
+    bool loaded;
+
+    bool calibrating;
+    uint8_t calibrationBssid[6];
+    float knownDistanceCm;
+    uint16_t targetSamples;
+    uint16_t collectedSamples;
+    double sampleSum;
+
+    void ensureLoaded();
+    bool loadFromFlash();
+    bool saveToFlash();
+    void finishCalibration();
+
+public:
+    CalibrationManager(const CalibrationManager&) = delete;
+    void operator=(const CalibrationManager&) = delete;
+
+    static CalibrationManager& getInstance() {
+        static CalibrationManager instance;
+        return instance;
+    }
+
+    float apply(const uint8_t bssid[6], float distanceCm);
+    bool startCalibration(const uint8_t bssid[6], float knownDistanceCm, uint16_t samples);
+    void cancelCalibration() { calibrating = false; }
+    bool isCalibrating() { return calibrating; }
+    bool setCalibration(const uint8_t bssid[6], float offsetCm, float scale);
+    bool clearCalibration(const uint8_t bssid[6]);
+    const CalibrationTable& getTable() { ensureLoaded(); return table; }
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef CALIBRATION_TABLE_H
+#define CALIBRATION_TABLE_H
+
+#include <stdint.h>
+#include <string.h>
+
+struct CalibrationEntry {
+    uint8_t bssid[6];
+    bool used;
+    float offsetCm;
+    float scale;
+};
+
+class CalibrationTable {
+public:
+    static const uint8_t CAPACITY = 32;
+
+    CalibrationTable() { clear(); }
+
+    void clear();
+    bool set(const uint8_t bssid[6], float offsetCm, float scale);
+    bool remove(const uint8_t bssid[6]);
+    const CalibrationEntry* find(const uint8_t bssid[6]) const;
+    float apply(const uint8_t bssid[6], float distanceCm) const;
+
+    uint8_t getCount() const { return count; }
+    const CalibrationEntry* getSlot(uint8_t index) const { return index < CAPACITY ? &entries[index] : nullptr; }
+
+private:
+    CalibrationEntry entries[CAPACITY];
+    uint8_t count;
+
+    static uint8_t hash(const uint8_t bssid[6]);
+    int16_t locate(const uint8_t bssid[6]) const;
+};
+
+#endif
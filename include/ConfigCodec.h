@@ -0,0 +1,68 @@
+#ifndef CONFIG_CODEC_H
+#define CONFIG_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "RuntimeConfig.h"
+
+enum class ConfigFieldType {
+    BOOL,
+    INTEGER,
+    FLOAT,
+    STRING,
+    __DELIMITER__
+};
+
+// tag is the stable on-flash identifier of a field; never reuse a retired one.
+struct ConfigField {
+    uint16_t tag;
+    ConfigSection section;
+    const char* name;
+    ConfigFieldType type;
+    uint16_t offset;
+    uint16_t size;
+    bool writable;
+    float min;
+    float max;
+};
+
+struct ConfigDecodeInfo {
+    uint16_t version;
+    uint16_t fields;
+    uint16_t missing;
+    uint16_t skipped;
+};
+
+typedef std::function<size_t(uint8_t* data, size_t length)> ConfigReader;
+typedef std::function<size_t(const uint8_t* data, size_t length)> ConfigWriter;
+
+// Tagged config file:
+// magic(4) | version(2) | { tag(2) | length(1) | value } ... | tag 0 | crc32(4)
+// Integers are little endian and strings carry no terminator. Tags missing
+// from a file keep the value already in the target, so files written by an
+// older firmware load on top of the defaults; unknown tags are skipped.
+class ConfigCodec {
+public:
+    static const uint32_t MAGIC = 0x47464347; // "GCFG"
+    static const uint16_t VERSION = 1;
+
+    static bool encode(const RuntimeConfig& config, ConfigWriter write);
+    // Decodes in a single pass straight into config, so pass a scratch copy
+    // holding the defaults and keep it only when this returns true.
+    static bool decode(ConfigReader read, RuntimeConfig& config, ConfigDecodeInfo& info);
+    // Reads a LegacyRuntimeConfigV0 dump of the given length over the defaults in config.
+    static bool decodeLegacy(ConfigReader read, size_t length, RuntimeConfig& config);
+
+    static const ConfigField* findField(ConfigSection section, const char* name);
+
+private:
+    static const uint16_t END_TAG = 0;
+
+    static const ConfigField* findField(uint16_t tag, size_t& hint);
+    static bool decodeValue(const ConfigField& field, const uint8_t* value, uint8_t length, RuntimeConfig& config);
+    static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t length);
+    static void copyString(char* dest, size_t destSize, const char* src, size_t srcSize);
+};
+
+#endif
@@ -3,6 +3,10 @@
 
 #define DEVICE_NAME ""
 #define DEVICE_HEARTBEAT_INTERVAL 60000
+#define DEVICE_STATUS_FORMAT 0 // 0: JSON, 1: MSGPACK
+#define DEVICE_STATUS_KEYFRAME_INTERVAL 10 // full status every n heartbeats
+#define DEVICE_STATUS_RSSI_THRESHOLD 3
+#define DEVICE_STATUS_HEAP_THRESHOLD 4096
 
 #define WIFI_SSID ""
 #define WIFI_PASSWORD ""
@@ -18,13 +22,67 @@
 #define MQTT_RETRY_INTERVAL 5000
 #define MQTT_MAX_CONNECTION_ATTEMPTS 20
 #define MQTT_BASE_TOPIC "gpsno/devices"
+#define MQTT_DRAIN_BUDGET 4 // queued messages sent per update
+#define MQTT_INFLIGHT_WINDOW 4 // unacknowledged QoS 1 messages
+#define MQTT_PERSISTENT_SESSION true
+
+#define SCAN_MAX_MS_PER_CHANNEL 120
+#define SCAN_INTERVAL 30000
+#define SCAN_CACHE_TTL 120000
+#define SCAN_AUTO_ADD_ANCHORS true
+
+#define FTM_FRAME_COUNT 16
+#define FTM_BURST_PERIOD 2
+#define FTM_REQUEST_TIMEOUT 3000
+#define FTM_ESTIMATOR 2 // 0: FIRMWARE, 1: MIN_RTT, 2: TRIMMED_MEAN, 3: PERCENTILE, 4: RSSI_WEIGHTED
+#define FTM_ESTIMATOR_PARAM 25 // trim/percentile in percent
+#define FTM_MIN_INTERVAL 250
+#define FTM_MAX_INTERVAL 4000
+#define FTM_STABLE_THRESHOLD 10
+#define FTM_ADAPTIVE_BURST true
+#define FTM_BURST_LOW_DEVIATION 15
+#define FTM_BURST_HIGH_DEVIATION 50
+#define FTM_MAX_BURST_PERIOD 10
+#define FTM_METRICS_INTERVAL 10000
+#define FTM_RECORD_REPORTS false
+#define FTM_FILTER_STAGES 7 // bitmask 1: GATE, 2: MEDIAN, 4: KALMAN
+#define FTM_FILTER_GATE_THRESHOLD 300
+#define FTM_FILTER_GATE_MAX_REJECTS 3
+#define FTM_FILTER_MEDIAN_WINDOW 5
+#define FTM_FILTER_PROCESS_NOISE 100.0
+#define FTM_FILTER_MEASUREMENT_NOISE 400.0
+
+#define ANCHOR_SSID "FTM"
+#define ANCHOR_PASSWORD "password"
+#define ANCHOR_CHANNEL 1
+#define ANCHOR_MAX_CLIENTS 4
+#define ANCHOR_POSITION_X 0.0
+#define ANCHOR_POSITION_Y 0.0
+#define ANCHOR_POSITION_Z 0.0
+
+#define POSITION_INTERVAL 1000
+#define POSITION_MAX_RANGE_AGE 5000
+#define POSITION_SOLVE_3D false
+#define POSITION_TAG_HEIGHT 1.0
 
 #define ERROR_MAX_RECOVERY_ATTEMPTS 3
 #define ERROR_RECOVERY_INTERVAL 5000
 
 #define LOGGING_LEVEL 0 // 0: DEBUG, 1: INFO, 2: WARNING, 3: ERROR
 #define LOGGING_ALLOW_MQTT_LOG true
-#define LOGGING_MQTT_TOPIC ""
+#define LOGGING_MQTT_TOPIC "" // empty: <deviceTopic>/log
+#define LOGGING_MQTT_LEVEL 1 // 0: DEBUG, 1: INFO, 2: WARNING, 3: ERROR
+#define LOGGING_MQTT_BATCH_SIZE 10 // records per publish
+#define LOGGING_MQTT_BATCH_INTERVAL 5000
+#define LOGGING_MQTT_RATE_LIMIT 1024 // bytes per second, 0: unlimited
+
+// Build-time only, may be overridden from build_flags
+#ifndef LOGGING_COMPILE_LEVEL
+#define LOGGING_COMPILE_LEVEL 0 // LOG_* calls below this level compile to nothing
+#endif
+#ifndef LOGGING_BINARY
+#define LOGGING_BINARY false // LOG_* calls store format and raw arguments, formatted by the sinks
+#endif
 
 #define UPDATE_GITHUB_API_URL "https://api.github.com/repos/Legincy/gps-no-fw/releases/latest"
 #define UPDATE_GITHUB_API_TOKEN ""
@@ -4,73 +4,43 @@
 #include <Arduino.h>
 #include <LittleFS.h>
 #include <MD5Builder.h>
+#include <functional>
 #include "WiFi.h"
 #include "ConfigDefines.h"
+#include "RuntimeConfig.h"
 
-struct RuntimeConfig {
-    struct {
-        char name[32];
-        char firmwareVersion[16];
-        uint64_t chipID;
-        char macAddress[18];
-        uint32_t statusUpdateInterval;
-    } device;
+typedef std::function<void(const RuntimeConfig& previous, const RuntimeConfig& current)> ConfigListener;
 
-    struct {
-        char ssid[32];
-        char password[64];
-        bool autoReconnect;
-        uint8_t maxConnectionAttempts;
-        uint32_t reconnectInterval;
-        uint32_t checkInterval;
-    } wifi;
-
-    struct {
-        char broker[64];
-        uint16_t port;
-        char user[32];
-        char password[64];
-        uint32_t retryInterval;
-        char baseTopic[64];
-        uint8_t maxConnectionAttempts;
-    } mqtt;
-    
-    struct {
-        uint8_t maxRecoveryAttempts;
-        uint32_t recoveryInterval;
-    } error;
-
-    struct {
-        bool allowMqttLog;
-        char mqttTopic[64];
-        uint8_t logLevel;
-    } logging;
-
-    struct {
-        char apiUrl[128];
-        char apiToken[128];
-        uint32_t interval;
-        bool initialCheck;
-    } update;
-
-    char hash[33];
+struct ConfigListenerEntry {
+    uint16_t sections;
+    ConfigListener listener;
 };
 
 class ConfigManager {
 private:
-    ConfigManager() : initialized(false) {
+    ConfigManager() : initialized(false), pendingSections(0), listenerCount(0) {
         loadDefaults();
     }
     
     RuntimeConfig config;
     static constexpr const char* CONFIG_FILE = "/config.bin";
+    static constexpr const char* CONFIG_TEMP_FILE = "/config.tmp";
+    static const uint8_t MAX_LISTENERS = 8;
     bool initialized;
 
+    // Patches are validated and staged here, then swapped into config between
+    // loop iterations so a loop never sees a half-applied update.
+    RuntimeConfig shadow;
+    uint16_t pendingSections;
+    ConfigListenerEntry listeners[MAX_LISTENERS];
+    uint8_t listenerCount;
+
     String calculateHash(RuntimeConfig* config);
     bool loadFromFlash();
     bool saveToFlash();
     void loadDefaults();
     void setConfigFromDefines(RuntimeConfig* config);
+    bool validate(const RuntimeConfig& candidate, char* error, size_t errorSize);
 
 public:
     ConfigManager(const ConfigManager&) = delete;
@@ -85,6 +55,15 @@ public:
     bool hasConfigDefinesChanged();
     void updateDeviceConfig();
     void print(RuntimeConfig* config);
+
+    bool stagePatch(const uint8_t* payload, size_t length, char* error, size_t errorSize);
+    uint16_t applyPendingPatch();
+    bool hasPendingPatch() { return pendingSections != 0; }
+    bool addListener(uint16_t sections, ConfigListener listener);
+
+    static uint16_t sectionMask(ConfigSection section) { return 1 << static_cast<uint8_t>(section); }
+    static const char* getSectionString(ConfigSection section);
+    static constexpr size_t getSectionCount() {return static_cast<size_t>(ConfigSection::__DELIMITER__);};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef CRASH_LOG_H
+#define CRASH_LOG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <esp_system.h>
+#include "Logger.h"
+#include "MQTTManager.h"
+
+enum class CrashLogKind : uint8_t {
+    LOG,
+    STATE,
+    __DELIMITER__
+};
+
+struct CrashLogEntry {
+    static const uint8_t SOURCE_LENGTH = 14;
+    static const uint8_t MESSAGE_LENGTH = 56;
+
+    uint32_t sequence; // 0: empty or being written
+    uint32_t timestamp;
+    CrashLogKind kind;
+    uint8_t level;
+    char source[SOURCE_LENGTH];
+    char message[MESSAGE_LENGTH];
+};
+
+// Keeps the most recent log records and state transitions in RTC memory,
+// which survives panics, watchdog and software resets. begin() takes over
+// what the previous boot left behind; once MQTT is connected, update()
+// uploads it to <deviceTopic>/crashlog together with the reset reason.
+class CrashLog {
+public:
+    static const uint8_t CAPACITY = 32;
+
+private:
+    static const uint32_t MAGIC = 0x43524C47;
+    static const uint16_t MAX_PAYLOAD_LENGTH = MQTTOutboundQueue::MAX_PAYLOAD_LENGTH;
+
+    CrashLog()
+        : initialized(false)
+        , nextSequence(0)
+        , resetReason(ESP_RST_UNKNOWN)
+        , bootCount(0)
+        , previous(nullptr)
+        , previousCount(0)
+        , uploadPending(false)
+        , uploadOffset(0)
+        , uploadPart(0)
+        , topic(MQTTManager::INVALID_TOPIC)
+        , mqttManager(MQTTManager::getInstance())
+        , log(Logger::getInstance()) {}
+
+    bool initialized;
+    std::atomic<uint32_t> nextSequence;
+    esp_reset_reason_t resetReason;
+    uint32_t bootCount;
+
+    CrashLogEntry* previous;
+    uint8_t previousCount;
+    bool uploadPending;
+    uint8_t uploadOffset;
+    uint8_t uploadPart;
+    MQTTTopicHandle topic;
+
+    MQTTManager& mqttManager;
+    Logger& log;
+
+    void takeOver();
+    void record(CrashLogKind kind, uint8_t level, const char* source, const char* message);
+    void recordLog(const LogRecord& record);
+    CrashLogEntry& claimEntry(CrashLogKind kind, uint8_t level, const char* source, uint32_t& sequence);
+    void commitEntry(CrashLogEntry& entry, uint32_t sequence);
+    static void onLogRecord(const LogRecord& record);
+    bool publishPart();
+
+public:
+    CrashLog(const CrashLog&) = delete;
+    void operator=(const CrashLog&) = delete;
+
+    static CrashLog& getInstance() {
+        static CrashLog instance;
+        return instance;
+    }
+
+    bool begin();
+    void update();
+    void recordState(const char* state);
+
+    esp_reset_reason_t getResetReason() const { return resetReason; }
+    uint32_t getBootCount() const { return bootCount; }
+    static const char* getResetReasonString(esp_reset_reason_t reason);
+};
+
+#endif
@@ -9,9 +9,19 @@
 #define VERSION_PATCH 1
 #define VERSION_STRING STRINGIFY(VERSION_MAJOR) "." STRINGIFY(VERSION_MINOR) "." STRINGIFY(VERSION_PATCH)
 
+#define DEVICE_TYPE_STATION 1
+#define DEVICE_TYPE_ANCHOR 2
+
+#ifndef DEVICE_TYPE
+#define DEVICE_TYPE DEVICE_TYPE_STATION
+#endif
+
 #include "ConfigManager.h"
 #include "states/DeviceState.h"
 #include "MQTTManager.h"
+#include "RPCManager.h"
+#include "MQTTLogSink.h"
+#include "CrashLog.h"
 #include "Logger.h"
 #include <ArduinoJson.h>
 
@@ -25,6 +35,20 @@ enum class DeviceStatus {
     __DELIMITER__
 };
 
+enum class StatusFormat {
+    JSON,
+    MSGPACK,
+    __DELIMITER__
+};
+
+struct StatusSnapshot {
+    const char* state;
+    int8_t rssi;
+    uint32_t heapFree;
+    uint32_t heapMinFree;
+    uint32_t heapMaxAlloc;
+};
+
 class DeviceState;
 
 class Device {
@@ -32,19 +56,32 @@ private:
     Device() 
         : currentState(nullptr)
         , lastStatusUpdate(0)
+        , statusTopic(MQTTManager::INVALID_TOPIC)
+        , lastStatus{"", 0, 0, 0, 0}
+        , statusCount(0)
         , mqttManager(MQTTManager::getInstance())
+        , rpcManager(RPCManager::getInstance())
+        , logSink(MQTTLogSink::getInstance())
+        , crashLog(CrashLog::getInstance())
         , configManager(ConfigManager::getInstance())
         , log(Logger::getInstance()) {}
     
     MQTTManager& mqttManager;
+    RPCManager& rpcManager;
+    MQTTLogSink& logSink;
+    CrashLog& crashLog;
     ConfigManager& configManager;
     Logger& log;
 
     static const size_t JSON_DOC_SIZE = 512;
     DeviceState* currentState;
     uint32_t lastStatusUpdate;
+    MQTTTopicHandle statusTopic;
+    StatusSnapshot lastStatus;
+    uint32_t statusCount;
 
     void sendDeviceStatus();
+    static bool exceeds(uint32_t current, uint32_t previous, uint32_t threshold);
 
     const char* getDeviceStatusString(DeviceStatus status);
     constexpr size_t getDeviceStatusCount() {return static_cast<size_t>(DeviceStatus::__DELIMITER__);};
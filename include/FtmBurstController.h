@@ -0,0 +1,52 @@
+#ifndef FTM_BURST_CONTROLLER_H
+#define FTM_BURST_CONTROLLER_H
+
+#include <stdint.h>
+
+struct FtmBurstConfig {
+    bool enabled;
+    uint8_t frameCount;
+    uint16_t burstPeriod;
+    uint16_t lowDeviation;
+    uint16_t highDeviation;
+    uint8_t maxBurstPeriod;
+};
+
+struct FtmBurstMetrics {
+    uint8_t frameCount;
+    uint16_t burstPeriod;
+    float deviationCm;
+    float failureRate;
+    uint32_t rampUps;
+    uint32_t rampDowns;
+};
+
+class FtmBurstController {
+public:
+    static const uint8_t LEVEL_COUNT = 4;
+    static const uint8_t QUIET_SESSIONS = 4;
+    static const uint8_t MIN_BURST_PERIOD = 2;
+
+    FtmBurstController() { reset(); }
+
+    void reset();
+    void onSuccess(float innovationCm, const FtmBurstConfig& config);
+    void onFailure(const FtmBurstConfig& config);
+
+    uint8_t getFrameCount(const FtmBurstConfig& config) const;
+    uint16_t getBurstPeriod(const FtmBurstConfig& config) const;
+    const FtmBurstMetrics& getMetrics() const { return metrics; }
+
+private:
+    uint8_t level;
+    uint8_t quietSessions;
+    bool initialized;
+    float variance;
+    FtmBurstMetrics metrics;
+
+    void rampUp();
+    void rampDown();
+    void publish(const FtmBurstConfig& config);
+};
+
+#endif
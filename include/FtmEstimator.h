@@ -0,0 +1,62 @@
+#ifndef FTM_ESTIMATOR_H
+#define FTM_ESTIMATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum class FtmEstimatorMethod {
+    FIRMWARE,
+    MIN_RTT,
+    TRIMMED_MEAN,
+    PERCENTILE,
+    RSSI_WEIGHTED,
+    __DELIMITER__
+};
+
+struct FtmEstimate {
+    uint32_t rttPs;
+    uint32_t distanceCm;
+    uint8_t validFrames;
+    int8_t meanRssi;
+};
+
+class FtmEstimator {
+public:
+    static const uint8_t MAX_FRAMES = 64;
+    static const uint32_t MAX_RTT_PS = 2000000;
+
+    // Works directly on the driver's report entries (anything with .rtt in
+    // picoseconds and .rssi in dBm) so it can run before the buffer is freed.
+    template <typename Entry>
+    static bool estimate(const Entry* entries, size_t count, FtmEstimatorMethod method, uint8_t param, FtmEstimate& estimate) {
+        uint32_t rtt[MAX_FRAMES];
+        int8_t rssi[MAX_FRAMES];
+        uint8_t valid = 0;
+
+        for (size_t i = 0; i < count && valid < MAX_FRAMES; i++) {
+            if (entries[i].rtt == 0 || entries[i].rtt > MAX_RTT_PS) {
+                continue;
+            }
+            rtt[valid] = entries[i].rtt;
+            rssi[valid] = entries[i].rssi;
+            valid++;
+        }
+
+        return estimateFromSamples(rtt, rssi, valid, method, param, estimate);
+    }
+
+    static bool estimateFromSamples(uint32_t* rtt, int8_t* rssi, uint8_t count, FtmEstimatorMethod method, uint8_t param, FtmEstimate& estimate);
+    static uint32_t rttToDistanceCm(uint32_t rttPs) { return static_cast<uint32_t>((static_cast<uint64_t>(rttPs) * 3) / 200); }
+    static const char* getMethodString(FtmEstimatorMethod method);
+
+private:
+    static void sortSamples(uint32_t* rtt, int8_t* rssi, uint8_t count);
+    static uint32_t minRtt(const uint32_t* rtt, uint8_t count);
+    static uint32_t trimmedMean(const uint32_t* sorted, uint8_t count, uint8_t trimPercent);
+    static uint32_t percentile(const uint32_t* sorted, uint8_t count, uint8_t percent);
+    static uint32_t rssiWeighted(const uint32_t* rtt, const int8_t* rssi, uint8_t count);
+
+    constexpr static size_t getMethodCount() { return static_cast<size_t>(FtmEstimatorMethod::__DELIMITER__); };
+};
+
+#endif
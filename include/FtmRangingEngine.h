@@ -0,0 +1,129 @@
+#ifndef FTM_RANGING_ENGINE_H
+#define FTM_RANGING_ENGINE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <functional>
+
+// Kept free of Arduino/ESP-IDF headers so the engine can be driven by a fake
+// event source on a host build.
+
+enum class FtmRequestState {
+    FREE,
+    PENDING,
+    IN_FLIGHT,
+    COMPLETED,
+    FAILED,
+    TIMED_OUT,
+    CANCELLED,
+    __DELIMITER__
+};
+
+struct FtmRequest {
+    uint8_t bssid[6];
+    uint8_t channel;
+    bool useConnectedAp;
+    uint8_t frameCount;
+    uint16_t burstPeriod;
+    uint32_t timeout;
+};
+
+struct FtmReport {
+    uint8_t peer[6];
+    uint8_t status;
+    uint32_t rttNs;
+    uint32_t distanceCm;
+    uint8_t frames;
+    int8_t rssi;
+};
+
+struct FtmResult {
+    uint32_t requestId;
+    FtmRequestState state;
+    uint8_t bssid[6];
+    uint8_t status;
+    uint32_t rttNs;
+    uint32_t distanceCm;
+    uint8_t frames;
+    int8_t rssi;
+    uint32_t submittedAt;
+    uint32_t startedAt;
+    uint32_t completedAt;
+};
+
+struct FtmEngineStats {
+    uint32_t submitted;
+    uint32_t rejected;
+    uint32_t completed;
+    uint32_t failed;
+    uint32_t timedOut;
+    uint32_t cancelled;
+    uint32_t droppedReports;
+    uint32_t staleReports;
+    uint32_t totalLatency;
+    uint32_t maxLatency;
+};
+
+typedef std::function<void(const FtmResult&)> FtmCallback;
+typedef std::function<bool(const FtmRequest&)> FtmInitiator;
+typedef std::function<void()> FtmTerminator;
+
+class FtmRangingEngine {
+public:
+    static const uint8_t MAX_REQUESTS = 8;
+    static const uint8_t FTM_STATUS_OK = 0;
+    // How long a timed-out or cancelled session may still deliver its report.
+    static const uint32_t SESSION_GRACE_PERIOD = 500;
+
+    FtmRangingEngine();
+
+    void setInitiator(FtmInitiator initiator) { this->initiator = initiator; }
+    // Ends the driver session when the in-flight request times out or is
+    // cancelled. The next request still waits for that session's report, or
+    // for SESSION_GRACE_PERIOD, so a late report cannot complete it.
+    void setTerminator(FtmTerminator terminator) { this->terminator = terminator; }
+
+    uint32_t submit(const FtmRequest& request, uint32_t now, FtmCallback callback = nullptr);
+    bool poll(uint32_t requestId, FtmResult& result);
+    // Callbacks still fire with CANCELLED, so owners can release the request.
+    bool cancel(uint32_t requestId, uint32_t now);
+    void onReport(const FtmReport& report);
+    void update(uint32_t now);
+
+    bool isBusy() const { return inFlight != nullptr; }
+    uint8_t getQueuedCount() const;
+    const FtmEngineStats& getStats() const { return stats; }
+    const char* getRequestStateString(FtmRequestState state) const;
+
+private:
+    struct Slot {
+        FtmRequest request;
+        FtmResult result;
+        FtmCallback callback;
+    };
+
+    Slot slots[MAX_REQUESTS];
+    Slot* inFlight;
+    uint32_t nextRequestId;
+    FtmInitiator initiator;
+    FtmTerminator terminator;
+    bool abandoned;
+    uint32_t abandonedAt;
+    FtmEngineStats stats;
+
+    FtmReport pendingReport;
+    std::atomic<bool> reportReady;
+    std::atomic<uint32_t> overruns;
+
+    Slot* findSlot(uint32_t requestId);
+    Slot* nextPending();
+    void start(Slot* slot, uint32_t now);
+    void complete(Slot* slot, FtmRequestState state, uint32_t now);
+    void abandon(uint32_t now);
+    void consumeReport(uint32_t now);
+
+    constexpr size_t getRequestStateCount() { return static_cast<size_t>(FtmRequestState::__DELIMITER__); };
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef FTM_REPLAY_H
+#define FTM_REPLAY_H
+
+#include <stdint.h>
+#include "FtmRangingEngine.h"
+#include "FtmScheduler.h"
+#include "Multilateration.h"
+
+// Replays recorded FTM sessions through the engine, the scheduler's per-anchor
+// pipeline and the solver, using record timestamps instead of wall time.
+//
+//   anchor,<bssid>,<channel>,<x>,<y>,<z>
+//   report,<t_ms>,<bssid>,<status>,<rtt_ns>,<dist_cm>,<frames>,<rssi>[,<x>,<y>,<z>]
+//
+// The optional trailing coordinates are the ground-truth tag position.
+
+typedef uint32_t (*FtmReplayClock)();
+
+struct FtmReplayStageStats {
+    uint32_t count;
+    uint64_t totalMicros;
+    uint32_t maxMicros;
+};
+
+struct FtmReplayStats {
+    uint32_t lines;
+    uint32_t parseErrors;
+    uint32_t anchors;
+    uint32_t reports;
+    uint32_t fixes;
+    uint32_t firstTimestamp;
+    uint32_t lastTimestamp;
+    FtmReplayStageStats engine;
+    FtmReplayStageStats pipeline;
+    FtmReplayStageStats solver;
+    uint32_t errorCount;
+    float errorSum;
+    float errorMax;
+};
+
+struct FtmReplayConfig {
+    FtmSchedulerConfig scheduler;
+    bool solve3d;
+    float tagHeight;
+    uint32_t positionInterval;
+    uint32_t maxRangeAge;
+};
+
+class FtmReplay {
+public:
+    static const uint16_t MAX_LINE_LENGTH = 160;
+
+    FtmReplay(FtmReplayClock clock);
+
+    void configure(const FtmReplayConfig& config);
+    void setRangeCorrection(FtmRangeCorrection correction) { scheduler.setRangeCorrection(correction); }
+    bool feedLine(const char* line);
+    const FtmReplayStats& getStats() const { return stats; }
+
+    static bool parseBssid(const char* text, uint8_t bssid[6]);
+
+private:
+    FtmReplayClock clock;
+    FtmRangingEngine engine;
+    FtmScheduler scheduler;
+    Multilateration multilateration;
+    FtmReplayStats stats;
+
+    bool solve3d;
+    float tagHeight;
+    uint32_t positionInterval;
+    uint32_t maxRangeAge;
+    uint32_t lastFix;
+
+    bool hasTruth;
+    float truth[3];
+
+    bool parseAnchor(char* fields);
+    bool parseReport(char* fields);
+    void replayReport(const FtmReport& report, uint32_t timestamp);
+    void solve(uint32_t timestamp);
+
+    static void record(FtmReplayStageStats& stage, uint32_t micros);
+};
+
+#endif
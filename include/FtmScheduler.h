@@ -0,0 +1,97 @@
+#ifndef FTM_SCHEDULER_H
+#define FTM_SCHEDULER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "FtmRangingEngine.h"
+#include "RangeFilter.h"
+#include "FtmBurstController.h"
+#include "Multilateration.h"
+
+typedef std::function<float(const uint8_t bssid[6], float distanceCm)> FtmRangeCorrection;
+
+struct FtmSchedulerConfig {
+    uint32_t requestTimeout;
+    uint32_t minInterval;
+    uint32_t maxInterval;
+    uint16_t stableThreshold;
+    RangeFilterConfig filter;
+    FtmBurstConfig burst;
+};
+
+struct FtmAnchorStats {
+    uint32_t attempts;
+    uint32_t successes;
+    uint32_t failures;
+    uint8_t consecutiveFailures;
+    uint8_t stableCount;
+    uint32_t lastRttNs;
+    uint32_t lastDistanceCm;
+    uint32_t filteredDistanceCm;
+    uint32_t rejected;
+    uint32_t lastSuccessAt;
+    float sessionsPerSecond;
+};
+
+struct FtmAnchor {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t priority;
+    bool hasPosition;
+    float x;
+    float y;
+    float z;
+    uint32_t interval;
+    uint32_t nextDue;
+    uint32_t windowStart;
+    uint32_t windowSessions;
+    FtmAnchorStats stats;
+    RangeFilter filter;
+    FtmBurstController burst;
+
+    float getSuccessRatio() const {
+        return stats.attempts == 0 ? 0.0f : static_cast<float>(stats.successes) / stats.attempts;
+    }
+};
+
+class FtmScheduler {
+public:
+    static const uint8_t MAX_ANCHORS = 16;
+    static const uint32_t RATE_WINDOW = 5000;
+    static const uint8_t STABLE_SESSIONS = 3;
+
+    FtmScheduler(FtmRangingEngine& engine);
+
+    void configure(const FtmSchedulerConfig& config);
+    bool addAnchor(const uint8_t bssid[6], uint8_t channel, uint8_t priority = 0);
+    bool removeAnchor(const uint8_t bssid[6]);
+    bool setAnchorPosition(const uint8_t bssid[6], float x, float y, float z);
+    void clearAnchors();
+    void update(uint32_t now);
+    void handleResult(FtmResult result);
+    uint8_t collectRanges(Multilateration& multilateration, uint32_t now, uint32_t maxRangeAge) const;
+
+    uint8_t getAnchorCount() const { return anchorCount; }
+    const FtmAnchor* getAnchor(uint8_t index) const { return index < anchorCount ? &anchors[index] : nullptr; }
+    const FtmAnchor* findAnchor(const uint8_t bssid[6]) const;
+    const FtmSchedulerConfig& getConfig() const { return config; }
+    void setResultCallback(FtmCallback callback) { resultCallback = callback; }
+    void setRangeCorrection(FtmRangeCorrection correction) { rangeCorrection = correction; }
+
+private:
+    FtmRangingEngine& engine;
+    FtmSchedulerConfig config;
+    FtmAnchor anchors[MAX_ANCHORS];
+    uint8_t anchorCount;
+    uint32_t inFlightRequest;
+    uint8_t cursor;
+    FtmCallback resultCallback;
+    FtmRangeCorrection rangeCorrection;
+
+    FtmAnchor* findAnchorMutable(const uint8_t bssid[6]);
+    FtmAnchor* selectNext(uint32_t now);
+    void updateRate(FtmAnchor& anchor, uint32_t now);
+    uint32_t backoff(uint8_t steps) const;
+};
+
+#endif
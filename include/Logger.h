@@ -2,8 +2,12 @@
 #define LOGGER_H
 
 #include <Arduino.h>
-#include <PubSubClient.h>
+#include <inttypes.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include "ConfigManager.h"
+#include "MPSCQueue.h"
 
 enum class LogLevel {
     DEBUG,
@@ -13,22 +17,101 @@ enum class LogLevel {
     __DELIMITER__
 };
 
+struct LogRecord {
+    static const uint16_t MESSAGE_LENGTH = 128;
+
+    uint32_t timestamp;
+    LogLevel level;
+    const char* source; // sources are string literals
+    const char* format; // set when message holds packed arguments instead of text
+    uint8_t argumentsLength;
+    bool localOnly; // kept off sinks that publish to the network
+    char message[MESSAGE_LENGTH];
+};
+
+typedef std::function<void(const LogRecord&)> LogSink;
+// Runs synchronously in the logging context, before the record is queued.
+typedef void (*LogHook)(const LogRecord& record);
+
+// printf-style logging. Calls below LOGGING_COMPILE_LEVEL are still type
+// checked but compile to nothing; the others skip formatting entirely when
+// the runtime level filters them out.
+#if LOGGING_COMPILE_LEVEL <= 0
+#define LOG_DEBUG(source, ...) Logger::getInstance().logf(LogLevel::DEBUG, source, __VA_ARGS__)
+#else
+#define LOG_DEBUG(source, ...) do { if (false) Logger::getInstance().logf(LogLevel::DEBUG, source, __VA_ARGS__); } while (0)
+#endif
+
+#if LOGGING_COMPILE_LEVEL <= 1
+#define LOG_INFO(source, ...) Logger::getInstance().logf(LogLevel::INFO, source, __VA_ARGS__)
+#else
+#define LOG_INFO(source, ...) do { if (false) Logger::getInstance().logf(LogLevel::INFO, source, __VA_ARGS__); } while (0)
+#endif
+
+#if LOGGING_COMPILE_LEVEL <= 2
+#define LOG_WARNING(source, ...) Logger::getInstance().logf(LogLevel::WARNING, source, __VA_ARGS__)
+#else
+#define LOG_WARNING(source, ...) do { if (false) Logger::getInstance().logf(LogLevel::WARNING, source, __VA_ARGS__); } while (0)
+#endif
+
+#define LOG_ERROR(source, ...) Logger::getInstance().logf(LogLevel::ERROR, source, __VA_ARGS__)
+
+// log() only copies a fixed-size record into a lock-free ring, so it is safe
+// from any task, event callback or ISR. A low-priority task drains the ring
+// into the sinks; until begin() starts it records are written synchronously.
+// The ring has a single consumer, so drain() lets only one caller in at a time.
+// With LOGGING_BINARY, logf() packs its arguments into the record and sinks
+// format them through getMessage(). The record hook sees every record before
+// it is queued, so it still captures records the drain task never gets to.
+// Records logged by the task inside setLocalOnly(true) are marked localOnly.
 class Logger {
 private:
-    Logger () 
+    static const uint16_t RECORD_QUEUE_SIZE = 32;
+    static const uint8_t MAX_SINKS = 4;
+    static const uint32_t DRAIN_TASK_STACK_SIZE = 4096;
+    static const UBaseType_t DRAIN_TASK_PRIORITY = 1;
+    static const BaseType_t DRAIN_TASK_CORE = 0;
+    static const uint32_t DRAIN_TASK_INTERVAL = 10;
+
+    Logger ()
         : configManager(ConfigManager::getInstance())
         , deviceId(configManager.getRuntimeConfig().device.name)
         , logLevel(static_cast<LogLevel>(configManager.getRuntimeConfig().logging.logLevel))
-    {}
+        , sinkCount(0)
+        , drainTask(nullptr)
+        , draining(false)
+        , localOnlyTask(nullptr)
+        , reportedDrops(0)
+        , recordHook(nullptr)
+    {
+        addSink([this](const LogRecord& record) {
+            writeSerial(record);
+        });
+        configManager.addListener(ConfigManager::sectionMask(ConfigSection::LOGGING), [this](const RuntimeConfig& previous, const RuntimeConfig& current) {
+            logLevel = static_cast<LogLevel>(current.logging.logLevel);
+        });
+    }
 
-    PubSubClient* mqttClient;
-    static const char* LOG_TOPIC_PREFIX;
     ConfigManager& configManager;
     const char* deviceId;
-    LogLevel logLevel; 
+    LogLevel logLevel;
 
-    const char* getLogLevelString(LogLevel level);
-    bool isLogLevelEnabled(LogLevel level);
+    MPSCQueue<LogRecord, RECORD_QUEUE_SIZE> records;
+    LogSink sinks[MAX_SINKS];
+    std::atomic<uint8_t> sinkCount;
+    TaskHandle_t drainTask;
+    std::atomic<bool> draining;
+    std::atomic<TaskHandle_t> localOnlyTask;
+    uint32_t reportedDrops;
+    std::atomic<LogHook> recordHook;
+
+    static void drainTaskEntry(void* parameter);
+    LogRecord* reserveRecord(LogLevel level, const char* source, uint32_t& position);
+    void commitRecord(const LogRecord& record, uint32_t position);
+    void drain();
+    void drainRecords();
+    void dispatch(const LogRecord& record);
+    void writeSerial(const LogRecord& record);
     constexpr size_t getLogLevelCount() {return static_cast<size_t>(LogLevel::__DELIMITER__);};
 
 public:
@@ -40,15 +123,27 @@ public:
         return instance;
     }
 
+    bool begin();
+    bool addSink(LogSink sink);
+    void setRecordHook(LogHook hook) { recordHook.store(hook, std::memory_order_release); }
+    void setLocalOnly(bool enabled) { localOnlyTask.store(enabled ? xTaskGetCurrentTaskHandle() : nullptr, std::memory_order_relaxed); }
+    void flush(uint32_t timeout = 100);
+
     void log(LogLevel level, const char* source, const char* message);
+    void logf(LogLevel level, const char* source, const char* format, ...) __attribute__((format(printf, 4, 5)));
     void info(const char* source, const char* message);
     void warning(const char* source, const char* message);
     void error(const char* source, const char* message);
     void debug(const char* source, const char* message);
     void setLogLevel(LogLevel level) { logLevel = level; };
+    bool isLogLevelEnabled(LogLevel level);
 
     LogLevel getLogLevel() { return logLevel; };
     const char* getLogLevelString() { return getLogLevelString(logLevel); };
+    static const char* getLogLevelString(LogLevel level);
+    static const char* getMessage(const LogRecord& record, char* buffer, size_t size);
+    uint32_t getDroppedRecords() { return records.getOverruns(); }
+    uint16_t getPendingRecords() { return records.getCount(); }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,79 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free bounded multi-producer/single-consumer ring. Every slot carries a
+// sequence number: producers claim a position with a CAS on head, fill the
+// slot in place and publish it by advancing the slot's sequence, so neither
+// side ever blocks and producers may run in ISRs. A producer interrupted
+// between reserve() and commit() only delays the consumer, never corrupts it.
+template <typename T, uint16_t SIZE>
+class MPSCQueue {
+    static_assert((SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+
+public:
+    MPSCQueue() : head(0), tail(0), overruns(0) {
+        for (uint16_t i = 0; i < SIZE; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    T* reserve(uint32_t& position) {
+        uint32_t current = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[current & (SIZE - 1)];
+            int32_t difference = static_cast<int32_t>(slot.sequence.load(std::memory_order_acquire) - current);
+
+            if (difference == 0) {
+                if (head.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+                    position = current;
+                    return &slot.item;
+                }
+            } else if (difference < 0) {
+                overruns.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            } else {
+                current = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void commit(uint32_t position) {
+        slots[position & (SIZE - 1)].sequence.store(position + 1, std::memory_order_release);
+    }
+
+    T* front() {
+        uint32_t current = tail.load(std::memory_order_relaxed);
+        Slot& slot = slots[current & (SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != current + 1) {
+            return nullptr;
+        }
+        return &slot.item;
+    }
+
+    void pop() {
+        uint32_t current = tail.load(std::memory_order_relaxed);
+        slots[current & (SIZE - 1)].sequence.store(current + SIZE, std::memory_order_release);
+        tail.store(current + 1, std::memory_order_release);
+    }
+
+    uint16_t getCount() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    uint32_t getOverruns() const { return overruns.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        T item;
+    };
+
+    Slot slots[SIZE];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> overruns;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef MQTT_ACK_CLIENT_H
+#define MQTT_ACK_CLIENT_H
+
+#include <Client.h>
+#include "MQTTOutboundQueue.h"
+#include "SPSCQueue.h"
+
+// Transparent Client wrapper that follows the inbound MQTT packet framing
+// while PubSubClient reads it and records the packet ids of PUBACKs, which
+// PubSubClient itself discards. writePublish() covers the other direction,
+// since PubSubClient cannot send QoS 1 PUBLISH packets.
+class MQTTAckClient : public Client {
+public:
+    static const uint8_t ACK_QUEUE_SIZE = 16;
+
+    MQTTAckClient(Client& client);
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t value) override { return client.write(value); }
+    size_t write(const uint8_t* buffer, size_t size) override { return client.write(buffer, size); }
+    int available() override { return client.available(); }
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int peek() override { return client.peek(); }
+    void flush() override { client.flush(); }
+    void stop() override;
+    uint8_t connected() override { return client.connected(); }
+    operator bool() override { return static_cast<bool>(client); }
+
+    bool writePublish(const MQTTQueuedMessage& message);
+    bool popAck(uint16_t& packetId);
+    uint32_t getOverruns() const { return acks.getOverruns(); }
+
+private:
+    enum class ParseState {
+        HEADER,
+        LENGTH,
+        BODY,
+        __DELIMITER__
+    };
+
+    Client& client;
+    ParseState state;
+    uint8_t packetType;
+    uint32_t remaining;
+    uint8_t lengthShift;
+    uint16_t packetId;
+    uint8_t bodyRead;
+
+    SPSCQueue<uint16_t, ACK_QUEUE_SIZE> acks;
+
+    void reset();
+    void consume(uint8_t value);
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef MQTT_BENCHMARK_H
+#define MQTT_BENCHMARK_H
+
+#include <Arduino.h>
+#include "Logger.h"
+#include "MQTTManager.h"
+
+class MQTTBenchmark;
+typedef std::function<void(const MQTTBenchmark&)> MQTTBenchmarkCallback;
+
+enum class MQTTBenchmarkPhase {
+    IDLE,
+    PUBLISHING,
+    SETTLING,
+    __DELIMITER__
+};
+
+struct MQTTBenchmarkRun {
+    uint16_t payloadSize;
+    uint16_t sent;
+    uint16_t received;
+    uint16_t duplicates;
+    uint16_t stalls;
+    uint32_t publishMicros;
+    uint32_t durationMicros;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t max;
+};
+
+// Publishes numbered messages to <deviceTopic>/bench and times them until they
+// come back through the broker and the inbound dispatch, one run per payload
+// size. publishMicros is the application-side cost of publish().
+class MQTTBenchmark {
+public:
+    static const uint8_t MAX_RUNS = 4;
+    static const uint16_t MAX_MESSAGES = 100;
+    static const uint16_t HEADER_SIZE = 8;
+
+    MQTTBenchmark()
+        : phase(MQTTBenchmarkPhase::IDLE)
+        , runCount(0)
+        , runIndex(0)
+        , runId(0)
+        , topic(MQTTManager::INVALID_TOPIC)
+        , subscribed(false)
+        , mqttManager(MQTTManager::getInstance())
+        , log(Logger::getInstance()) {}
+
+    bool start(const uint16_t* sizes, uint8_t sizeCount, uint16_t count, uint8_t window, uint8_t qos, MQTTBenchmarkCallback callback);
+    void update();
+    bool isRunning() const { return phase != MQTTBenchmarkPhase::IDLE; }
+
+    uint8_t getRunCount() const { return runCount; }
+    const MQTTBenchmarkRun& getRun(uint8_t index) const { return runs[index]; }
+    uint8_t getQos() const { return qos; }
+
+private:
+    static const uint32_t SETTLE_TIMEOUT = 3000000;
+
+    MQTTBenchmarkPhase phase;
+    MQTTBenchmarkRun runs[MAX_RUNS];
+    uint8_t runCount;
+    uint8_t runIndex;
+    uint16_t runId;
+    uint16_t count;
+    uint8_t window;
+    uint8_t qos;
+    MQTTBenchmarkCallback callback;
+
+    MQTTTopicHandle topic;
+    bool subscribed;
+    uint32_t runStartedAt;
+    uint32_t lastActivity;
+    uint32_t latencies[MAX_MESSAGES];
+    uint32_t receivedMask[(MAX_MESSAGES + 31) / 32];
+    char payload[MQTTOutboundQueue::MAX_PAYLOAD_LENGTH];
+
+    MQTTManager& mqttManager;
+    Logger& log;
+
+    void startRun();
+    void finishRun();
+    void receive(const uint8_t* payload, unsigned int length);
+};
+
+#endif
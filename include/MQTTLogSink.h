@@ -0,0 +1,77 @@
+#ifndef MQTT_LOG_SINK_H
+#define MQTT_LOG_SINK_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "ConfigManager.h"
+#include "Logger.h"
+#include "MQTTManager.h"
+#include "SPSCQueue.h"
+#include "TripleBuffer.h"
+
+// Forwards log records to MQTT. The Logger drain task only hands records over
+// through a ring; batching and publishing happen in update() on the
+// application side, which owns the MQTTManager command queue. Each batch is a
+// JSON array of [timestamp, level, source, message] rows.
+struct MQTTLogFilter {
+    bool enabled;
+    uint8_t level;
+};
+
+class MQTTLogSink {
+private:
+    static const uint8_t RECORD_QUEUE_SIZE = 16;
+    static const uint16_t MAX_BATCH_LENGTH = MQTTOutboundQueue::MAX_PAYLOAD_LENGTH;
+
+    MQTTLogSink()
+        : initialized(false)
+        , filter(MQTTLogFilter{false, 0})
+        , topic(MQTTManager::INVALID_TOPIC)
+        , batchLength(0)
+        , batchCount(0)
+        , batchStartedAt(0)
+        , tokens(0)
+        , lastRefill(0)
+        , dropped(0)
+        , configManager(ConfigManager::getInstance())
+        , mqttManager(MQTTManager::getInstance())
+        , log(Logger::getInstance()) {}
+
+    bool initialized;
+    SPSCQueue<LogRecord, RECORD_QUEUE_SIZE> records;
+    // Read by enqueue() on the drain task, never from RuntimeConfig.
+    TripleBuffer<MQTTLogFilter> filter;
+    MQTTTopicHandle topic;
+    char batch[MAX_BATCH_LENGTH + 1];
+    uint16_t batchLength;
+    uint8_t batchCount;
+    uint32_t batchStartedAt;
+    uint32_t tokens;
+    uint32_t lastRefill;
+    uint32_t dropped;
+
+    ConfigManager& configManager;
+    MQTTManager& mqttManager;
+    Logger& log;
+
+    void applyFilter(const RuntimeConfig& config);
+    void enqueue(const LogRecord& record);
+    bool append(const LogRecord& record, uint32_t now);
+    void flush(uint32_t now);
+    bool consumeTokens(uint16_t length, uint32_t now);
+
+public:
+    MQTTLogSink(const MQTTLogSink&) = delete;
+    void operator=(const MQTTLogSink&) = delete;
+
+    static MQTTLogSink& getInstance() {
+        static MQTTLogSink instance;
+        return instance;
+    }
+
+    bool begin();
+    void update();
+    uint32_t getDroppedRecords() { return records.getOverruns() + dropped; }
+};
+
+#endif
@@ -2,25 +2,113 @@
 #define MQTT_MANAGER_H
 
 #include <PubSubClient.h>
+#include <WiFi.h>
 #include <WiFiClient.h>
-#include <map>
-#include <vector>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include "ConfigManager.h"
 #include "Logger.h"
+#include "MQTTOutboundQueue.h"
+#include "MQTTTopicTrie.h"
+#include "MQTTAckClient.h"
+#include "SPSCQueue.h"
 
-typedef std::function<void(char*, uint8_t*, unsigned int)> MQTTCallback;
+// Topic and payload are only valid for the duration of the callback; the
+// payload is not NUL-terminated.
+typedef std::function<void(const char*, const uint8_t*, unsigned int)> MQTTCallback;
+typedef uint8_t MQTTTopicHandle;
 
 struct Subscription {
     String topic;
     MQTTCallback callback;
+    bool active = false;
 };
 
+struct MQTTTopicEntry {
+    char topic[MQTTOutboundQueue::MAX_TOPIC_LENGTH + 1];
+    uint8_t length;
+};
+
+enum class MQTTCommandType {
+    PUBLISH,
+    SUBSCRIBE,
+    UNSUBSCRIBE,
+    DISCONNECT,
+    CONFIGURE,
+    __DELIMITER__
+};
+
+// Copy of the MQTT section owned by the network task. Changes arrive as a
+// CONFIGURE command, so the task never reads RuntimeConfig while a config
+// patch is being swapped in on the application side.
+struct MQTTNetworkSettings {
+    char broker[sizeof(RuntimeConfig::mqtt.broker)];
+    uint16_t port;
+    char user[sizeof(RuntimeConfig::mqtt.user)];
+    char password[sizeof(RuntimeConfig::mqtt.password)];
+    uint32_t retryInterval;
+    uint8_t drainBudget;
+    uint8_t inflightWindow;
+    bool persistentSession;
+};
+
+struct MQTTCommand {
+    MQTTCommandType type;
+    const char* topic;
+    char topicBuffer[MQTTOutboundQueue::MAX_TOPIC_LENGTH + 1];
+    uint8_t topicLength;
+    union {
+        char payload[MQTTOutboundQueue::MAX_PAYLOAD_LENGTH + 1];
+        MQTTNetworkSettings settings;
+    };
+    uint16_t length;
+    bool retained;
+    MQTTPriority priority;
+    uint8_t qos;
+};
+
+struct MQTTInboundMessage {
+    char topic[MQTTOutboundQueue::MAX_TOPIC_LENGTH + 1];
+    uint8_t payload[MQTTOutboundQueue::MAX_PAYLOAD_LENGTH + 1];
+    uint16_t length;
+};
+
+// The socket, PubSubClient and the outbound queue belong to a network task
+// pinned to the protocol core. The application side only talks to it through
+// the command and inbound rings, so a stalled socket never blocks the state
+// machine and keepalive continues during long operations.
 class MQTTManager {
 private:
+    static const uint8_t MAX_SUBSCRIPTIONS = 16;
+    static const uint8_t MAX_TOPICS = 16;
+    static const uint16_t FIRST_PACKET_ID = 0x8000; // clear of PubSubClient's SUBSCRIBE ids
+    // A full outbound queue's worth of publishes plus control commands, so
+    // bursts reach the outbound queue and its priority eviction instead of
+    // being dropped here. The ring keeps one slot empty.
+    static const uint8_t COMMAND_QUEUE_HEADROOM = 8;
+    static const uint8_t COMMAND_QUEUE_SIZE = MQTTOutboundQueue::CAPACITY + COMMAND_QUEUE_HEADROOM + 1;
+    static const uint8_t INBOUND_QUEUE_SIZE = 8;
+    // Callbacks run on the application loop and may be RPCs, so a burst is
+    // dispatched over several update() calls.
+    static const uint8_t INBOUND_DISPATCH_BUDGET = 4;
+    static const uint32_t NETWORK_TASK_STACK_SIZE = 6144;
+    static const UBaseType_t NETWORK_TASK_PRIORITY = 2;
+    static const BaseType_t NETWORK_TASK_CORE = 0;
+    static const uint32_t NETWORK_TASK_INTERVAL = 5;
+
     MQTTManager() 
-        : client(espClient)
+        : ackClient(espClient)
+        , client(ackClient)
         , initialized(false)
         , lastAttempt(0)
+        , connectionAttempts(0)
+        , connected(false)
+        , topicCount(0)
+        , nextPacketId(FIRST_PACKET_ID)
+        , networkTask(nullptr)
+        , filterCount(0)
+        , inboundDropped(0)
         , log(Logger::getInstance())
         , configManager(ConfigManager::getInstance()) {}
 
@@ -28,19 +116,52 @@ private:
     ConfigManager& configManager;
 
     WiFiClient espClient;
+    MQTTAckClient ackClient;
     PubSubClient client;
     bool initialized;
     uint32_t lastAttempt;
-    uint8_t connectionAttempts;
-    std::vector<Subscription> subscriptions;
+    std::atomic<uint8_t> connectionAttempts;
+    std::atomic<bool> connected;
+    Subscription subscriptions[MAX_SUBSCRIPTIONS];
+    MQTTTopicTrie topicTrie;
     char deviceTopic[128];
     char clientId[64];
+    MQTTOutboundQueue outboundQueue;
+    MQTTTopicEntry topics[MAX_TOPICS];
+    uint8_t topicCount;
+    uint16_t nextPacketId;
+
+    TaskHandle_t networkTask;
+    MQTTNetworkSettings networkSettings;
+    SPSCQueue<MQTTCommand, COMMAND_QUEUE_SIZE> commandQueue;
+    SPSCQueue<MQTTInboundMessage, INBOUND_QUEUE_SIZE> inboundQueue;
+    char filters[MAX_SUBSCRIPTIONS][MQTTOutboundQueue::MAX_TOPIC_LENGTH + 1];
+    uint8_t filterCount;
+    std::atomic<uint32_t> inboundDropped;
 
-    void handleCallback(char* topic, uint8_t* payload, uint32_t length);
-    bool matchTopic(const char* pattern, const char* topic);
+    // Application side
+    void handleCallback(const char* topic, const uint8_t* payload, uint32_t length);
+    int8_t findSubscription(const char* topic);
     void initializeDeviceTopic();
+    MQTTCommand* reserveCommand(MQTTCommandType type);
+    bool pushTopicCommand(MQTTCommandType type, const char* topic);
+    static void getNetworkSettings(const RuntimeConfig& config, MQTTNetworkSettings& settings);
+
+    // Network task
+    static void networkTaskEntry(void* parameter);
+    void networkLoop();
+    bool connect();
+    void receive(const char* topic, const uint8_t* payload, uint32_t length);
+    void processCommands();
+    void applySettings(const MQTTNetworkSettings& settings);
+    void addFilter(const char* topic);
+    void removeFilter(const char* topic);
+    void drainQueue();
+    uint16_t allocatePacketId();
 
 public:
+    static const MQTTTopicHandle INVALID_TOPIC = UINT8_MAX;
+
     MQTTManager(const MQTTManager&) = delete;
     void operator=(const MQTTManager&) = delete;
 
@@ -50,15 +171,20 @@ public:
     }
 
     bool begin();
-    bool connect();
     void disconnect();
     bool subscribe(const char* topic, MQTTCallback callback);
     bool unsubscribe(const char* topic);
-    bool publish(const char* topic, const char* payload, bool retained = false, bool isAbsoluteTopic = false);
+    MQTTTopicHandle registerTopic(const char* topic, bool isAbsoluteTopic = false);
+    bool publish(MQTTTopicHandle topic, const char* payload, size_t length, bool retained = false, MQTTPriority priority = MQTTPriority::NORMAL, uint8_t qos = 0);
+    bool publish(const char* topic, const char* payload, bool retained = false, bool isAbsoluteTopic = false, MQTTPriority priority = MQTTPriority::NORMAL, uint8_t qos = 0);
     void update();
-    bool isConnected();
+    bool isConnected() { return connected.load(); }
+    bool isInitialized() { return initialized; }
+    uint8_t getConnectionAttempts() { return connectionAttempts.load(); }
+    const MQTTQueueStats& getQueueStats() { return outboundQueue.getStats(); }
+    uint32_t getCommandOverruns() { return commandQueue.getOverruns(); }
+    uint32_t getInboundDropped() { return inboundDropped.load() + inboundQueue.getOverruns(); }
 
-    PubSubClient& getClient() { return client; }
     const char* getClientId() { return clientId; }
     const char* getDeviceTopic() { return deviceTopic; }
 };
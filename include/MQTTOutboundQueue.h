@@ -0,0 +1,91 @@
+#ifndef MQTT_OUTBOUND_QUEUE_H
+#define MQTT_OUTBOUND_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+enum class MQTTPriority {
+    BACKGROUND,
+    NORMAL,
+    CRITICAL,
+    __DELIMITER__
+};
+
+struct MQTTQueuedMessage {
+    const char* topic;
+    char topicBuffer[128];
+    uint8_t topicLength;
+    char payload[512];
+    uint16_t length;
+    bool retained;
+    MQTTPriority priority;
+    uint8_t qos;
+    uint16_t packetId;
+    bool inFlight;
+    bool duplicate;
+    uint32_t queuedAt;
+    uint32_t sentAt;
+};
+
+struct MQTTQueueStats {
+    uint8_t depth;
+    uint8_t highWater;
+    uint32_t enqueued;
+    uint32_t sent;
+    uint32_t failed;
+    uint32_t dropped;
+    uint32_t rejected;
+    uint32_t acknowledged;
+    uint32_t retransmits;
+    uint8_t inFlight;
+    float drainRate;
+};
+
+// Fixed pool of message slots plus an ordering array; nothing is allocated
+// after construction. When full, the oldest message of the lowest priority is
+// evicted, or the new one is dropped if everything queued outranks it.
+// QoS 1 messages stay in their slot while in flight until acknowledge() and
+// are never evicted in that state.
+class MQTTOutboundQueue {
+public:
+    static const uint8_t CAPACITY = 16;
+    static const uint16_t MAX_TOPIC_LENGTH = sizeof(MQTTQueuedMessage::topicBuffer) - 1;
+    static const uint16_t MAX_PAYLOAD_LENGTH = sizeof(MQTTQueuedMessage::payload) - 1;
+    static const uint32_t RATE_WINDOW = 5000;
+
+    MQTTOutboundQueue();
+
+    // Interned topics must outlive the queue and are referenced, not copied.
+    bool push(const char* topic, size_t topicLength, bool interned, const char* payload, size_t length, bool retained, MQTTPriority priority, uint8_t qos, uint32_t now);
+    // Holds back a QoS 1 message while inflightWindow messages await their
+    // PUBACK; later messages wait behind it to keep publish order.
+    MQTTQueuedMessage* next(uint8_t inflightWindow = UINT8_MAX);
+    void markInFlight(MQTTQueuedMessage* message, uint16_t packetId, uint32_t now);
+    void complete(const MQTTQueuedMessage* message, bool sent, uint32_t now);
+    bool acknowledge(uint16_t packetId, uint32_t now);
+    void requeueInFlight();
+    void clear();
+
+    uint8_t getCount() const { return count; }
+    uint8_t getInFlightCount() const { return stats.inFlight; }
+    bool isEmpty() const { return count == 0; }
+    const MQTTQueueStats& getStats() const { return stats; }
+
+private:
+    MQTTQueuedMessage slots[CAPACITY];
+    uint8_t order[CAPACITY];
+    uint8_t freeSlots[CAPACITY];
+    uint8_t count;
+    uint8_t freeCount;
+    MQTTQueueStats stats;
+    uint32_t windowStart;
+    uint32_t windowSent;
+
+    bool evict(MQTTPriority priority);
+    uint8_t find(const MQTTQueuedMessage* message) const;
+    void remove(uint8_t position);
+    void updateRate(uint32_t now);
+};
+
+#endif
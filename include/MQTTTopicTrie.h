@@ -0,0 +1,125 @@
+#ifndef MQTT_TOPIC_TRIE_H
+#define MQTT_TOPIC_TRIE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Pool sizes, overridable from build flags; MAX_NODES must be a power of two.
+#ifndef MQTT_TOPIC_TRIE_MAX_NODES
+#define MQTT_TOPIC_TRIE_MAX_NODES 64
+#endif
+#ifndef MQTT_TOPIC_TRIE_MAX_ENTRIES
+#define MQTT_TOPIC_TRIE_MAX_ENTRIES 32
+#endif
+#ifndef MQTT_TOPIC_TRIE_NAME_ARENA_SIZE
+#define MQTT_TOPIC_TRIE_NAME_ARENA_SIZE 1024
+#endif
+
+// Subscription filters compiled into a tree of topic levels. Each node keeps a
+// list of handler ids, and literal children are found through one hash table
+// keyed by (parent, level), so dispatch costs O(levels) instead of matching
+// every filter. '+' matches exactly one level, '#' matches the parent level
+// and everything below it, and wildcards at the root skip '$' topics.
+class MQTTTopicTrie {
+public:
+    static const uint16_t MAX_NODES = MQTT_TOPIC_TRIE_MAX_NODES;
+    static const uint16_t CHILD_TABLE_SIZE = MAX_NODES * 2;
+    static const uint16_t MAX_ENTRIES = MQTT_TOPIC_TRIE_MAX_ENTRIES;
+    static const uint16_t NAME_ARENA_SIZE = MQTT_TOPIC_TRIE_NAME_ARENA_SIZE;
+    static const uint8_t MAX_DEPTH = 16;
+    static const uint16_t NONE = 0xFFFF;
+    static_assert((MAX_NODES & (MAX_NODES - 1)) == 0 && MAX_NODES < NONE, "MAX_NODES must be a power of two");
+
+    MQTTTopicTrie() { clear(); }
+
+    bool insert(const char* filter, uint8_t handler);
+    bool remove(const char* filter, uint8_t handler);
+    void clear();
+
+    template <typename Visitor>
+    uint16_t match(const char* topic, Visitor&& visit) const {
+        const char* levels[MAX_DEPTH];
+        uint8_t lengths[MAX_DEPTH];
+        uint8_t depth = split(topic, levels, lengths);
+        if (depth == 0) {
+            return 0;
+        }
+
+        bool system = topic[0] == '$';
+        return matchNode(0, levels, lengths, depth, 0, system, visit);
+    }
+
+    uint16_t getNodeCount() const { return nodeCount; }
+    uint16_t getEntryCount() const { return entryCount; }
+
+private:
+    struct Node {
+        uint16_t name;
+        uint8_t length;
+        uint32_t hash;
+        uint16_t parent;
+        uint16_t plusChild;
+        uint16_t hashChild;
+        uint16_t firstEntry;
+    };
+
+    struct Entry {
+        uint8_t handler;
+        uint16_t next;
+    };
+
+    Node nodes[MAX_NODES];
+    Entry entries[MAX_ENTRIES];
+    uint16_t children[CHILD_TABLE_SIZE];
+    char names[NAME_ARENA_SIZE];
+    uint16_t nodeCount;
+    uint16_t entryCount;
+    uint16_t freeEntry;
+    uint16_t nameLength;
+
+    uint16_t findChild(uint16_t parent, const char* level, uint8_t length, uint32_t hash) const;
+    uint16_t findOrCreateChild(uint16_t parent, const char* level, uint8_t length);
+    uint16_t createNode(uint16_t parent, const char* level, uint8_t length, uint32_t hash);
+    static uint16_t getSlot(uint16_t parent, uint32_t hash) { return (hash ^ (parent * 2654435761u)) & (CHILD_TABLE_SIZE - 1); }
+
+    static uint8_t split(const char* topic, const char* levels[], uint8_t lengths[]);
+    static uint32_t hashLevel(const char* level, uint8_t length);
+
+    template <typename Visitor>
+    uint16_t visitEntries(uint16_t node, Visitor& visit) const {
+        uint16_t count = 0;
+        for (uint16_t entry = nodes[node].firstEntry; entry != NONE; entry = entries[entry].next) {
+            visit(entries[entry].handler);
+            count++;
+        }
+        return count;
+    }
+
+    template <typename Visitor>
+    uint16_t matchNode(uint16_t node, const char* levels[], const uint8_t lengths[], uint8_t depth, uint8_t level, bool system, Visitor& visit) const {
+        const Node& current = nodes[node];
+        bool wildcardAllowed = !(system && level == 0);
+        uint16_t count = 0;
+
+        if (current.hashChild != NONE && wildcardAllowed) {
+            count += visitEntries(current.hashChild, visit);
+        }
+
+        if (level == depth) {
+            return count + visitEntries(node, visit);
+        }
+
+        if (current.plusChild != NONE && wildcardAllowed) {
+            count += matchNode(current.plusChild, levels, lengths, depth, level + 1, system, visit);
+        }
+
+        uint16_t child = findChild(node, levels[level], lengths[level], hashLevel(levels[level], lengths[level]));
+        if (child != NONE) {
+            count += matchNode(child, levels, lengths, depth, level + 1, system, visit);
+        }
+        return count;
+    }
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef MULTILATERATION_H
+#define MULTILATERATION_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+struct PositionFix {
+    float x;
+    float y;
+    float z;
+    float residual;
+    float covariance[3][3];
+    uint8_t anchorCount;
+    uint8_t iterations;
+    bool converged;
+};
+
+class Multilateration {
+public:
+    static const uint8_t MAX_ANCHORS = 16;
+    static const uint8_t MAX_ITERATIONS = 12;
+
+    Multilateration() : count(0), height(0.0f) {}
+
+    void clear() { count = 0; }
+    bool addRange(float x, float y, float z, float range);
+    uint8_t getRangeCount() const { return count; }
+    void setHeight(float z) { height = z; }
+
+    bool solve(PositionFix& fix, bool solve3d = false) const;
+
+private:
+    struct Range {
+        float x;
+        float y;
+        float z;
+        float range;
+    };
+
+    Range ranges[MAX_ANCHORS];
+    uint8_t count;
+    float height;
+
+    void initialGuess(float position[3]) const;
+    float buildNormalEquations(const float position[3], uint8_t dimensions, float jtj[3][3], float jtr[3]) const;
+    static bool invert(const float matrix[3][3], uint8_t dimensions, float inverse[3][3]);
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef RPC_MANAGER_H
+#define RPC_MANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "ConfigManager.h"
+#include "Logger.h"
+#include "MQTTManager.h"
+#include "WiFiManager.h"
+#include "MQTTBenchmark.h"
+
+enum class RPCStatus {
+    OK,
+    ERROR,
+    PENDING,
+    __DELIMITER__
+};
+
+// INLINE handlers run in the application loop and must either finish at once
+// or return PENDING and call complete() from a later callback. WORKER
+// handlers may block and run one at a time on the RPC worker task.
+enum class RPCExecution {
+    INLINE,
+    WORKER,
+    __DELIMITER__
+};
+
+enum class RPCRequestState {
+    FREE,
+    QUEUED,
+    RUNNING,
+    DONE,
+    __DELIMITER__
+};
+
+struct RPCRequest {
+    static const uint16_t MAX_ID_LENGTH = 40;
+    static const uint16_t MAX_PARAMS_LENGTH = 256;
+    static const uint16_t MAX_RESULT_LENGTH = 320;
+
+    std::atomic<RPCRequestState> state;
+    uint32_t sequence;
+    uint8_t command;
+    char id[MAX_ID_LENGTH + 1]; // serialized JSON, echoed verbatim
+    char params[MAX_PARAMS_LENGTH + 1];
+    char result[MAX_RESULT_LENGTH + 1];
+    bool success;
+    uint32_t receivedAt;
+    uint32_t startedAt;
+    uint32_t completedAt;
+};
+
+typedef std::function<RPCStatus(RPCRequest& request, JsonObjectConst params, JsonObject result)> RPCHandler;
+// Runs in the application loop right before a WORKER request is handed to
+// the worker, to snapshot state the handler must not read from another task.
+typedef std::function<void(RPCRequest& request)> RPCPrepare;
+
+struct RPCCommandStats {
+    uint32_t calls;
+    uint32_t failures;
+    uint32_t totalMicros;
+    uint32_t maxMicros;
+};
+
+struct RPCCommand {
+    const char* name;
+    RPCExecution execution;
+    RPCHandler handler;
+    RPCPrepare prepare;
+    RPCCommandStats stats;
+};
+
+// Command requests arrive on <deviceTopic>/rpc/req as
+// {"id": ..., "cmd": "...", "params": {...}} and are answered on
+// <deviceTopic>/rpc/res with the same id, the result and execution times.
+class RPCManager {
+public:
+    static const uint8_t MAX_COMMANDS = 16;
+    static const uint8_t MAX_REQUESTS = 4;
+
+private:
+    static const uint16_t REQUEST_DOC_SIZE = 1024;
+    static const uint16_t RESULT_DOC_SIZE = 768;
+    static const uint16_t RESPONSE_DOC_SIZE = 512;
+    static const uint32_t REQUEST_TIMEOUT = 15000;
+    static const uint32_t REBOOT_DELAY = 1000;
+    static const uint32_t WORKER_TASK_STACK_SIZE = 12288; // replay keeps a ~4 KB FtmReplay on it
+    static const UBaseType_t WORKER_TASK_PRIORITY = 1;
+    static const BaseType_t WORKER_TASK_CORE = 1;
+
+    RPCManager()
+        : initialized(false)
+        , commandCount(0)
+        , nextSequence(1)
+        , responseTopic(MQTTManager::INVALID_TOPIC)
+        , workerTask(nullptr)
+        , workerBusy(false)
+        , rebootAt(0)
+        , log(Logger::getInstance())
+        , configManager(ConfigManager::getInstance())
+        , mqttManager(MQTTManager::getInstance())
+        , wifiManager(WiFiManager::getInstance()) {}
+
+    bool initialized;
+    RPCCommand commands[MAX_COMMANDS];
+    uint8_t commandCount;
+    RPCRequest requests[MAX_REQUESTS];
+    uint32_t nextSequence;
+    MQTTTopicHandle responseTopic;
+    TaskHandle_t workerTask;
+    std::atomic<bool> workerBusy;
+    uint32_t rebootAt;
+    MQTTBenchmark benchmark;
+    FtmReplayConfig replayConfig;
+
+    Logger& log;
+    ConfigManager& configManager;
+    MQTTManager& mqttManager;
+    WiFiManager& wifiManager;
+
+    void registerDefaultCommands();
+    void handleRequest(const uint8_t* payload, unsigned int length);
+    int8_t findCommand(const char* name);
+    RPCRequest* allocateRequest();
+    void execute(RPCRequest& request);
+    void finish(RPCRequest& request, bool success, const JsonDocument& result);
+    void respond(RPCRequest& request);
+    void respondError(const char* id, const char* command, const char* error);
+    void checkTimeouts();
+
+    static void workerTaskEntry(void* parameter);
+
+    RPCStatus rangeNow(RPCRequest& request, JsonObjectConst params, JsonObject result);
+    RPCStatus scan(RPCRequest& request, JsonObjectConst params, JsonObject result);
+    RPCStatus setLogLevel(RPCRequest& request, JsonObjectConst params, JsonObject result);
+    RPCStatus reboot(RPCRequest& request, JsonObjectConst params, JsonObject result);
+    RPCStatus calibrate(RPCRequest& request, JsonObjectConst params, JsonObject result);
+    RPCStatus replay(RPCRequest& request, JsonObjectConst params, JsonObject result);
+    RPCStatus stats(RPCRequest& request, JsonObjectConst params, JsonObject result);
+    RPCStatus bench(RPCRequest& request, JsonObjectConst params, JsonObject result);
+
+public:
+    RPCManager(const RPCManager&) = delete;
+    void operator=(const RPCManager&) = delete;
+
+    static RPCManager& getInstance() {
+        static RPCManager instance;
+        return instance;
+    }
+
+    bool begin();
+    void update();
+    bool registerCommand(const char* name, RPCExecution execution, RPCHandler handler, RPCPrepare prepare = nullptr);
+    bool complete(uint32_t sequence, bool success, const JsonDocument& result);
+
+    uint8_t getCommandCount() { return commandCount; }
+    const RPCCommand* getCommand(uint8_t index) { return index < commandCount ? &commands[index] : nullptr; }
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef RANGE_FILTER_H
+#define RANGE_FILTER_H
+
+#include <stdint.h>
+
+struct RangeFilterConfig {
+    uint8_t stages;
+    uint16_t gateThreshold;
+    uint8_t gateMaxRejects;
+    uint8_t medianWindow;
+    float processNoise;
+    float measurementNoise;
+};
+
+class RangeFilter {
+public:
+    static const uint8_t STAGE_GATE = 0x01;
+    static const uint8_t STAGE_MEDIAN = 0x02;
+    static const uint8_t STAGE_KALMAN = 0x04;
+    static const uint8_t MAX_MEDIAN_WINDOW = 9;
+
+    RangeFilter() { reset(); }
+
+    void reset();
+    bool update(float distance, uint32_t now, const RangeFilterConfig& config, float& filtered);
+
+    float getEstimate() const { return estimate; }
+    float getVariance() const { return variance; }
+    uint32_t getRejectedCount() const { return rejected; }
+
+private:
+    float window[MAX_MEDIAN_WINDOW];
+    uint8_t windowHead;
+    uint8_t windowCount;
+
+    float estimate;
+    float variance;
+    uint32_t lastUpdate;
+    bool initialized;
+
+    uint8_t consecutiveRejects;
+    uint32_t rejected;
+
+    bool gate(float distance, const RangeFilterConfig& config);
+    float median(float distance, uint8_t size);
+    float kalman(float distance, uint32_t now, const RangeFilterConfig& config);
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include <stdint.h>
+
+struct RuntimeConfig {
+    struct {
+        char name[32];
+        char firmwareVersion[16];
+        uint64_t chipID;
+        char macAddress[18];
+        uint32_t statusUpdateInterval;
+        uint8_t statusFormat;
+        uint8_t statusKeyframeInterval;
+        uint8_t statusRssiThreshold;
+        uint32_t statusHeapThreshold;
+    } device;
+
+    struct {
+        char ssid[32];
+        char password[64];
+        bool autoReconnect;
+        uint8_t maxConnectionAttempts;
+        uint32_t reconnectInterval;
+        uint32_t checkInterval;
+    } wifi;
+
+    struct {
+        char broker[64];
+        uint16_t port;
+        char user[32];
+        char password[64];
+        uint32_t retryInterval;
+        char baseTopic[64];
+        uint8_t maxConnectionAttempts;
+        uint8_t drainBudget;
+        uint8_t inflightWindow;
+        bool persistentSession;
+    } mqtt;
+    
+    struct {
+        uint16_t maxMsPerChannel;
+        uint32_t interval;
+        uint32_t cacheTtl;
+        bool autoAddAnchors;
+    } scan;
+
+    struct {
+        uint8_t frameCount;
+        uint16_t burstPeriod;
+        uint32_t requestTimeout;
+        uint8_t estimator;
+        uint8_t estimatorParam;
+        uint32_t minInterval;
+        uint32_t maxInterval;
+        uint16_t stableThreshold;
+        bool adaptiveBurst;
+        uint16_t burstLowDeviation;
+        uint16_t burstHighDeviation;
+        uint8_t maxBurstPeriod;
+        uint32_t metricsInterval;
+        bool recordReports;
+        uint8_t filterStages;
+        uint16_t filterGateThreshold;
+        uint8_t filterGateMaxRejects;
+        uint8_t filterMedianWindow;
+        float filterProcessNoise;
+        float filterMeasurementNoise;
+    } ftm;
+
+    struct {
+        char ssid[32];
+        char password[64];
+        uint8_t channel;
+        uint8_t maxClients;
+        float x;
+        float y;
+        float z;
+    } anchor;
+
+    struct {
+        uint32_t interval;
+        uint32_t maxRangeAge;
+        bool solve3d;
+        float tagHeight;
+    } position;
+
+    struct {
+        uint8_t maxRecoveryAttempts;
+        uint32_t recoveryInterval;
+    } error;
+
+    struct {
+        bool allowMqttLog;
+        char mqttTopic[64];
+        uint8_t logLevel;
+        uint8_t mqttLevel;
+        uint8_t mqttBatchSize;
+        uint32_t mqttBatchInterval;
+        uint32_t mqttRateLimit;
+    } logging;
+
+    struct {
+        char apiUrl[128];
+        char apiToken[128];
+        uint32_t interval;
+        bool initialCheck;
+    } update;
+
+    char hash[33];
+};
+
+// Layout of /config.bin from firmware that dumped the raw struct, before the
+// tagged format. Frozen: only read to migrate old devices, never edit.
+struct LegacyRuntimeConfigV0 {
+    struct {
+        char name[32];
+        char firmwareVersion[16];
+        uint64_t chipID;
+        char macAddress[18];
+        uint32_t statusUpdateInterval;
+    } device;
+
+    struct {
+        char ssid[32];
+        char password[64];
+        bool autoReconnect;
+        uint8_t maxConnectionAttempts;
+        uint32_t reconnectInterval;
+        uint32_t checkInterval;
+    } wifi;
+
+    struct {
+        char broker[64];
+        uint16_t port;
+        char user[32];
+        char password[64];
+        uint32_t retryInterval;
+        char baseTopic[64];
+        uint8_t maxConnectionAttempts;
+    } mqtt;
+
+    struct {
+        uint8_t maxRecoveryAttempts;
+        uint32_t recoveryInterval;
+    } error;
+
+    struct {
+        bool allowMqttLog;
+        char mqttTopic[64];
+        uint8_t logLevel;
+    } logging;
+
+    struct {
+        char apiUrl[128];
+        char apiToken[128];
+        uint32_t interval;
+        bool initialCheck;
+    } update;
+
+    char hash[33];
+};
+
+enum class ConfigSection {
+    DEVICE,
+    WIFI,
+    MQTT,
+    SCAN,
+    FTM,
+    ANCHOR,
+    POSITION,
+    ERROR,
+    LOGGING,
+    UPDATE,
+    __DELIMITER__
+};
+
+#endif
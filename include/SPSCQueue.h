@@ -0,0 +1,53 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer ring of preallocated items. The
+// producer fills the slot returned by reserve() in place and publishes it
+// with commit(); the consumer reads front() in place and releases it with
+// pop(). One slot is kept empty to tell full from empty.
+template <typename T, uint8_t SIZE>
+class SPSCQueue {
+public:
+    SPSCQueue() : head(0), tail(0), overruns(0) {}
+
+    T* reserve() {
+        uint8_t current = head.load(std::memory_order_relaxed);
+        if ((current + 1) % SIZE == tail.load(std::memory_order_acquire)) {
+            overruns++;
+            return nullptr;
+        }
+        return &items[current];
+    }
+
+    void commit() {
+        head.store((head.load(std::memory_order_relaxed) + 1) % SIZE, std::memory_order_release);
+    }
+
+    T* front() {
+        uint8_t current = tail.load(std::memory_order_relaxed);
+        if (current == head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &items[current];
+    }
+
+    void pop() {
+        tail.store((tail.load(std::memory_order_relaxed) + 1) % SIZE, std::memory_order_release);
+    }
+
+    uint8_t getCount() const {
+        return (head.load(std::memory_order_acquire) + SIZE - tail.load(std::memory_order_acquire)) % SIZE;
+    }
+    uint32_t getOverruns() const { return overruns.load(std::memory_order_relaxed); }
+
+private:
+    T items[SIZE];
+    std::atomic<uint8_t> head;
+    std::atomic<uint8_t> tail;
+    std::atomic<uint32_t> overruns;
+};
+
+#endif
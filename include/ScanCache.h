@@ -0,0 +1,35 @@
+#ifndef SCAN_CACHE_H
+#define SCAN_CACHE_H
+
+#include <stdint.h>
+#include <string.h>
+
+struct ScanResult {
+    uint8_t bssid[6];
+    uint8_t channel;
+    int8_t rssi;
+    bool ftmResponder;
+    uint32_t seenAt;
+};
+
+class ScanCache {
+public:
+    static const uint8_t MAX_RESULTS = 32;
+
+    ScanCache() : count(0) {}
+
+    void upsert(const ScanResult& result);
+    void prune(uint32_t now, uint32_t maxAge);
+    void clear() { count = 0; }
+
+    const ScanResult* find(const uint8_t bssid[6]) const;
+    const ScanResult* get(uint8_t index) const { return index < count ? &results[index] : nullptr; }
+    uint8_t getCount() const { return count; }
+    bool isFresh(const uint8_t bssid[6], uint32_t now, uint32_t maxAge) const;
+
+private:
+    ScanResult results[MAX_RESULTS];
+    uint8_t count;
+};
+
+#endif
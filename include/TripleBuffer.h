@@ -0,0 +1,42 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Wait-free single-writer/single-reader snapshot. The writer fills its back
+// buffer and swaps it into the middle; the reader swaps the middle out when
+// it is newer than its own. Neither side ever sees a half-written value and
+// the reader always gets the latest write, however many it missed.
+template <typename T>
+class TripleBuffer {
+public:
+    explicit TripleBuffer(const T& initial) : back(0), front(1), middle(2) {
+        buffers[0] = initial;
+        buffers[1] = initial;
+        buffers[2] = initial;
+    }
+
+    void write(const T& value) {
+        buffers[back] = value;
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    const T& read() {
+        if (middle.load(std::memory_order_relaxed) & FRESH) {
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        }
+        return buffers[front];
+    }
+
+private:
+    static const uint8_t INDEX = 0x03;
+    static const uint8_t FRESH = 0x04;
+
+    T buffers[3];
+    uint8_t back;
+    uint8_t front;
+    std::atomic<uint8_t> middle;
+};
+
+#endif
@@ -2,8 +2,17 @@
 #define WIFI_MANAGER_H
 
 #include <WiFi.h>
+#include <atomic>
 #include "ConfigManager.h"
 #include "Logger.h"
+#include "FtmRangingEngine.h"
+#include "FtmScheduler.h"
+#include "FtmEstimator.h"
+#include "AnchorAdvertisement.h"
+#include "ScanCache.h"
+#include "CalibrationManager.h"
+#include "FtmReplay.h"
+#include "TripleBuffer.h"
 
 #include "esp_wifi.h"
 #include "esp_wifi_types.h"
@@ -11,6 +20,20 @@
 #include "esp_log.h"
 #include "nvs_flash.h"
 
+struct AdvertisedPosition {
+    uint8_t bssid[6];
+    float x;
+    float y;
+    float z;
+};
+
+typedef std::function<void(const ScanCache&)> ScanCallback;
+
+struct FtmEstimatorSettings {
+    FtmEstimatorMethod method;
+    uint8_t param;
+};
+
 enum class WiFiStatus {
     UNINITIALIZED,
     DISCONNECTED,
@@ -23,24 +46,85 @@ enum class WiFiStatus {
 };
 
 class WiFiManager {
+public:
+    static constexpr const char* FTM_RECORD_FILE = "/ftm_record.csv";
+
 private:
     WiFiManager()
         : status(WiFiStatus::DISCONNECTED)
         , lastAttempt(0)
         , connectionAttempts(0)
+        , ftmScheduler(ftmEngine)
+        , advertisementHead(0)
+        , advertisementTail(0)
+        , advertisedPositionCount(0)
+        , scanning(false)
+        , scanChannelCount(0)
+        , scanChannelIndex(0)
+        , scanStartedAt(0)
+        , scanCallback(nullptr)
+        , recordLength(0)
+        , recordFlushedAt(0)
+        , recordDropped(0)
+        , estimatorSettings(FtmEstimatorSettings{FtmEstimatorMethod::FIRMWARE, 0})
         , configManager(ConfigManager::getInstance())
-        , log(Logger::getInstance()) {}
+        , log(Logger::getInstance()) {
+        configManager.addListener(ConfigManager::sectionMask(ConfigSection::FTM), [this](const RuntimeConfig& previous, const RuntimeConfig& current) {
+            applyFtmConfig(current);
+        });
+    }
 
     WiFiStatus status;
     uint32_t lastAttempt;
     uint8_t connectionAttempts;
 
-    bool ftmSuccess;
-    SemaphoreHandle_t ftmSemaphore;
+    FtmRangingEngine ftmEngine;
+    FtmScheduler ftmScheduler;
+
+    static const uint8_t ADVERTISEMENT_QUEUE_SIZE = 8;
+    AdvertisedPosition advertisementQueue[ADVERTISEMENT_QUEUE_SIZE];
+    std::atomic<uint8_t> advertisementHead;
+    std::atomic<uint8_t> advertisementTail;
+    AdvertisedPosition advertisedPositions[FtmScheduler::MAX_ANCHORS];
+    uint8_t advertisedPositionCount;
+
+    static const uint8_t MAX_SCAN_CHANNELS = 14;
+    ScanCache scanCache;
+    bool scanning;
+    uint8_t scanChannels[MAX_SCAN_CHANNELS];
+    uint8_t scanChannelCount;
+    uint8_t scanChannelIndex;
+    uint32_t scanStartedAt;
+    ScanCallback scanCallback;
+
+    // Recorded lines are appended on the loop and written to flash in
+    // batches while no FTM session is running, or once the buffer is mostly
+    // full, so an erase does not stall ranging on every result.
+    static const uint16_t FTM_RECORD_BUFFER_SIZE = 1024;
+    static const uint32_t FTM_RECORD_FLUSH_INTERVAL = 5000;
+    char recordBuffer[FTM_RECORD_BUFFER_SIZE];
+    uint16_t recordLength;
+    uint32_t recordFlushedAt;
+    uint32_t recordDropped;
+
+    // Read by onFtmReport on the WiFi event task, never from RuntimeConfig.
+    TripleBuffer<FtmEstimatorSettings> estimatorSettings;
 
     ConfigManager& configManager;
     Logger& log;
 
+    uint32_t requestFtmReport(const FtmRequest& request, FtmCallback callback);
+    void applyFtmConfig(const RuntimeConfig& config);
+    void processAdvertisements();
+    bool startChannelScan();
+    void updateScan();
+    void recordFtmResult(const FtmResult& result);
+    void appendFtmRecord(const char* line, int length);
+    void updateFtmRecord(uint32_t now);
+    void collectScanResults(int16_t count);
+    void finishScan();
+    const AdvertisedPosition* findAdvertisedPosition(const uint8_t bssid[6]);
+    static void onVendorIe(void* context, wifi_vendor_ie_type_t type, const uint8_t sa[6], const vendor_ie_data_t* vendorIe, int rssi);
     const char *getWifiStatusString(WiFiStatus status);
     constexpr size_t getWifiStatusCount() {return static_cast<size_t>(WiFiStatus::__DELIMITER__);};
 
@@ -68,11 +152,24 @@ public:
     int32_t getRSSI();
     uint8_t getConnectionAttempts();
     
-    bool getFtmReportConnected();
-    bool getFtmReportBssid(uint8_t channel, byte mac[]);
+    uint32_t requestFtmReportConnected(FtmCallback callback = nullptr);
+    uint32_t requestFtmReportBssid(uint8_t channel, const uint8_t mac[], FtmCallback callback = nullptr);
+    bool pollFtmReport(uint32_t requestId, FtmResult& result);
+    bool cancelFtmReport(uint32_t requestId);
+    bool addFtmAnchor(const uint8_t bssid[6], uint8_t channel, uint8_t priority = 0);
+    bool removeFtmAnchor(const uint8_t bssid[6]);
+    bool setFtmAnchorPosition(const uint8_t bssid[6], float x, float y, float z);
+    bool calibrateFtmAnchor(const uint8_t bssid[6], uint8_t channel, float knownDistanceCm, uint16_t samples);
+    void flushFtmRecord();
+    void getFtmReplayConfig(FtmReplayConfig& replayConfig);
+    bool replayFtmRecording(const char* path, const FtmReplayConfig& replayConfig, FtmReplayStats& stats);
+    FtmRangingEngine& getFtmEngine() { return ftmEngine; }
+    FtmScheduler& getFtmScheduler() { return ftmScheduler; }
     static void onFtmReport(arduino_event_t *event);
-    void softAP();
-    void scan();
+    bool startScan(const uint8_t* channels = nullptr, uint8_t channelCount = 0, ScanCallback callback = nullptr);
+    bool startAnchorScan(ScanCallback callback = nullptr);
+    bool isScanning() { return scanning; }
+    const ScanCache& getScanCache() { return scanCache; }
 
     WiFiStatus getStatus();
     const char* getStatusString() { return getWifiStatusString(status); };
@@ -2,17 +2,32 @@
 #define ACTION_SATE_H
 
 #include <Device.h>
+#include "Multilateration.h"
 
 class ActionState : public DeviceState {
 private:
     ActionState(Device* device) 
         : DeviceState(device, StateIdentifier::ACTION_STATE)
         , log(Logger::getInstance())
-        , configManager(ConfigManager::getInstance()) {};
+        , configManager(ConfigManager::getInstance())
+        , lastPositionUpdate(0)
+        , lastMetricsUpdate(0)
+        , lastScan(0)
+        , positionTopic(MQTTManager::INVALID_TOPIC) {};
     
     Logger& log;
     ConfigManager& configManager;
 
+    Multilateration multilateration;
+    uint32_t lastPositionUpdate;
+    uint32_t lastMetricsUpdate;
+    uint32_t lastScan;
+    MQTTTopicHandle positionTopic;
+
+    void updatePosition();
+    void publishPosition(const PositionFix& fix);
+    void publishFtmMetrics();
+
 public:
     ActionState(const ActionState&) = delete;
     void operator=(const ActionState&) = delete;
@@ -28,4 +43,4 @@ public:
 
 };
 
-#endif
\ No newline at end of file
+#endif
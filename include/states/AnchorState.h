@@ -0,0 +1,40 @@
+#ifndef ANCHOR_STATE_H
+#define ANCHOR_STATE_H
+
+#include <Device.h>
+#include <WiFi.h>
+#include "esp_wifi.h"
+#include "AnchorAdvertisement.h"
+
+class AnchorState : public DeviceState {
+private:
+    AnchorState(Device* device) 
+        : DeviceState(device, StateIdentifier::ANCHOR_STATE)
+        , log(Logger::getInstance())
+        , configManager(ConfigManager::getInstance())
+        , responderActive(false) {};
+    
+    Logger& log;
+    ConfigManager& configManager;
+
+    bool responderActive;
+    uint8_t advertisement[AnchorAdvertisement::ELEMENT_SIZE];
+
+    bool startResponder();
+    bool advertisePosition();
+
+public:
+    AnchorState(const AnchorState&) = delete;
+    void operator=(const AnchorState&) = delete;
+
+    static AnchorState& getInstance(Device* device) {
+        static AnchorState instance(device);
+        return instance;
+    }
+
+    void enter() override;
+    void update() override;
+    void exit() override;
+};
+
+#endif
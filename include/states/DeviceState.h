@@ -9,6 +9,7 @@ enum class StateIdentifier {
     SETUP_STATE,
     ERROR_STATE,
     UPDATE_STATE,
+    ANCHOR_STATE,
     __DELIMITER__
 };
 
@@ -39,6 +40,7 @@ public:
             case StateIdentifier::ERROR_STATE: return "ERROR_STATE";
             case StateIdentifier::ACTION_STATE: return "ACTION_STATE";
             case StateIdentifier::UPDATE_STATE: return "UPDATE_STATE";
+            case StateIdentifier::ANCHOR_STATE: return "ANCHOR_STATE";
             default: return "UNKNOWN";
         }
     };
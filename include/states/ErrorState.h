@@ -11,7 +11,8 @@ private:
         , errorCode(ErrorCode::UNKNOWN_ERROR)
         , log(Logger::getInstance())
         , mqttManager(MQTTManager::getInstance())
-        , configManager(ConfigManager::getInstance()) {};
+        , configManager(ConfigManager::getInstance())
+        , errorTopic(MQTTManager::INVALID_TOPIC) {};
     
     Logger& log;
     ConfigManager& configManager;
@@ -22,6 +23,7 @@ private:
     const char* errorMessage;
     uint8_t recoveryAttempts;
     unsigned long lastRecoveryAttempt;
+    MQTTTopicHandle errorTopic;
 
     bool attemptRecovery();
     void reportError();
@@ -27,7 +27,8 @@ private:
         , log(Logger::getInstance())
         , configManager(ConfigManager::getInstance())
         , wifiManager(WiFiManager::getInstance())
-        , mqttManager(MQTTManager::getInstance()) {};
+        , mqttManager(MQTTManager::getInstance())
+        , configAckTopic(MQTTManager::INVALID_TOPIC) {};
 
     Logger& log;
     ConfigManager& configManager;
@@ -37,8 +38,7 @@ private:
     static const uint32_t SETUP_TIMEOUT = 60000;
     SetupPhase currentPhase;
     uint32_t setupStateTime;
-
-    uint8_t mqttConnectionAttempts;
+    MQTTTopicHandle configAckTopic;
 
     bool initializeManagers();
     void handleWifiConnection();
@@ -46,7 +46,6 @@ private:
     void handleConnectionError(const char* message, ErrorCode errorCode);
     void handleSetupFailure();
     void subscribeDefaultTopics();
-    void handleDeviceMessage(const char* topic, const uint8_t* payload, unsigned int length);
     void handleConfigMessage(const char* topic, const uint8_t* payload, unsigned int length);
 
     const char* getSetupPhaseString(SetupPhase phase);
@@ -26,7 +26,8 @@ private:
         , configManager(ConfigManager::getInstance()) 
         , mqttManager(MQTTManager::getInstance()) 
         , currentPhase(UpdatePhase::CHECK_VERSION)
-        , lastUpdateCheck(0) {};
+        , lastUpdateCheck(0)
+        , updateTopic(MQTTManager::INVALID_TOPIC) {};
 
         Logger& log;
         ConfigManager& configManager;
@@ -38,6 +39,7 @@ private:
         size_t totalBytes;
         size_t downloadedBytes;
         uint32_t lastUpdateCheck;
+        MQTTTopicHandle updateTopic;
 
         bool checkLatestRelease();
         bool downloadAndInstall();
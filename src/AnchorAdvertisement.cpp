@@ -0,0 +1,51 @@
+#include "AnchorAdvertisement.h"
+#include <string.h>
+#include <math.h>
+
+const uint8_t AnchorAdvertisement::OUI[3] = {0x02, 0x47, 0x4E};
+
+size_t AnchorAdvertisement::encode(float x, float y, float z, uint8_t* element, size_t size) {
+    if (size < ELEMENT_SIZE) {
+        return 0;
+    }
+
+    element[0] = ELEMENT_ID;
+    element[1] = ELEMENT_SIZE - 2;
+    memcpy(&element[2], OUI, sizeof(OUI));
+    element[5] = OUI_TYPE;
+    element[6] = VERSION;
+    writeInt32(&element[7], static_cast<int32_t>(lroundf(x * 1000.0f)));
+    writeInt32(&element[11], static_cast<int32_t>(lroundf(y * 1000.0f)));
+    writeInt32(&element[15], static_cast<int32_t>(lroundf(z * 1000.0f)));
+
+    return ELEMENT_SIZE;
+}
+
+bool AnchorAdvertisement::decode(const uint8_t* element, size_t size, float& x, float& y, float& z) {
+    if (size < ELEMENT_SIZE || element[0] != ELEMENT_ID || element[1] < ELEMENT_SIZE - 2) {
+        return false;
+    }
+    if (memcmp(&element[2], OUI, sizeof(OUI)) != 0 || element[5] != OUI_TYPE || element[6] != VERSION) {
+        return false;
+    }
+
+    x = readInt32(&element[7]) / 1000.0f;
+    y = readInt32(&element[11]) / 1000.0f;
+    z = readInt32(&element[15]) / 1000.0f;
+    return true;
+}
+
+void AnchorAdvertisement::writeInt32(uint8_t* buffer, int32_t value) {
+    uint32_t raw = static_cast<uint32_t>(value);
+    for (uint8_t i = 0; i < 4; i++) {
+        buffer[i] = (raw >> (8 * i)) & 0xFF;
+    }
+}
+
+int32_t AnchorAdvertisement::readInt32(const uint8_t* buffer) {
+    uint32_t raw = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        raw |= static_cast<uint32_t>(buffer[i]) << (8 * i);
+    }
+    return static_cast<int32_t>(raw);
+}
@@ -0,0 +1,140 @@
+#include "CalibrationManager.h"
+
+void CalibrationManager::ensureLoaded() {
+    if (loaded) {
+        return;
+    }
+
+    loaded = true;
+    if (!loadFromFlash()) {
+        table.clear();
+        log.debug("CalibrationManager", "No calibration table found, using uncorrected ranges");
+    }
+}
+
+float CalibrationManager::apply(const uint8_t bssid[6], float distanceCm) {
+    ensureLoaded();
+
+    if (calibrating && memcmp(bssid, calibrationBssid, sizeof(calibrationBssid)) == 0) {
+        sampleSum += distanceCm;
+        if (++collectedSamples >= targetSamples) {
+            finishCalibration();
+        }
+    }
+
+    return table.apply(bssid, distanceCm);
+}
+
+bool CalibrationManager::startCalibration(const uint8_t bssid[6], float knownDistanceCm, uint16_t samples) {
+    if (samples == 0 || knownDistanceCm <= 0.0f) {
+        log.error("CalibrationManager", "Invalid calibration parameters");
+        return false;
+    }
+
+    memcpy(calibrationBssid, bssid, sizeof(calibrationBssid));
+    this->knownDistanceCm = knownDistanceCm;
+    targetSamples = samples;
+    collectedSamples = 0;
+    sampleSum = 0.0;
+    calibrating = true;
+
+    LOG_INFO("CalibrationManager", "Calibrating %02X:%02X:%02X:%02X:%02X:%02X at %.0f cm over %d samples", bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5], knownDistanceCm, samples);
+
+    return true;
+}
+
+void CalibrationManager::finishCalibration() {
+    calibrating = false;
+
+    const CalibrationEntry* existing = table.find(calibrationBssid);
+    float scale = existing ? existing->scale : 1.0f;
+    float mean = sampleSum / collectedSamples;
+    float offset = mean - knownDistanceCm / scale;
+
+    LOG_INFO("CalibrationManager", "Calibration finished: mean %.1f cm, offset %.1f cm, scale %.3f", mean, offset, scale);
+
+    setCalibration(calibrationBssid, offset, scale);
+}
+
+bool CalibrationManager::setCalibration(const uint8_t bssid[6], float offsetCm, float scale) {
+    ensureLoaded();
+
+    if (!table.set(bssid, offsetCm, scale)) {
+        log.error("CalibrationManager", "Calibration table full");
+        return false;
+    }
+
+    if (!saveToFlash()) {
+        log.error("CalibrationManager", "Failed to save calibration table");
+        return false;
+    }
+    return true;
+}
+
+bool CalibrationManager::clearCalibration(const uint8_t bssid[6]) {
+    ensureLoaded();
+
+    if (!table.remove(bssid)) {
+        return false;
+    }
+    return saveToFlash();
+}
+
+bool CalibrationManager::loadFromFlash() {
+    File file = LittleFS.open(CALIBRATION_FILE, "r");
+    if (!file) {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint8_t count = 0;
+    if (file.read((uint8_t*)&magic, sizeof(magic)) != sizeof(magic) || magic != FILE_MAGIC ||
+        file.read(&count, sizeof(count)) != sizeof(count)) {
+        file.close();
+        return false;
+    }
+
+    table.clear();
+    for (uint8_t i = 0; i < count; i++) {
+        CalibrationEntry entry;
+        if (file.read(entry.bssid, sizeof(entry.bssid)) != sizeof(entry.bssid) ||
+            file.read((uint8_t*)&entry.offsetCm, sizeof(entry.offsetCm)) != sizeof(entry.offsetCm) ||
+            file.read((uint8_t*)&entry.scale, sizeof(entry.scale)) != sizeof(entry.scale)) {
+            file.close();
+            table.clear();
+            return false;
+        }
+        table.set(entry.bssid, entry.offsetCm, entry.scale);
+    }
+
+    file.close();
+
+    LOG_DEBUG("CalibrationManager", "Loaded %d calibration entries", table.getCount());
+    return true;
+}
+
+bool CalibrationManager::saveToFlash() {
+    File file = LittleFS.open(CALIBRATION_FILE, "w");
+    if (!file) {
+        return false;
+    }
+
+    uint32_t magic = FILE_MAGIC;
+    uint8_t count = table.getCount();
+    bool success = file.write((const uint8_t*)&magic, sizeof(magic)) == sizeof(magic) &&
+                   file.write(&count, sizeof(count)) == sizeof(count);
+
+    for (uint8_t i = 0; success && i < CalibrationTable::CAPACITY; i++) {
+        const CalibrationEntry* entry = table.getSlot(i);
+        if (!entry->used) {
+            continue;
+        }
+
+        success = file.write(entry->bssid, sizeof(entry->bssid)) == sizeof(entry->bssid) &&
+                  file.write((const uint8_t*)&entry->offsetCm, sizeof(entry->offsetCm)) == sizeof(entry->offsetCm) &&
+                  file.write((const uint8_t*)&entry->scale, sizeof(entry->scale)) == sizeof(entry->scale);
+    }
+
+    file.close();
+    return success;
+}
@@ -0,0 +1,94 @@
+#include "CalibrationTable.h"
+
+void CalibrationTable::clear() {
+    memset(entries, 0, sizeof(entries));
+    count = 0;
+}
+
+uint8_t CalibrationTable::hash(const uint8_t bssid[6]) {
+    uint32_t value = 2166136261u;
+    for (uint8_t i = 0; i < 6; i++) {
+        value = (value ^ bssid[i]) * 16777619u;
+    }
+    return value & (CAPACITY - 1);
+}
+
+int16_t CalibrationTable::locate(const uint8_t bssid[6]) const {
+    uint8_t index = hash(bssid);
+
+    for (uint8_t probe = 0; probe < CAPACITY; probe++) {
+        const CalibrationEntry& entry = entries[index];
+        if (!entry.used) {
+            return -1;
+        }
+        if (memcmp(entry.bssid, bssid, sizeof(entry.bssid)) == 0) {
+            return index;
+        }
+        index = (index + 1) & (CAPACITY - 1);
+    }
+    return -1;
+}
+
+const CalibrationEntry* CalibrationTable::find(const uint8_t bssid[6]) const {
+    int16_t index = locate(bssid);
+    return index < 0 ? nullptr : &entries[index];
+}
+
+bool CalibrationTable::set(const uint8_t bssid[6], float offsetCm, float scale) {
+    int16_t existing = locate(bssid);
+    if (existing >= 0) {
+        entries[existing].offsetCm = offsetCm;
+        entries[existing].scale = scale;
+        return true;
+    }
+
+    if (count >= CAPACITY) {
+        return false;
+    }
+
+    uint8_t index = hash(bssid);
+    while (entries[index].used) {
+        index = (index + 1) & (CAPACITY - 1);
+    }
+
+    CalibrationEntry& entry = entries[index];
+    memcpy(entry.bssid, bssid, sizeof(entry.bssid));
+    entry.used = true;
+    entry.offsetCm = offsetCm;
+    entry.scale = scale;
+    count++;
+
+    return true;
+}
+
+bool CalibrationTable::remove(const uint8_t bssid[6]) {
+    int16_t index = locate(bssid);
+    if (index < 0) {
+        return false;
+    }
+
+    entries[index].used = false;
+    count--;
+
+    // Re-insert the rest of the probe cluster so later lookups don't stop early.
+    uint8_t next = (index + 1) & (CAPACITY - 1);
+    while (entries[next].used) {
+        CalibrationEntry moved = entries[next];
+        entries[next].used = false;
+        count--;
+        set(moved.bssid, moved.offsetCm, moved.scale);
+        next = (next + 1) & (CAPACITY - 1);
+    }
+
+    return true;
+}
+
+float CalibrationTable::apply(const uint8_t bssid[6], float distanceCm) const {
+    const CalibrationEntry* entry = find(bssid);
+    if (!entry) {
+        return distanceCm;
+    }
+
+    float corrected = (distanceCm - entry->offsetCm) * entry->scale;
+    return corrected < 0.0f ? 0.0f : corrected;
+}
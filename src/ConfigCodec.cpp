@@ -0,0 +1,376 @@
+#include "ConfigCodec.h"
+#include <string.h>
+
+#define CONFIG_FIELD(tag, section, group, member, type, min, max) \
+    {tag, ConfigSection::section, #member, ConfigFieldType::type, offsetof(RuntimeConfig, group.member), sizeof(((RuntimeConfig*)nullptr)->group.member), true, min, max}
+#define CONFIG_VALUE(tag, section, path, type) \
+    {tag, ConfigSection::section, #path, ConfigFieldType::type, offsetof(RuntimeConfig, path), sizeof(((RuntimeConfig*)nullptr)->path), false, 0, 0}
+
+// Every persisted field. Writable ones can also be patched at runtime;
+// identity fields and the MQTT base topic are baked into topics and the
+// client id, so they are stored but read-only.
+static const ConfigField CONFIG_FIELDS[] = {
+    CONFIG_VALUE(0x0101, DEVICE, device.name, STRING),
+    CONFIG_VALUE(0x0102, DEVICE, device.firmwareVersion, STRING),
+    CONFIG_VALUE(0x0103, DEVICE, device.chipID, INTEGER),
+    CONFIG_VALUE(0x0104, DEVICE, device.macAddress, STRING),
+    CONFIG_VALUE(0x0105, DEVICE, hash, STRING),
+    CONFIG_FIELD(0x0106, DEVICE, device, statusUpdateInterval, INTEGER, 1000, 86400000),
+    CONFIG_FIELD(0x0107, DEVICE, device, statusFormat, INTEGER, 0, 1),
+    CONFIG_FIELD(0x0108, DEVICE, device, statusKeyframeInterval, INTEGER, 1, 255),
+    CONFIG_FIELD(0x0109, DEVICE, device, statusRssiThreshold, INTEGER, 0, 100),
+    CONFIG_FIELD(0x010A, DEVICE, device, statusHeapThreshold, INTEGER, 0, 1048576),
+
+    CONFIG_FIELD(0x0201, WIFI, wifi, ssid, STRING, 0, 0),
+    CONFIG_FIELD(0x0202, WIFI, wifi, password, STRING, 0, 0),
+    CONFIG_FIELD(0x0203, WIFI, wifi, autoReconnect, BOOL, 0, 0),
+    CONFIG_FIELD(0x0204, WIFI, wifi, maxConnectionAttempts, INTEGER, 1, 255),
+    CONFIG_FIELD(0x0205, WIFI, wifi, reconnectInterval, INTEGER, 100, 600000),
+    CONFIG_FIELD(0x0206, WIFI, wifi, checkInterval, INTEGER, 10, 60000),
+
+    CONFIG_VALUE(0x0301, MQTT, mqtt.baseTopic, STRING),
+    CONFIG_FIELD(0x0302, MQTT, mqtt, broker, STRING, 0, 0),
+    CONFIG_FIELD(0x0303, MQTT, mqtt, port, INTEGER, 1, 65535),
+    CONFIG_FIELD(0x0304, MQTT, mqtt, user, STRING, 0, 0),
+    CONFIG_FIELD(0x0305, MQTT, mqtt, password, STRING, 0, 0),
+    CONFIG_FIELD(0x0306, MQTT, mqtt, retryInterval, INTEGER, 100, 600000),
+    CONFIG_FIELD(0x0307, MQTT, mqtt, maxConnectionAttempts, INTEGER, 1, 255),
+    CONFIG_FIELD(0x0308, MQTT, mqtt, drainBudget, INTEGER, 1, 16),
+    CONFIG_FIELD(0x0309, MQTT, mqtt, inflightWindow, INTEGER, 1, 16),
+    CONFIG_FIELD(0x030A, MQTT, mqtt, persistentSession, BOOL, 0, 0),
+
+    CONFIG_FIELD(0x0401, SCAN, scan, maxMsPerChannel, INTEGER, 10, 1500),
+    CONFIG_FIELD(0x0402, SCAN, scan, interval, INTEGER, 1000, 3600000),
+    CONFIG_FIELD(0x0403, SCAN, scan, cacheTtl, INTEGER, 1000, 3600000),
+    CONFIG_FIELD(0x0404, SCAN, scan, autoAddAnchors, BOOL, 0, 0),
+
+    CONFIG_FIELD(0x0501, FTM, ftm, frameCount, INTEGER, 0, 64),
+    CONFIG_FIELD(0x0502, FTM, ftm, burstPeriod, INTEGER, 0, 255),
+    CONFIG_FIELD(0x0503, FTM, ftm, requestTimeout, INTEGER, 100, 60000),
+    CONFIG_FIELD(0x0504, FTM, ftm, estimator, INTEGER, 0, 4),
+    CONFIG_FIELD(0x0505, FTM, ftm, estimatorParam, INTEGER, 0, 50),
+    CONFIG_FIELD(0x0506, FTM, ftm, minInterval, INTEGER, 50, 600000),
+    CONFIG_FIELD(0x0507, FTM, ftm, maxInterval, INTEGER, 50, 600000),
+    CONFIG_FIELD(0x0508, FTM, ftm, stableThreshold, INTEGER, 0, 65535),
+    CONFIG_FIELD(0x0509, FTM, ftm, adaptiveBurst, BOOL, 0, 0),
+    CONFIG_FIELD(0x050A, FTM, ftm, burstLowDeviation, INTEGER, 0, 65535),
+    CONFIG_FIELD(0x050B, FTM, ftm, burstHighDeviation, INTEGER, 0, 65535),
+    CONFIG_FIELD(0x050C, FTM, ftm, maxBurstPeriod, INTEGER, 0, 255),
+    CONFIG_FIELD(0x050D, FTM, ftm, metricsInterval, INTEGER, 1000, 3600000),
+    CONFIG_FIELD(0x050E, FTM, ftm, recordReports, BOOL, 0, 0),
+    CONFIG_FIELD(0x050F, FTM, ftm, filterStages, INTEGER, 0, 7),
+    CONFIG_FIELD(0x0510, FTM, ftm, filterGateThreshold, INTEGER, 0, 65535),
+    CONFIG_FIELD(0x0511, FTM, ftm, filterGateMaxRejects, INTEGER, 0, 255),
+    CONFIG_FIELD(0x0512, FTM, ftm, filterMedianWindow, INTEGER, 1, 9),
+    CONFIG_FIELD(0x0513, FTM, ftm, filterProcessNoise, FLOAT, 0, 1000000),
+    CONFIG_FIELD(0x0514, FTM, ftm, filterMeasurementNoise, FLOAT, 0, 1000000),
+
+    CONFIG_FIELD(0x0601, ANCHOR, anchor, ssid, STRING, 0, 0),
+    CONFIG_FIELD(0x0602, ANCHOR, anchor, password, STRING, 0, 0),
+    CONFIG_FIELD(0x0603, ANCHOR, anchor, channel, INTEGER, 1, 13),
+    CONFIG_FIELD(0x0604, ANCHOR, anchor, maxClients, INTEGER, 1, 10),
+    CONFIG_FIELD(0x0605, ANCHOR, anchor, x, FLOAT, -10000, 10000),
+    CONFIG_FIELD(0x0606, ANCHOR, anchor, y, FLOAT, -10000, 10000),
+    CONFIG_FIELD(0x0607, ANCHOR, anchor, z, FLOAT, -10000, 10000),
+
+    CONFIG_FIELD(0x0701, POSITION, position, interval, INTEGER, 100, 600000),
+    CONFIG_FIELD(0x0702, POSITION, position, maxRangeAge, INTEGER, 100, 600000),
+    CONFIG_FIELD(0x0703, POSITION, position, solve3d, BOOL, 0, 0),
+    CONFIG_FIELD(0x0704, POSITION, position, tagHeight, FLOAT, -100, 100),
+
+    CONFIG_FIELD(0x0801, ERROR, error, maxRecoveryAttempts, INTEGER, 0, 255),
+    CONFIG_FIELD(0x0802, ERROR, error, recoveryInterval, INTEGER, 100, 600000),
+
+    CONFIG_FIELD(0x0901, LOGGING, logging, allowMqttLog, BOOL, 0, 0),
+    CONFIG_FIELD(0x0902, LOGGING, logging, mqttTopic, STRING, 0, 0),
+    CONFIG_FIELD(0x0903, LOGGING, logging, logLevel, INTEGER, 0, 3),
+    CONFIG_FIELD(0x0904, LOGGING, logging, mqttLevel, INTEGER, 0, 3),
+    CONFIG_FIELD(0x0905, LOGGING, logging, mqttBatchSize, INTEGER, 1, 64),
+    CONFIG_FIELD(0x0906, LOGGING, logging, mqttBatchInterval, INTEGER, 100, 600000),
+    CONFIG_FIELD(0x0907, LOGGING, logging, mqttRateLimit, INTEGER, 0, 65536),
+
+    CONFIG_FIELD(0x0A01, UPDATE, update, apiUrl, STRING, 0, 0),
+    CONFIG_FIELD(0x0A02, UPDATE, update, apiToken, STRING, 0, 0),
+    CONFIG_FIELD(0x0A03, UPDATE, update, interval, INTEGER, 1000, 86400000),
+    CONFIG_FIELD(0x0A04, UPDATE, update, initialCheck, BOOL, 0, 0),
+};
+
+#undef CONFIG_FIELD
+#undef CONFIG_VALUE
+
+static const size_t CONFIG_FIELD_COUNT = sizeof(CONFIG_FIELDS) / sizeof(CONFIG_FIELDS[0]);
+
+static void writeLittleEndian(uint8_t* buffer, uint64_t value, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+static uint64_t readLittleEndian(const uint8_t* buffer, uint8_t length) {
+    uint64_t value = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        value |= static_cast<uint64_t>(buffer[i]) << (8 * i);
+    }
+    return value;
+}
+
+static uint64_t readNative(const uint8_t* source, uint16_t size) {
+    switch (size) {
+        case sizeof(uint8_t): return *source;
+        case sizeof(uint16_t): { uint16_t value; memcpy(&value, source, size); return value; }
+        case sizeof(uint32_t): { uint32_t value; memcpy(&value, source, size); return value; }
+        default: { uint64_t value; memcpy(&value, source, sizeof(value)); return value; }
+    }
+}
+
+static void writeNative(uint8_t* destination, uint16_t size, uint64_t number) {
+    switch (size) {
+        case sizeof(uint8_t): *destination = static_cast<uint8_t>(number); break;
+        case sizeof(uint16_t): { uint16_t value = number; memcpy(destination, &value, size); break; }
+        case sizeof(uint32_t): { uint32_t value = number; memcpy(destination, &value, size); break; }
+        default: memcpy(destination, &number, sizeof(number)); break;
+    }
+}
+
+const ConfigField* ConfigCodec::findField(ConfigSection section, const char* name) {
+    for (const ConfigField& field : CONFIG_FIELDS) {
+        if (field.section == section && strcmp(field.name, name) == 0) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+// Files are written in table order, so the next field is checked first.
+const ConfigField* ConfigCodec::findField(uint16_t tag, size_t& hint) {
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        size_t index = (hint + i) % CONFIG_FIELD_COUNT;
+        if (CONFIG_FIELDS[index].tag == tag) {
+            hint = index + 1;
+            return &CONFIG_FIELDS[index];
+        }
+    }
+    return nullptr;
+}
+
+uint32_t ConfigCodec::crc32(uint32_t crc, const uint8_t* data, size_t length) {
+    static const uint32_t TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = TABLE[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = TABLE[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+bool ConfigCodec::encode(const RuntimeConfig& config, ConfigWriter write) {
+    uint8_t header[6];
+    writeLittleEndian(header, MAGIC, 4);
+    writeLittleEndian(header + 4, VERSION, 2);
+    if (write(header, sizeof(header)) != sizeof(header)) {
+        return false;
+    }
+    uint32_t crc = crc32(0, header, sizeof(header));
+
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&config);
+    uint8_t record[3 + UINT8_MAX];
+
+    for (const ConfigField& field : CONFIG_FIELDS) {
+        const uint8_t* source = base + field.offset;
+        uint8_t* value = record + 3;
+        uint8_t length;
+
+        switch (field.type) {
+            case ConfigFieldType::BOOL:
+                value[0] = *reinterpret_cast<const bool*>(source) ? 1 : 0;
+                length = 1;
+                break;
+            case ConfigFieldType::INTEGER:
+            case ConfigFieldType::FLOAT:
+                length = field.size;
+                writeLittleEndian(value, readNative(source, field.size), length);
+                break;
+            case ConfigFieldType::STRING:
+                length = strnlen(reinterpret_cast<const char*>(source), field.size - 1);
+                memcpy(value, source, length);
+                break;
+            default:
+                continue;
+        }
+
+        size_t recordLength = 3 + length;
+        writeLittleEndian(record, field.tag, 2);
+        record[2] = length;
+        if (write(record, recordLength) != recordLength) {
+            return false;
+        }
+        crc = crc32(crc, record, recordLength);
+    }
+
+    writeLittleEndian(record, END_TAG, 2);
+    record[2] = 0;
+    if (write(record, 3) != 3) {
+        return false;
+    }
+    crc = crc32(crc, record, 3);
+
+    uint8_t trailer[4];
+    writeLittleEndian(trailer, crc, sizeof(trailer));
+    return write(trailer, sizeof(trailer)) == sizeof(trailer);
+}
+
+bool ConfigCodec::decodeValue(const ConfigField& field, const uint8_t* value, uint8_t length, RuntimeConfig& config) {
+    uint8_t* destination = reinterpret_cast<uint8_t*>(&config) + field.offset;
+
+    switch (field.type) {
+        case ConfigFieldType::BOOL:
+            if (length != 1) {
+                return false;
+            }
+            *reinterpret_cast<bool*>(destination) = value[0] != 0;
+            return true;
+        case ConfigFieldType::INTEGER: {
+            // Fields may have been widened or narrowed since the file was
+            // written; keep the default when the stored value no longer fits.
+            if (length == 0 || length > sizeof(uint64_t)) {
+                return false;
+            }
+            uint64_t number = readLittleEndian(value, length);
+            if (field.size < sizeof(uint64_t) && (number >> (8 * field.size)) != 0) {
+                return false;
+            }
+            writeNative(destination, field.size, number);
+            return true;
+        }
+        case ConfigFieldType::FLOAT:
+            if (length != field.size) {
+                return false;
+            }
+            writeNative(destination, field.size, readLittleEndian(value, length));
+            return true;
+        case ConfigFieldType::STRING:
+            if (length >= field.size) {
+                return false;
+            }
+            memcpy(destination, value, length);
+            destination[length] = '\0';
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ConfigCodec::decode(ConfigReader read, RuntimeConfig& config, ConfigDecodeInfo& info) {
+    memset(&info, 0, sizeof(info));
+
+    uint8_t header[6];
+    if (read(header, sizeof(header)) != sizeof(header) || readLittleEndian(header, 4) != MAGIC) {
+        return false;
+    }
+    info.version = readLittleEndian(header + 4, 2);
+    if (info.version == 0 || info.version > VERSION) {
+        return false;
+    }
+    uint32_t crc = crc32(0, header, sizeof(header));
+
+    uint8_t seen[(CONFIG_FIELD_COUNT + 7) / 8] = {0};
+    uint8_t record[3 + UINT8_MAX];
+    size_t hint = 0;
+
+    for (;;) {
+        if (read(record, 3) != 3) {
+            return false;
+        }
+        uint16_t tag = readLittleEndian(record, 2);
+        uint8_t length = record[2];
+        if (length > 0 && read(record + 3, length) != length) {
+            return false;
+        }
+        crc = crc32(crc, record, 3 + length);
+
+        if (tag == END_TAG) {
+            break;
+        }
+
+        const ConfigField* field = findField(tag, hint);
+        if (!field) {
+            info.skipped++;
+            continue;
+        }
+
+        size_t index = field - CONFIG_FIELDS;
+        if (decodeValue(*field, record + 3, length, config) && !(seen[index / 8] & (1 << (index % 8)))) {
+            seen[index / 8] |= 1 << (index % 8);
+            info.fields++;
+        }
+    }
+
+    uint8_t trailer[4];
+    if (read(trailer, sizeof(trailer)) != sizeof(trailer) || readLittleEndian(trailer, sizeof(trailer)) != crc) {
+        return false;
+    }
+
+    info.missing = CONFIG_FIELD_COUNT - info.fields;
+    return true;
+}
+
+bool ConfigCodec::decodeLegacy(ConfigReader read, size_t length, RuntimeConfig& config) {
+    if (length != sizeof(LegacyRuntimeConfigV0)) {
+        return false;
+    }
+
+    LegacyRuntimeConfigV0 legacy;
+    if (read(reinterpret_cast<uint8_t*>(&legacy), sizeof(legacy)) != sizeof(legacy)) {
+        return false;
+    }
+
+    #define COPY_STRING(dest, src) copyString(dest, sizeof(dest), src, sizeof(src))
+
+    COPY_STRING(config.device.name, legacy.device.name);
+    COPY_STRING(config.device.firmwareVersion, legacy.device.firmwareVersion);
+    config.device.chipID = legacy.device.chipID;
+    COPY_STRING(config.device.macAddress, legacy.device.macAddress);
+    config.device.statusUpdateInterval = legacy.device.statusUpdateInterval;
+
+    COPY_STRING(config.wifi.ssid, legacy.wifi.ssid);
+    COPY_STRING(config.wifi.password, legacy.wifi.password);
+    config.wifi.autoReconnect = legacy.wifi.autoReconnect;
+    config.wifi.maxConnectionAttempts = legacy.wifi.maxConnectionAttempts;
+    config.wifi.reconnectInterval = legacy.wifi.reconnectInterval;
+    config.wifi.checkInterval = legacy.wifi.checkInterval;
+
+    COPY_STRING(config.mqtt.broker, legacy.mqtt.broker);
+    config.mqtt.port = legacy.mqtt.port;
+    COPY_STRING(config.mqtt.user, legacy.mqtt.user);
+    COPY_STRING(config.mqtt.password, legacy.mqtt.password);
+    config.mqtt.retryInterval = legacy.mqtt.retryInterval;
+    COPY_STRING(config.mqtt.baseTopic, legacy.mqtt.baseTopic);
+    config.mqtt.maxConnectionAttempts = legacy.mqtt.maxConnectionAttempts;
+
+    config.error.maxRecoveryAttempts = legacy.error.maxRecoveryAttempts;
+    config.error.recoveryInterval = legacy.error.recoveryInterval;
+
+    config.logging.allowMqttLog = legacy.logging.allowMqttLog;
+    COPY_STRING(config.logging.mqttTopic, legacy.logging.mqttTopic);
+    config.logging.logLevel = legacy.logging.logLevel;
+
+    COPY_STRING(config.update.apiUrl, legacy.update.apiUrl);
+    COPY_STRING(config.update.apiToken, legacy.update.apiToken);
+    config.update.interval = legacy.update.interval;
+    config.update.initialCheck = legacy.update.initialCheck;
+
+    COPY_STRING(config.hash, legacy.hash);
+
+    #undef COPY_STRING
+    return true;
+}
+
+void ConfigCodec::copyString(char* dest, size_t destSize, const char* src, size_t srcSize) {
+    size_t length = strnlen(src, srcSize < destSize ? srcSize : destSize - 1);
+    memcpy(dest, src, length);
+    memset(dest + length, 0, destSize - length);
+}
@@ -1,4 +1,58 @@
 #include "ConfigManager.h"
+#include "ConfigCodec.h"
+#include <ArduinoJson.h>
+#include <utility>
+
+static bool applyConfigField(RuntimeConfig& target, const ConfigField& field, JsonVariantConst value) {
+    uint8_t* destination = reinterpret_cast<uint8_t*>(&target) + field.offset;
+
+    switch (field.type) {
+        case ConfigFieldType::BOOL:
+            if (!value.is<bool>()) {
+                return false;
+            }
+            *reinterpret_cast<bool*>(destination) = value.as<bool>();
+            return true;
+        case ConfigFieldType::INTEGER: {
+            if (!value.is<long>()) {
+                return false;
+            }
+            long number = value.as<long>();
+            if (number < field.min || number > field.max) {
+                return false;
+            }
+            if (field.size == sizeof(uint8_t)) {
+                *destination = static_cast<uint8_t>(number);
+            } else if (field.size == sizeof(uint16_t)) {
+                *reinterpret_cast<uint16_t*>(destination) = static_cast<uint16_t>(number);
+            } else {
+                *reinterpret_cast<uint32_t*>(destination) = static_cast<uint32_t>(number);
+            }
+            return true;
+        }
+        case ConfigFieldType::FLOAT: {
+            if (!value.is<float>()) {
+                return false;
+            }
+            float number = value.as<float>();
+            if (number < field.min || number > field.max) {
+                return false;
+            }
+            *reinterpret_cast<float*>(destination) = number;
+            return true;
+        }
+        case ConfigFieldType::STRING: {
+            const char* text = value.as<const char*>();
+            if (!text || strlen(text) >= field.size) {
+                return false;
+            }
+            strlcpy(reinterpret_cast<char*>(destination), text, field.size);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
 
 void ConfigManager::loadDefaults() {
     setConfigFromDefines(&config);
@@ -17,6 +71,7 @@ void ConfigManager::loadDefaults() {
 void ConfigManager::print(RuntimeConfig* config) {
     Serial.printf("Device Name: %s\n", config->device.name);
     Serial.printf("Firmware Version: %s\n", config->device.firmwareVersion);
+    Serial.printf("Status Format: %d (keyframe every %d, RSSI %d dBm, heap %d B)\n", config->device.statusFormat, config->device.statusKeyframeInterval, config->device.statusRssiThreshold, config->device.statusHeapThreshold);
     Serial.printf("WiFi SSID: %s\n", config->wifi.ssid);
     Serial.printf("WiFi Password: %s\n", config->wifi.password);
     Serial.printf("WiFi Auto Reconnect: %s\n", config->wifi.autoReconnect ? "true" : "false");
@@ -29,13 +84,43 @@ void ConfigManager::print(RuntimeConfig* config) {
     Serial.printf("MQTT Password: %s\n", config->mqtt.password);
     Serial.printf("MQTT Retry Interval: %d\n", config->mqtt.retryInterval);
     Serial.printf("MQTT Base Topic: %s\n", config->mqtt.baseTopic);
+    Serial.printf("MQTT Drain Budget: %d\n", config->mqtt.drainBudget);
+    Serial.printf("MQTT Inflight Window: %d\n", config->mqtt.inflightWindow);
+    Serial.printf("MQTT Persistent Session: %s\n", config->mqtt.persistentSession ? "true" : "false");
     Serial.printf("Chip ID: %llu\n", config->device.chipID);
     Serial.printf("MAC Address: %s\n", config->device.macAddress);
+    Serial.printf("Scan Max ms per Channel: %d\n", config->scan.maxMsPerChannel);
+    Serial.printf("Scan Interval: %d\n", config->scan.interval);
+    Serial.printf("Scan Cache TTL: %d\n", config->scan.cacheTtl);
+    Serial.printf("Scan Auto Add Anchors: %s\n", config->scan.autoAddAnchors ? "true" : "false");
+    Serial.printf("FTM Frame Count: %d\n", config->ftm.frameCount);
+    Serial.printf("FTM Burst Period: %d\n", config->ftm.burstPeriod);
+    Serial.printf("FTM Request Timeout: %d\n", config->ftm.requestTimeout);
+    Serial.printf("FTM Estimator: %d (%d)\n", config->ftm.estimator, config->ftm.estimatorParam);
+    Serial.printf("FTM Min Interval: %d\n", config->ftm.minInterval);
+    Serial.printf("FTM Max Interval: %d\n", config->ftm.maxInterval);
+    Serial.printf("FTM Stable Threshold: %d\n", config->ftm.stableThreshold);
+    Serial.printf("FTM Adaptive Burst: %s (%d-%d cm, max period %d)\n", config->ftm.adaptiveBurst ? "true" : "false", config->ftm.burstLowDeviation, config->ftm.burstHighDeviation, config->ftm.maxBurstPeriod);
+    Serial.printf("FTM Metrics Interval: %d\n", config->ftm.metricsInterval);
+    Serial.printf("FTM Record Reports: %s\n", config->ftm.recordReports ? "true" : "false");
+    Serial.printf("FTM Filter Stages: 0x%02X\n", config->ftm.filterStages);
+    Serial.printf("FTM Filter Gate: %d cm (%d rejects)\n", config->ftm.filterGateThreshold, config->ftm.filterGateMaxRejects);
+    Serial.printf("FTM Filter Median Window: %d\n", config->ftm.filterMedianWindow);
+    Serial.printf("FTM Filter Kalman Noise: %.1f / %.1f\n", config->ftm.filterProcessNoise, config->ftm.filterMeasurementNoise);
+    Serial.printf("Anchor SSID: %s\n", config->anchor.ssid);
+    Serial.printf("Anchor Channel: %d\n", config->anchor.channel);
+    Serial.printf("Anchor Max Clients: %d\n", config->anchor.maxClients);
+    Serial.printf("Anchor Position: %.2f, %.2f, %.2f\n", config->anchor.x, config->anchor.y, config->anchor.z);
+    Serial.printf("Position Interval: %d\n", config->position.interval);
+    Serial.printf("Position Max Range Age: %d\n", config->position.maxRangeAge);
+    Serial.printf("Position Solve 3D: %s\n", config->position.solve3d ? "true" : "false");
+    Serial.printf("Position Tag Height: %.2f\n", config->position.tagHeight);
     Serial.printf("Error Max Recovery Attempts: %d\n", config->error.maxRecoveryAttempts);
     Serial.printf("Error Recovery Interval: %d\n", config->error.recoveryInterval);
     Serial.printf("Logging Allow MQTT Log: %s\n", config->logging.allowMqttLog ? "true" : "false");
     Serial.printf("Logging MQTT Topic: %s\n", config->logging.mqttTopic);
     Serial.printf("Logging Level: %d\n", config->logging.logLevel);
+    Serial.printf("Logging MQTT Level: %d (batch %d records / %d ms, %d B/s)\n", config->logging.mqttLevel, config->logging.mqttBatchSize, config->logging.mqttBatchInterval, config->logging.mqttRateLimit);
     Serial.printf("Update API URL: %s\n", config->update.apiUrl);
     Serial.printf("Update API Token: %s\n", config->update.apiToken);
     Serial.printf("Update Interval: %d\n", config->update.interval);
@@ -104,6 +189,10 @@ void ConfigManager::setConfigFromDefines(RuntimeConfig* config) {
     /* #### DEVICE #### */
     SAFE_STRLCPY(config->device.name, DEVICE_NAME);
     config->device.statusUpdateInterval = DEVICE_HEARTBEAT_INTERVAL;
+    config->device.statusFormat = DEVICE_STATUS_FORMAT;
+    config->device.statusKeyframeInterval = DEVICE_STATUS_KEYFRAME_INTERVAL;
+    config->device.statusRssiThreshold = DEVICE_STATUS_RSSI_THRESHOLD;
+    config->device.statusHeapThreshold = DEVICE_STATUS_HEAP_THRESHOLD;
 
     /* #### WIFI #### */
     SAFE_STRLCPY(config->wifi.ssid, WIFI_SSID);
@@ -121,6 +210,52 @@ void ConfigManager::setConfigFromDefines(RuntimeConfig* config) {
     config->mqtt.retryInterval = MQTT_RETRY_INTERVAL;
     config->mqtt.maxConnectionAttempts = MQTT_MAX_CONNECTION_ATTEMPTS;
     SAFE_STRLCPY(config->mqtt.baseTopic, MQTT_BASE_TOPIC);
+    config->mqtt.drainBudget = MQTT_DRAIN_BUDGET;
+    config->mqtt.inflightWindow = MQTT_INFLIGHT_WINDOW;
+    config->mqtt.persistentSession = MQTT_PERSISTENT_SESSION;
+
+    /* #### SCAN #### */
+    config->scan.maxMsPerChannel = SCAN_MAX_MS_PER_CHANNEL;
+    config->scan.interval = SCAN_INTERVAL;
+    config->scan.cacheTtl = SCAN_CACHE_TTL;
+    config->scan.autoAddAnchors = SCAN_AUTO_ADD_ANCHORS;
+
+    /* #### FTM #### */
+    config->ftm.frameCount = FTM_FRAME_COUNT;
+    config->ftm.burstPeriod = FTM_BURST_PERIOD;
+    config->ftm.requestTimeout = FTM_REQUEST_TIMEOUT;
+    config->ftm.estimator = FTM_ESTIMATOR;
+    config->ftm.estimatorParam = FTM_ESTIMATOR_PARAM;
+    config->ftm.minInterval = FTM_MIN_INTERVAL;
+    config->ftm.maxInterval = FTM_MAX_INTERVAL;
+    config->ftm.stableThreshold = FTM_STABLE_THRESHOLD;
+    config->ftm.adaptiveBurst = FTM_ADAPTIVE_BURST;
+    config->ftm.burstLowDeviation = FTM_BURST_LOW_DEVIATION;
+    config->ftm.burstHighDeviation = FTM_BURST_HIGH_DEVIATION;
+    config->ftm.maxBurstPeriod = FTM_MAX_BURST_PERIOD;
+    config->ftm.metricsInterval = FTM_METRICS_INTERVAL;
+    config->ftm.recordReports = FTM_RECORD_REPORTS;
+    config->ftm.filterStages = FTM_FILTER_STAGES;
+    config->ftm.filterGateThreshold = FTM_FILTER_GATE_THRESHOLD;
+    config->ftm.filterGateMaxRejects = FTM_FILTER_GATE_MAX_REJECTS;
+    config->ftm.filterMedianWindow = FTM_FILTER_MEDIAN_WINDOW;
+    config->ftm.filterProcessNoise = FTM_FILTER_PROCESS_NOISE;
+    config->ftm.filterMeasurementNoise = FTM_FILTER_MEASUREMENT_NOISE;
+
+    /* #### ANCHOR #### */
+    SAFE_STRLCPY(config->anchor.ssid, ANCHOR_SSID);
+    SAFE_STRLCPY(config->anchor.password, ANCHOR_PASSWORD);
+    config->anchor.channel = ANCHOR_CHANNEL;
+    config->anchor.maxClients = ANCHOR_MAX_CLIENTS;
+    config->anchor.x = ANCHOR_POSITION_X;
+    config->anchor.y = ANCHOR_POSITION_Y;
+    config->anchor.z = ANCHOR_POSITION_Z;
+
+    /* #### POSITION #### */
+    config->position.interval = POSITION_INTERVAL;
+    config->position.maxRangeAge = POSITION_MAX_RANGE_AGE;
+    config->position.solve3d = POSITION_SOLVE_3D;
+    config->position.tagHeight = POSITION_TAG_HEIGHT;
 
     /* #### ERROR #### */
     config->error.maxRecoveryAttempts = ERROR_MAX_RECOVERY_ATTEMPTS;
@@ -130,6 +265,10 @@ void ConfigManager::setConfigFromDefines(RuntimeConfig* config) {
     config->logging.allowMqttLog = LOGGING_ALLOW_MQTT_LOG;
     config->logging.logLevel = LOGGING_LEVEL;
     SAFE_STRLCPY(config->logging.mqttTopic, LOGGING_MQTT_TOPIC);
+    config->logging.mqttLevel = LOGGING_MQTT_LEVEL;
+    config->logging.mqttBatchSize = LOGGING_MQTT_BATCH_SIZE;
+    config->logging.mqttBatchInterval = LOGGING_MQTT_BATCH_INTERVAL;
+    config->logging.mqttRateLimit = LOGGING_MQTT_RATE_LIMIT;
 
     /* #### UPDATE #### */
     SAFE_STRLCPY(config->update.apiUrl, UPDATE_GITHUB_API_URL);
@@ -142,33 +281,61 @@ void ConfigManager::setConfigFromDefines(RuntimeConfig* config) {
 
 bool ConfigManager::loadFromFlash() {
     File file = LittleFS.open(CONFIG_FILE, "r");
-    if(!file || file.size() != sizeof(RuntimeConfig)) {
-        if (file) file.close();
+    if(!file) {
         return false;
     }
 
-    if (file.readBytes((char*)&config, sizeof(RuntimeConfig)) != sizeof(RuntimeConfig)) {
-        file.close();
+    // Fields missing from the file keep their defaults from config.
+    RuntimeConfig candidate = config;
+    ConfigDecodeInfo info;
+    bool decoded = ConfigCodec::decode([&file](uint8_t* data, size_t length) {
+        return file.read(data, length);
+    }, candidate, info);
+
+    if (!decoded && info.version == 0) {
+        // Raw struct dump from before the tagged format
+        file.seek(0);
+        decoded = ConfigCodec::decodeLegacy([&file](uint8_t* data, size_t length) {
+            return file.read(data, length);
+        }, file.size(), candidate);
+    }
+    file.close();
+
+    if (!decoded) {
+        Serial.println(F("Stored config is corrupt or from a newer firmware"));
         return false;
     }
 
-    file.close();
+    config = candidate;
+
+    if (info.version != ConfigCodec::VERSION || info.missing > 0 || info.skipped > 0) {
+        Serial.printf("Migrating config (version %d, %d missing, %d unknown fields)\n", info.version, info.missing, info.skipped);
+        if (!saveToFlash()) {
+            Serial.println(F("Failed to save migrated config"));
+        }
+    }
+
     return true;
 }
 
 bool ConfigManager::saveToFlash() {
-    File file = LittleFS.open(CONFIG_FILE, "w");
+    // Write aside and rename so a reset mid-write never leaves a torn file.
+    File file = LittleFS.open(CONFIG_TEMP_FILE, "w");
     if(!file) {
         return false;
     }
 
-    if (file.write((const uint8_t*)&config, sizeof(RuntimeConfig)) != sizeof(RuntimeConfig)) {
-        file.close();
+    bool encoded = ConfigCodec::encode(config, [&file](const uint8_t* data, size_t length) {
+        return file.write(data, length);
+    });
+    file.close();
+
+    if (!encoded) {
+        LittleFS.remove(CONFIG_TEMP_FILE);
         return false;
     }
 
-    file.close();
-    return true;
+    return LittleFS.rename(CONFIG_TEMP_FILE, CONFIG_FILE);
 }
 
 bool ConfigManager::hasConfigDefinesChanged() {
@@ -184,4 +351,128 @@ void ConfigManager::updateDeviceConfig() {
     loadDefaults();
     saveToFlash();
     Serial.println(F("Updated config"));
+}
+
+const char* ConfigManager::getSectionString(ConfigSection section) {
+    switch (section) {
+        case ConfigSection::DEVICE: return "device";
+        case ConfigSection::WIFI: return "wifi";
+        case ConfigSection::MQTT: return "mqtt";
+        case ConfigSection::SCAN: return "scan";
+        case ConfigSection::FTM: return "ftm";
+        case ConfigSection::ANCHOR: return "anchor";
+        case ConfigSection::POSITION: return "position";
+        case ConfigSection::ERROR: return "error";
+        case ConfigSection::LOGGING: return "logging";
+        case ConfigSection::UPDATE: return "update";
+        default: return "unknown";
+    }
+}
+
+bool ConfigManager::stagePatch(const uint8_t* payload, size_t length, char* error, size_t errorSize) {
+    StaticJsonDocument<1024> doc;
+    DeserializationError result = deserializeJson(doc, payload, length);
+    if (result) {
+        snprintf(error, errorSize, "Invalid JSON: %s", result.c_str());
+        return false;
+    }
+
+    JsonObjectConst patch = doc.as<JsonObjectConst>();
+    if (patch.isNull()) {
+        snprintf(error, errorSize, "Patch must be a JSON object");
+        return false;
+    }
+
+    // Patches arriving before the pending one was applied stack on top of it.
+    RuntimeConfig candidate = pendingSections != 0 ? shadow : config;
+    uint16_t sections = 0;
+
+    for (JsonPairConst group : patch) {
+        ConfigSection section = ConfigSection::__DELIMITER__;
+        for (size_t i = 0; i < getSectionCount(); i++) {
+            if (strcmp(group.key().c_str(), getSectionString(static_cast<ConfigSection>(i))) == 0) {
+                section = static_cast<ConfigSection>(i);
+                break;
+            }
+        }
+        if (section == ConfigSection::__DELIMITER__) {
+            snprintf(error, errorSize, "Unknown section '%s'", group.key().c_str());
+            return false;
+        }
+
+        JsonObjectConst fields = group.value().as<JsonObjectConst>();
+        if (fields.isNull()) {
+            snprintf(error, errorSize, "Section '%s' must be an object", group.key().c_str());
+            return false;
+        }
+
+        for (JsonPairConst entry : fields) {
+            const ConfigField* field = ConfigCodec::findField(section, entry.key().c_str());
+            if (!field || !field->writable) {
+                snprintf(error, errorSize, "Unknown or read-only field '%s.%s'", group.key().c_str(), entry.key().c_str());
+                return false;
+            }
+            if (!applyConfigField(candidate, *field, entry.value())) {
+                snprintf(error, errorSize, "Invalid value for '%s.%s'", group.key().c_str(), entry.key().c_str());
+                return false;
+            }
+            sections |= sectionMask(section);
+        }
+    }
+
+    if (!validate(candidate, error, errorSize)) {
+        return false;
+    }
+
+    shadow = candidate;
+    pendingSections |= sections;
+    return true;
+}
+
+bool ConfigManager::validate(const RuntimeConfig& candidate, char* error, size_t errorSize) {
+    if (candidate.ftm.minInterval > candidate.ftm.maxInterval) {
+        snprintf(error, errorSize, "ftm.minInterval exceeds ftm.maxInterval");
+        return false;
+    }
+    if (candidate.ftm.burstLowDeviation > candidate.ftm.burstHighDeviation) {
+        snprintf(error, errorSize, "ftm.burstLowDeviation exceeds ftm.burstHighDeviation");
+        return false;
+    }
+    return true;
+}
+
+uint16_t ConfigManager::applyPendingPatch() {
+    if (pendingSections == 0) {
+        return 0;
+    }
+
+    uint16_t sections = pendingSections;
+    pendingSections = 0;
+
+    // shadow keeps the previous config so listeners can diff against it
+    std::swap(config, shadow);
+
+    if (!saveToFlash()) {
+        Serial.println(F("Failed to save config to flash"));
+    }
+
+    for (uint8_t i = 0; i < listenerCount; i++) {
+        if (listeners[i].sections & sections) {
+            listeners[i].listener(shadow, config);
+        }
+    }
+
+    return sections;
+}
+
+bool ConfigManager::addListener(uint16_t sections, ConfigListener listener) {
+    if (listenerCount >= MAX_LISTENERS) {
+        Serial.println(F("Config listener table full"));
+        return false;
+    }
+
+    listeners[listenerCount].sections = sections;
+    listeners[listenerCount].listener = listener;
+    listenerCount++;
+    return true;
 }
\ No newline at end of file
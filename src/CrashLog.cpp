@@ -0,0 +1,211 @@
+#include "CrashLog.h"
+#include <esp_attr.h>
+
+struct CrashLogStore {
+    uint32_t magic;
+    uint16_t capacity;
+    uint16_t entrySize;
+    uint32_t bootCount;
+    CrashLogEntry entries[CrashLog::CAPACITY];
+};
+
+// Not cleared on reset; only a cold boot leaves it undefined, which the
+// magic and layout fields catch.
+RTC_NOINIT_ATTR static CrashLogStore crashLogStore;
+
+const char* CrashLog::getResetReasonString(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON: return "POWERON";
+        case ESP_RST_EXT: return "EXT";
+        case ESP_RST_SW: return "SW";
+        case ESP_RST_PANIC: return "PANIC";
+        case ESP_RST_INT_WDT: return "INT_WDT";
+        case ESP_RST_TASK_WDT: return "TASK_WDT";
+        case ESP_RST_WDT: return "WDT";
+        case ESP_RST_DEEPSLEEP: return "DEEPSLEEP";
+        case ESP_RST_BROWNOUT: return "BROWNOUT";
+        case ESP_RST_SDIO: return "SDIO";
+        default: return "UNKNOWN";
+    }
+}
+
+bool CrashLog::begin() {
+    if (initialized) {
+        return true;
+    }
+
+    resetReason = esp_reset_reason();
+    takeOver();
+    uploadPending = true;
+    initialized = true;
+
+    // Written where the record is created rather than from a sink, since
+    // the drain task may never run again before a panic or watchdog reset.
+    log.setRecordHook(onLogRecord);
+
+    return true;
+}
+
+void CrashLog::takeOver() {
+    CrashLogStore& store = crashLogStore;
+    bool valid = resetReason != ESP_RST_POWERON
+        && store.magic == MAGIC
+        && store.capacity == CAPACITY
+        && store.entrySize == sizeof(CrashLogEntry);
+
+    bootCount = valid ? store.bootCount + 1 : 1;
+
+    if (valid) {
+        uint32_t last = 0;
+        for (uint8_t i = 0; i < CAPACITY; i++) {
+            if (store.entries[i].sequence != 0) {
+                previousCount++;
+                if (store.entries[i].sequence > last) {
+                    last = store.entries[i].sequence;
+                }
+            }
+        }
+
+        // Sequence n lives in slot (n - 1) % CAPACITY, so the oldest entry
+        // follows the newest one.
+        if (previousCount > 0) {
+            previous = new CrashLogEntry[previousCount];
+            uint8_t copied = 0;
+            for (uint8_t i = 0; i < CAPACITY && copied < previousCount; i++) {
+                const CrashLogEntry& entry = store.entries[(last + i) % CAPACITY];
+                if (entry.sequence != 0) {
+                    previous[copied++] = entry;
+                }
+            }
+        }
+    }
+
+    memset(&store, 0, sizeof(store));
+    store.magic = MAGIC;
+    store.capacity = CAPACITY;
+    store.entrySize = sizeof(CrashLogEntry);
+    store.bootCount = bootCount;
+}
+
+void CrashLog::recordState(const char* state) {
+    record(CrashLogKind::STATE, static_cast<uint8_t>(LogLevel::INFO), "Device", state);
+}
+
+void CrashLog::onLogRecord(const LogRecord& record) {
+    getInstance().recordLog(record);
+}
+
+// Called from whichever task logs and from the application loop. Slots are
+// claimed with a single atomic increment; the sequence is written last so
+// an entry torn by a reset reads as empty.
+void CrashLog::record(CrashLogKind kind, uint8_t level, const char* source, const char* message) {
+    if (!initialized) {
+        return;
+    }
+
+    uint32_t sequence;
+    CrashLogEntry& entry = claimEntry(kind, level, source, sequence);
+    strlcpy(entry.message, message, sizeof(entry.message));
+    commitEntry(entry, sequence);
+}
+
+void CrashLog::recordLog(const LogRecord& record) {
+    if (!initialized || static_cast<int>(record.level) < static_cast<int>(LogLevel::INFO)) {
+        return;
+    }
+
+    uint32_t sequence;
+    CrashLogEntry& entry = claimEntry(CrashLogKind::LOG, static_cast<uint8_t>(record.level), record.source, sequence);
+
+    // Binary records render straight into the entry, truncated to its size.
+    const char* message = Logger::getMessage(record, entry.message, sizeof(entry.message));
+    if (message != entry.message) {
+        strlcpy(entry.message, message, sizeof(entry.message));
+    }
+    commitEntry(entry, sequence);
+}
+
+CrashLogEntry& CrashLog::claimEntry(CrashLogKind kind, uint8_t level, const char* source, uint32_t& sequence) {
+    sequence = nextSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+    CrashLogEntry& entry = crashLogStore.entries[(sequence - 1) % CAPACITY];
+
+    entry.sequence = 0;
+    entry.timestamp = millis();
+    entry.kind = kind;
+    entry.level = level;
+    strlcpy(entry.source, source, sizeof(entry.source));
+    return entry;
+}
+
+void CrashLog::commitEntry(CrashLogEntry& entry, uint32_t sequence) {
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.sequence = sequence;
+}
+
+void CrashLog::update() {
+    if (!uploadPending || !mqttManager.isConnected()) {
+        return;
+    }
+
+    if (topic == MQTTManager::INVALID_TOPIC) {
+        topic = mqttManager.registerTopic("crashlog");
+        if (topic == MQTTManager::INVALID_TOPIC) {
+            return;
+        }
+    }
+
+    // One message per call; a failed publish is retried on the next one.
+    if (!publishPart()) {
+        return;
+    }
+
+    if (uploadOffset < previousCount) {
+        return;
+    }
+
+    LOG_INFO("CrashLog", "Uploaded %u entries from boot %" PRIu32 " (reset reason %s)",
+        previousCount, bootCount - 1, getResetReasonString(resetReason));
+
+    delete[] previous;
+    previous = nullptr;
+    previousCount = 0;
+    uploadPending = false;
+}
+
+bool CrashLog::publishPart() {
+    StaticJsonDocument<1024> doc;
+    doc["boot"] = bootCount;
+    doc["reason"] = getResetReasonString(resetReason);
+    doc["part"] = uploadPart;
+    JsonArray entries = doc.createNestedArray("entries");
+
+    uint8_t offset = uploadOffset;
+    while (offset < previousCount) {
+        const CrashLogEntry& entry = previous[offset];
+        JsonArray row = entries.createNestedArray();
+        row.add(entry.timestamp);
+        row.add(entry.kind == CrashLogKind::STATE ? "STATE" : Logger::getLogLevelString(static_cast<LogLevel>(entry.level)));
+        row.add(static_cast<const char*>(entry.source));
+        row.add(static_cast<const char*>(entry.message));
+
+        // Leave room for the trailing "last" flag.
+        if (measureJson(doc) + 12 > MAX_PAYLOAD_LENGTH) {
+            entries.remove(entries.size() - 1);
+            if (offset > uploadOffset) {
+                break;
+            }
+        }
+        offset++;
+    }
+    doc["last"] = offset >= previousCount;
+
+    char payload[MAX_PAYLOAD_LENGTH + 1];
+    size_t length = serializeJson(doc, payload, sizeof(payload));
+    if (!mqttManager.publish(topic, payload, length, false, MQTTPriority::NORMAL, 1)) {
+        return false;
+    }
+
+    uploadOffset = offset;
+    uploadPart++;
+    return true;
+}
@@ -6,6 +6,7 @@ void Device::changeState(DeviceState& newState) {
     }
 
     currentState = &newState;
+    crashLog.recordState(currentState->getStateIdentifierString());
     
     if(currentState){
         currentState->enter();
@@ -13,10 +14,20 @@ void Device::changeState(DeviceState& newState) {
 }
 
 void Device::update() {
+    uint16_t sections = configManager.applyPendingPatch();
+    if (sections != 0) {
+        LOG_INFO("Device", "Applied config update (sections 0x%03X)", sections);
+    }
+
     if (currentState) {
         currentState->update();
     }
 
+#if DEVICE_TYPE != DEVICE_TYPE_ANCHOR
+    rpcManager.update();
+    logSink.update();
+    crashLog.update();
+
     RuntimeConfig& config = configManager.getRuntimeConfig();
 
     uint32_t now = millis();
@@ -24,28 +35,93 @@ void Device::update() {
         sendDeviceStatus();
         lastStatusUpdate = now;
     }
+#endif
 }
 
 void Device::sendDeviceStatus(){
+    RuntimeConfig& config = configManager.getRuntimeConfig();
     StaticJsonDocument<JSON_DOC_SIZE> doc;
-    
-    doc["status"] = "online";
+
+    StatusSnapshot current;
+    current.state = currentState ? currentState->getStateIdentifierString() : "UNKNOWN";
+    current.rssi = WiFi.RSSI();
+    current.heapFree = ESP.getFreeHeap();
+    current.heapMinFree = ESP.getMinFreeHeap();
+    current.heapMaxAlloc = ESP.getMaxAllocHeap();
+
+    // Keyframes carry every field and are retained; deltas only carry fields
+    // that moved past their threshold, so late subscribers still see a full status.
+    bool keyframe = config.device.statusKeyframeInterval <= 1 || statusCount % config.device.statusKeyframeInterval == 0;
+    statusCount++;
+
     doc["uptime"] = millis();
-    doc["rssi"] = WiFi.RSSI();
-    doc["state"] = currentState ? currentState->getStateIdentifierString() : "UNKNOWN";
-    
-    JsonObject heap = doc.createNestedObject("heap");
-    heap["free"] = ESP.getFreeHeap();
-    heap["min_free"] = ESP.getMinFreeHeap();
-    heap["max_alloc"] = ESP.getMaxAllocHeap();
 
-    String payload;
-    serializeJson(doc, payload);
+    if (keyframe) {
+        doc["status"] = "online";
+        doc["full"] = true;
+    }
+    if (keyframe || strcmp(current.state, lastStatus.state) != 0) {
+        doc["state"] = current.state;
+    }
+    if (keyframe || abs(current.rssi - lastStatus.rssi) >= config.device.statusRssiThreshold) {
+        doc["rssi"] = current.rssi;
+    } else {
+        current.rssi = lastStatus.rssi;
+    }
 
-    log.debug("Device", payload.c_str());
+    bool heapChanged = exceeds(current.heapFree, lastStatus.heapFree, config.device.statusHeapThreshold)
+        || exceeds(current.heapMinFree, lastStatus.heapMinFree, config.device.statusHeapThreshold)
+        || exceeds(current.heapMaxAlloc, lastStatus.heapMaxAlloc, config.device.statusHeapThreshold);
+    if (keyframe || heapChanged) {
+        JsonObject heap = doc.createNestedObject("heap");
+        heap["free"] = current.heapFree;
+        heap["min_free"] = current.heapMinFree;
+        heap["max_alloc"] = current.heapMaxAlloc;
+    } else {
+        current.heapFree = lastStatus.heapFree;
+        current.heapMinFree = lastStatus.heapMinFree;
+        current.heapMaxAlloc = lastStatus.heapMaxAlloc;
+    }
+
+    if (keyframe) {
+        const MQTTQueueStats& queueStats = mqttManager.getQueueStats();
+        JsonObject queue = doc.createNestedObject("mqtt");
+        queue["depth"] = queueStats.depth;
+        queue["high_water"] = queueStats.highWater;
+        queue["sent"] = queueStats.sent;
+        queue["dropped"] = queueStats.dropped;
+        queue["failed"] = queueStats.failed;
+        queue["inflight"] = queueStats.inFlight;
+        queue["acked"] = queueStats.acknowledged;
+        queue["retransmits"] = queueStats.retransmits;
+        queue["cmd_overruns"] = mqttManager.getCommandOverruns();
+        queue["rx_dropped"] = mqttManager.getInboundDropped();
+        queue["rate"] = queueStats.drainRate;
+
+        doc["log_dropped"] = log.getDroppedRecords();
+        doc["log_mqtt_dropped"] = logSink.getDroppedRecords();
+    }
+
+    lastStatus = current;
 
-    if (mqttManager.isConnected()) {
-        RuntimeConfig& config = configManager.getRuntimeConfig();
-        mqttManager.publish("status", payload.c_str(), true);
+    char payload[JSON_DOC_SIZE];
+    size_t length;
+    if (static_cast<StatusFormat>(config.device.statusFormat) == StatusFormat::MSGPACK) {
+        length = serializeMsgPack(doc, payload, sizeof(payload));
+    } else {
+        length = serializeJson(doc, payload, sizeof(payload));
+        LOG_DEBUG("Device", "%s", payload);
     }
-}
\ No newline at end of file
+
+    if (statusTopic == MQTTManager::INVALID_TOPIC && mqttManager.isInitialized()) {
+        statusTopic = mqttManager.registerTopic("status");
+    }
+    if (statusTopic != MQTTManager::INVALID_TOPIC) {
+        mqttManager.publish(statusTopic, payload, length, keyframe, MQTTPriority::BACKGROUND);
+    }
+}
+
+bool Device::exceeds(uint32_t current, uint32_t previous, uint32_t threshold) {
+    uint32_t delta = current > previous ? current - previous : previous - current;
+    return delta >= threshold;
+}
@@ -0,0 +1,93 @@
+#include "FtmBurstController.h"
+#include <math.h>
+
+// Frame counts accepted by the ESP-IDF FTM initiator, cheapest first.
+static const uint8_t FRAME_LEVELS[FtmBurstController::LEVEL_COUNT] = {16, 24, 32, 64};
+static const float SMOOTHING = 0.2f;
+static const float FAILURE_HIGH = 0.5f;
+static const float FAILURE_LOW = 0.1f;
+
+void FtmBurstController::reset() {
+    level = 0;
+    quietSessions = 0;
+    initialized = false;
+    variance = 0.0f;
+
+    metrics.frameCount = FRAME_LEVELS[0];
+    metrics.burstPeriod = MIN_BURST_PERIOD;
+    metrics.deviationCm = 0.0f;
+    metrics.failureRate = 0.0f;
+    metrics.rampUps = 0;
+    metrics.rampDowns = 0;
+}
+
+void FtmBurstController::onSuccess(float innovationCm, const FtmBurstConfig& config) {
+    float squared = innovationCm * innovationCm;
+    variance = initialized ? variance + SMOOTHING * (squared - variance) : squared;
+    initialized = true;
+
+    metrics.deviationCm = sqrtf(variance);
+    metrics.failureRate *= (1.0f - SMOOTHING);
+
+    if (metrics.deviationCm > config.highDeviation) {
+        quietSessions = 0;
+        rampUp();
+    } else if (metrics.deviationCm < config.lowDeviation && metrics.failureRate < FAILURE_LOW) {
+        if (++quietSessions >= QUIET_SESSIONS) {
+            quietSessions = 0;
+            rampDown();
+        }
+    } else {
+        quietSessions = 0;
+    }
+
+    publish(config);
+}
+
+void FtmBurstController::onFailure(const FtmBurstConfig& config) {
+    metrics.failureRate += SMOOTHING * (1.0f - metrics.failureRate);
+    quietSessions = 0;
+
+    publish(config);
+}
+
+void FtmBurstController::rampUp() {
+    if (level + 1 < LEVEL_COUNT) {
+        level++;
+        metrics.rampUps++;
+    }
+}
+
+void FtmBurstController::rampDown() {
+    if (level > 0) {
+        level--;
+        metrics.rampDowns++;
+    }
+}
+
+void FtmBurstController::publish(const FtmBurstConfig& config) {
+    metrics.frameCount = getFrameCount(config);
+    metrics.burstPeriod = getBurstPeriod(config);
+}
+
+uint8_t FtmBurstController::getFrameCount(const FtmBurstConfig& config) const {
+    if (!config.enabled) {
+        return config.frameCount;
+    }
+    return FRAME_LEVELS[level];
+}
+
+uint16_t FtmBurstController::getBurstPeriod(const FtmBurstConfig& config) const {
+    if (!config.enabled) {
+        return config.burstPeriod;
+    }
+
+    // Failing responders get more time between bursts instead of more frames per burst.
+    uint16_t period = MIN_BURST_PERIOD;
+    if (metrics.failureRate > FAILURE_HIGH) {
+        period = config.maxBurstPeriod;
+    } else if (metrics.failureRate > FAILURE_LOW) {
+        period = (MIN_BURST_PERIOD + config.maxBurstPeriod) / 2;
+    }
+    return period;
+}
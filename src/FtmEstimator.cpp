@@ -0,0 +1,116 @@
+#include "FtmEstimator.h"
+#include <math.h>
+
+const char* FtmEstimator::getMethodString(FtmEstimatorMethod method) {
+    switch (method) {
+        case FtmEstimatorMethod::FIRMWARE: return "FIRMWARE";
+        case FtmEstimatorMethod::MIN_RTT: return "MIN_RTT";
+        case FtmEstimatorMethod::TRIMMED_MEAN: return "TRIMMED_MEAN";
+        case FtmEstimatorMethod::PERCENTILE: return "PERCENTILE";
+        case FtmEstimatorMethod::RSSI_WEIGHTED: return "RSSI_WEIGHTED";
+        default: return "UNKNOWN";
+    }
+}
+
+bool FtmEstimator::estimateFromSamples(uint32_t* rtt, int8_t* rssi, uint8_t count, FtmEstimatorMethod method, uint8_t param, FtmEstimate& estimate) {
+    estimate.rttPs = 0;
+    estimate.distanceCm = 0;
+    estimate.validFrames = count;
+    estimate.meanRssi = 0;
+
+    if (count == 0) {
+        return false;
+    }
+
+    int32_t rssiSum = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        rssiSum += rssi[i];
+    }
+    estimate.meanRssi = static_cast<int8_t>(rssiSum / count);
+
+    switch (method) {
+        case FtmEstimatorMethod::MIN_RTT:
+            estimate.rttPs = minRtt(rtt, count);
+            break;
+        case FtmEstimatorMethod::TRIMMED_MEAN:
+            sortSamples(rtt, rssi, count);
+            estimate.rttPs = trimmedMean(rtt, count, param);
+            break;
+        case FtmEstimatorMethod::PERCENTILE:
+            sortSamples(rtt, rssi, count);
+            estimate.rttPs = percentile(rtt, count, param);
+            break;
+        case FtmEstimatorMethod::RSSI_WEIGHTED:
+            estimate.rttPs = rssiWeighted(rtt, rssi, count);
+            break;
+        default:
+            return false;
+    }
+
+    estimate.distanceCm = rttToDistanceCm(estimate.rttPs);
+    return true;
+}
+
+void FtmEstimator::sortSamples(uint32_t* rtt, int8_t* rssi, uint8_t count) {
+    for (uint8_t i = 1; i < count; i++) {
+        uint32_t key = rtt[i];
+        int8_t keyRssi = rssi[i];
+        int16_t j = i - 1;
+
+        while (j >= 0 && rtt[j] > key) {
+            rtt[j + 1] = rtt[j];
+            rssi[j + 1] = rssi[j];
+            j--;
+        }
+        rtt[j + 1] = key;
+        rssi[j + 1] = keyRssi;
+    }
+}
+
+uint32_t FtmEstimator::minRtt(const uint32_t* rtt, uint8_t count) {
+    uint32_t minimum = rtt[0];
+    for (uint8_t i = 1; i < count; i++) {
+        if (rtt[i] < minimum) {
+            minimum = rtt[i];
+        }
+    }
+    return minimum;
+}
+
+uint32_t FtmEstimator::trimmedMean(const uint32_t* sorted, uint8_t count, uint8_t trimPercent) {
+    if (trimPercent > 45) {
+        trimPercent = 45;
+    }
+
+    uint8_t trim = (count * trimPercent) / 100;
+    uint64_t sum = 0;
+    for (uint8_t i = trim; i < count - trim; i++) {
+        sum += sorted[i];
+    }
+    return static_cast<uint32_t>(sum / (count - 2 * trim));
+}
+
+uint32_t FtmEstimator::percentile(const uint32_t* sorted, uint8_t count, uint8_t percent) {
+    if (percent > 100) {
+        percent = 100;
+    }
+    return sorted[((count - 1) * percent + 50) / 100];
+}
+
+uint32_t FtmEstimator::rssiWeighted(const uint32_t* rtt, const int8_t* rssi, uint8_t count) {
+    int8_t maxRssi = rssi[0];
+    for (uint8_t i = 1; i < count; i++) {
+        if (rssi[i] > maxRssi) {
+            maxRssi = rssi[i];
+        }
+    }
+
+    float weightedSum = 0.0f;
+    float weightSum = 0.0f;
+    for (uint8_t i = 0; i < count; i++) {
+        float weight = powf(10.0f, (rssi[i] - maxRssi) / 20.0f);
+        weightedSum += weight * rtt[i];
+        weightSum += weight;
+    }
+    return static_cast<uint32_t>(weightedSum / weightSum);
+}
@@ -0,0 +1,265 @@
+#include "FtmRangingEngine.h"
+
+FtmRangingEngine::FtmRangingEngine()
+    : inFlight(nullptr)
+    , nextRequestId(1)
+    , initiator(nullptr)
+    , terminator(nullptr)
+    , abandoned(false)
+    , abandonedAt(0)
+    , reportReady(false)
+    , overruns(0) {
+    memset(&stats, 0, sizeof(stats));
+    memset(&pendingReport, 0, sizeof(pendingReport));
+
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        slots[i].result.state = FtmRequestState::FREE;
+    }
+}
+
+const char* FtmRangingEngine::getRequestStateString(FtmRequestState state) const {
+    switch (state) {
+        case FtmRequestState::FREE: return "FREE";
+        case FtmRequestState::PENDING: return "PENDING";
+        case FtmRequestState::IN_FLIGHT: return "IN_FLIGHT";
+        case FtmRequestState::COMPLETED: return "COMPLETED";
+        case FtmRequestState::FAILED: return "FAILED";
+        case FtmRequestState::TIMED_OUT: return "TIMED_OUT";
+        case FtmRequestState::CANCELLED: return "CANCELLED";
+        default: return "UNKNOWN";
+    }
+}
+
+uint32_t FtmRangingEngine::submit(const FtmRequest& request, uint32_t now, FtmCallback callback) {
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        Slot& slot = slots[i];
+        if (slot.result.state != FtmRequestState::FREE) {
+            continue;
+        }
+
+        slot.request = request;
+        slot.callback = callback;
+
+        memset(&slot.result, 0, sizeof(slot.result));
+        slot.result.requestId = nextRequestId++;
+        slot.result.state = FtmRequestState::PENDING;
+        slot.result.submittedAt = now;
+        memcpy(slot.result.bssid, request.bssid, sizeof(slot.result.bssid));
+
+        if (nextRequestId == 0) {
+            nextRequestId = 1;
+        }
+
+        stats.submitted++;
+        return slot.result.requestId;
+    }
+
+    stats.rejected++;
+    return 0;
+}
+
+bool FtmRangingEngine::poll(uint32_t requestId, FtmResult& result) {
+    Slot* slot = findSlot(requestId);
+    if (!slot) {
+        result.requestId = requestId;
+        result.state = FtmRequestState::FREE;
+        return false;
+    }
+
+    result = slot->result;
+    if (result.state == FtmRequestState::PENDING || result.state == FtmRequestState::IN_FLIGHT) {
+        return false;
+    }
+
+    slot->result.state = FtmRequestState::FREE;
+    return true;
+}
+
+bool FtmRangingEngine::cancel(uint32_t requestId, uint32_t now) {
+    Slot* slot = findSlot(requestId);
+    if (!slot) {
+        return false;
+    }
+
+    bool active = slot->result.state == FtmRequestState::PENDING || slot->result.state == FtmRequestState::IN_FLIGHT;
+    bool notify = slot->callback != nullptr;
+    if (active) {
+        complete(slot, FtmRequestState::CANCELLED, now);
+    }
+
+    // Polled requests have nobody left to collect the result.
+    if (!active || !notify) {
+        slot->result.state = FtmRequestState::FREE;
+    }
+    return true;
+}
+
+void FtmRangingEngine::onReport(const FtmReport& report) {
+    if (reportReady.load(std::memory_order_acquire)) {
+        overruns.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    pendingReport = report;
+    reportReady.store(true, std::memory_order_release);
+}
+
+void FtmRangingEngine::update(uint32_t now) {
+    consumeReport(now);
+
+    // The timeout covers the session itself; time spent queued behind other
+    // requests does not count against it.
+    if (inFlight && now - inFlight->result.startedAt >= inFlight->request.timeout) {
+        complete(inFlight, FtmRequestState::TIMED_OUT, now);
+    }
+
+    if (abandoned && now - abandonedAt >= SESSION_GRACE_PERIOD) {
+        abandoned = false;
+    }
+
+    if (!inFlight && !abandoned) {
+        Slot* slot = nextPending();
+        if (slot) {
+            start(slot, now);
+        }
+    }
+}
+
+uint8_t FtmRangingEngine::getQueuedCount() const {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        if (slots[i].result.state == FtmRequestState::PENDING) {
+            count++;
+        }
+    }
+    return count;
+}
+
+FtmRangingEngine::Slot* FtmRangingEngine::findSlot(uint32_t requestId) {
+    if (requestId == 0) {
+        return nullptr;
+    }
+
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        if (slots[i].result.state != FtmRequestState::FREE && slots[i].result.requestId == requestId) {
+            return &slots[i];
+        }
+    }
+    return nullptr;
+}
+
+FtmRangingEngine::Slot* FtmRangingEngine::nextPending() {
+    Slot* oldest = nullptr;
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        Slot& slot = slots[i];
+        if (slot.result.state != FtmRequestState::PENDING) {
+            continue;
+        }
+        if (!oldest || static_cast<int32_t>(slot.result.requestId - oldest->result.requestId) < 0) {
+            oldest = &slot;
+        }
+    }
+    return oldest;
+}
+
+void FtmRangingEngine::start(Slot* slot, uint32_t now) {
+    slot->result.startedAt = now;
+
+    if (!initiator || !initiator(slot->request)) {
+        complete(slot, FtmRequestState::FAILED, now);
+        return;
+    }
+
+    slot->result.state = FtmRequestState::IN_FLIGHT;
+    inFlight = slot;
+}
+
+void FtmRangingEngine::complete(Slot* slot, FtmRequestState state, uint32_t now) {
+    if (slot == inFlight) {
+        inFlight = nullptr;
+        if (state == FtmRequestState::TIMED_OUT || state == FtmRequestState::CANCELLED) {
+            abandon(now);
+        }
+    }
+
+    slot->result.state = state;
+    slot->result.completedAt = now;
+
+    switch (state) {
+        case FtmRequestState::COMPLETED: {
+            uint32_t latency = now - slot->result.submittedAt;
+            stats.completed++;
+            stats.totalLatency += latency;
+            if (latency > stats.maxLatency) {
+                stats.maxLatency = latency;
+            }
+            break;
+        }
+        case FtmRequestState::TIMED_OUT:
+            stats.timedOut++;
+            break;
+        case FtmRequestState::CANCELLED:
+            stats.cancelled++;
+            break;
+        default:
+            stats.failed++;
+            break;
+    }
+
+    if (slot->callback) {
+        FtmCallback callback = slot->callback;
+        FtmResult result = slot->result;
+
+        slot->callback = nullptr;
+        slot->result.state = FtmRequestState::FREE;
+        callback(result);
+    }
+}
+
+void FtmRangingEngine::abandon(uint32_t now) {
+    abandoned = true;
+    abandonedAt = now;
+
+    if (terminator) {
+        terminator();
+    }
+}
+
+void FtmRangingEngine::consumeReport(uint32_t now) {
+    stats.droppedReports += overruns.exchange(0, std::memory_order_relaxed);
+
+    if (!reportReady.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    FtmReport report = pendingReport;
+    reportReady.store(false, std::memory_order_release);
+
+    // Only one session runs at a time, so this is the abandoned one's.
+    if (abandoned) {
+        abandoned = false;
+        stats.staleReports++;
+        return;
+    }
+
+    if (!inFlight) {
+        stats.droppedReports++;
+        return;
+    }
+
+    FtmRequest& request = inFlight->request;
+    if (!request.useConnectedAp && memcmp(request.bssid, report.peer, sizeof(report.peer)) != 0) {
+        stats.droppedReports++;
+        return;
+    }
+
+    FtmResult& result = inFlight->result;
+    memcpy(result.bssid, report.peer, sizeof(result.bssid));
+    result.status = report.status;
+    result.rttNs = report.rttNs;
+    result.distanceCm = report.distanceCm;
+    result.frames = report.frames;
+    result.rssi = report.rssi;
+
+    complete(inFlight, report.status == FTM_STATUS_OK ? FtmRequestState::COMPLETED : FtmRequestState::FAILED, now);
+}
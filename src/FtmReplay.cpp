@@ -0,0 +1,206 @@
+#include "FtmReplay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+FtmReplay::FtmReplay(FtmReplayClock clock)
+    : clock(clock)
+    , scheduler(engine)
+    , solve3d(false)
+    , tagHeight(0.0f)
+    , positionInterval(1000)
+    , maxRangeAge(5000)
+    , lastFix(0)
+    , hasTruth(false) {
+    memset(&stats, 0, sizeof(stats));
+    memset(truth, 0, sizeof(truth));
+
+    engine.setInitiator([](const FtmRequest&) {
+        return true;
+    });
+}
+
+void FtmReplay::configure(const FtmReplayConfig& config) {
+    scheduler.configure(config.scheduler);
+    solve3d = config.solve3d;
+    tagHeight = config.tagHeight;
+    positionInterval = config.positionInterval;
+    maxRangeAge = config.maxRangeAge;
+}
+
+bool FtmReplay::feedLine(const char* line) {
+    char buffer[MAX_LINE_LENGTH];
+    strncpy(buffer, line, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    buffer[strcspn(buffer, "\r\n")] = '\0';
+
+    if (buffer[0] == '\0' || buffer[0] == '#') {
+        return true;
+    }
+
+    stats.lines++;
+
+    bool parsed = false;
+    if (strncmp(buffer, "anchor,", 7) == 0) {
+        parsed = parseAnchor(buffer + 7);
+    } else if (strncmp(buffer, "report,", 7) == 0) {
+        parsed = parseReport(buffer + 7);
+    }
+
+    if (!parsed) {
+        stats.parseErrors++;
+    }
+    return parsed;
+}
+
+bool FtmReplay::parseAnchor(char* fields) {
+    char* context = nullptr;
+    const char* bssidText = strtok_r(fields, ",", &context);
+    const char* channelText = strtok_r(nullptr, ",", &context);
+    const char* xText = strtok_r(nullptr, ",", &context);
+    const char* yText = strtok_r(nullptr, ",", &context);
+    const char* zText = strtok_r(nullptr, ",", &context);
+
+    uint8_t bssid[6];
+    if (!bssidText || !channelText || !parseBssid(bssidText, bssid)) {
+        return false;
+    }
+
+    if (!scheduler.addAnchor(bssid, atoi(channelText))) {
+        return false;
+    }
+    if (xText && yText && zText) {
+        scheduler.setAnchorPosition(bssid, strtof(xText, nullptr), strtof(yText, nullptr), strtof(zText, nullptr));
+    }
+
+    stats.anchors++;
+    return true;
+}
+
+bool FtmReplay::parseReport(char* fields) {
+    char* context = nullptr;
+    const char* values[10] = {nullptr};
+    uint8_t count = 0;
+
+    for (char* token = strtok_r(fields, ",", &context); token && count < 10; token = strtok_r(nullptr, ",", &context)) {
+        values[count++] = token;
+    }
+
+    if (count < 7) {
+        return false;
+    }
+
+    FtmReport report;
+    if (!parseBssid(values[1], report.peer)) {
+        return false;
+    }
+
+    uint32_t timestamp = strtoul(values[0], nullptr, 10);
+    report.status = atoi(values[2]);
+    report.rttNs = strtoul(values[3], nullptr, 10);
+    report.distanceCm = strtoul(values[4], nullptr, 10);
+    report.frames = atoi(values[5]);
+    report.rssi = atoi(values[6]);
+
+    hasTruth = count >= 9;
+    if (hasTruth) {
+        truth[0] = strtof(values[7], nullptr);
+        truth[1] = strtof(values[8], nullptr);
+        truth[2] = count >= 10 ? strtof(values[9], nullptr) : tagHeight;
+    }
+
+    if (stats.reports == 0) {
+        stats.firstTimestamp = timestamp;
+        lastFix = timestamp;
+    }
+    stats.lastTimestamp = timestamp;
+    stats.reports++;
+
+    replayReport(report, timestamp);
+    solve(timestamp);
+    return true;
+}
+
+void FtmReplay::replayReport(const FtmReport& report, uint32_t timestamp) {
+    const FtmAnchor* anchor = scheduler.findAnchor(report.peer);
+
+    FtmRequest request;
+    memcpy(request.bssid, report.peer, sizeof(request.bssid));
+    request.channel = anchor ? anchor->channel : 0;
+    request.useConnectedAp = false;
+    request.frameCount = report.frames;
+    request.burstPeriod = 0;
+    request.timeout = UINT32_MAX;
+
+    uint32_t pipelineMicros = 0;
+    uint32_t start = clock();
+
+    engine.submit(request, timestamp, [this, &pipelineMicros](const FtmResult& result) {
+        uint32_t pipelineStart = clock();
+        scheduler.handleResult(result);
+        pipelineMicros = clock() - pipelineStart;
+    });
+    engine.update(timestamp);
+    engine.onReport(report);
+    engine.update(timestamp);
+
+    record(stats.engine, clock() - start - pipelineMicros);
+    record(stats.pipeline, pipelineMicros);
+}
+
+void FtmReplay::solve(uint32_t timestamp) {
+    if (timestamp - lastFix < positionInterval) {
+        return;
+    }
+    lastFix = timestamp;
+
+    uint32_t start = clock();
+
+    multilateration.clear();
+    multilateration.setHeight(tagHeight);
+    scheduler.collectRanges(multilateration, timestamp, maxRangeAge);
+
+    PositionFix fix;
+    bool solved = multilateration.getRangeCount() >= (solve3d ? 4 : 3) && multilateration.solve(fix, solve3d);
+
+    record(stats.solver, clock() - start);
+
+    if (!solved) {
+        return;
+    }
+    stats.fixes++;
+
+    if (hasTruth) {
+        float dx = fix.x - truth[0];
+        float dy = fix.y - truth[1];
+        float dz = solve3d ? fix.z - truth[2] : 0.0f;
+        float error = sqrtf(dx * dx + dy * dy + dz * dz);
+
+        stats.errorCount++;
+        stats.errorSum += error;
+        if (error > stats.errorMax) {
+            stats.errorMax = error;
+        }
+    }
+}
+
+bool FtmReplay::parseBssid(const char* text, uint8_t bssid[6]) {
+    unsigned int values[6];
+    if (sscanf(text, "%2x:%2x:%2x:%2x:%2x:%2x", &values[0], &values[1], &values[2], &values[3], &values[4], &values[5]) != 6) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < 6; i++) {
+        bssid[i] = values[i];
+    }
+    return true;
+}
+
+void FtmReplay::record(FtmReplayStageStats& stage, uint32_t micros) {
+    stage.count++;
+    stage.totalMicros += micros;
+    if (micros > stage.maxMicros) {
+        stage.maxMicros = micros;
+    }
+}
@@ -0,0 +1,252 @@
+#include "FtmScheduler.h"
+
+FtmScheduler::FtmScheduler(FtmRangingEngine& engine)
+    : engine(engine)
+    , anchorCount(0)
+    , inFlightRequest(0)
+    , cursor(0)
+    , resultCallback(nullptr)
+    , rangeCorrection(nullptr) {
+    memset(&config, 0, sizeof(config));
+}
+
+void FtmScheduler::configure(const FtmSchedulerConfig& config) {
+    this->config = config;
+    if (this->config.maxInterval < this->config.minInterval) {
+        this->config.maxInterval = this->config.minInterval;
+    }
+}
+
+bool FtmScheduler::addAnchor(const uint8_t bssid[6], uint8_t channel, uint8_t priority) {
+    FtmAnchor* existing = findAnchorMutable(bssid);
+    if (existing) {
+        existing->channel = channel;
+        existing->priority = priority;
+        return true;
+    }
+
+    if (anchorCount >= MAX_ANCHORS) {
+        return false;
+    }
+
+    FtmAnchor& anchor = anchors[anchorCount++];
+    anchor = FtmAnchor();
+    memcpy(anchor.bssid, bssid, sizeof(anchor.bssid));
+    anchor.channel = channel;
+    anchor.priority = priority;
+
+    return true;
+}
+
+bool FtmScheduler::removeAnchor(const uint8_t bssid[6]) {
+    FtmAnchor* anchor = findAnchorMutable(bssid);
+    if (!anchor) {
+        return false;
+    }
+
+    size_t index = anchor - anchors;
+    for (size_t i = index; i + 1 < anchorCount; i++) {
+        anchors[i] = anchors[i + 1];
+    }
+    anchorCount--;
+
+    if (cursor >= anchorCount) {
+        cursor = 0;
+    }
+    return true;
+}
+
+bool FtmScheduler::setAnchorPosition(const uint8_t bssid[6], float x, float y, float z) {
+    FtmAnchor* anchor = findAnchorMutable(bssid);
+    if (!anchor) {
+        return false;
+    }
+
+    anchor->x = x;
+    anchor->y = y;
+    anchor->z = z;
+    anchor->hasPosition = true;
+    return true;
+}
+
+void FtmScheduler::clearAnchors() {
+    anchorCount = 0;
+    cursor = 0;
+}
+
+const FtmAnchor* FtmScheduler::findAnchor(const uint8_t bssid[6]) const {
+    for (uint8_t i = 0; i < anchorCount; i++) {
+        if (memcmp(anchors[i].bssid, bssid, sizeof(anchors[i].bssid)) == 0) {
+            return &anchors[i];
+        }
+    }
+    return nullptr;
+}
+
+FtmAnchor* FtmScheduler::findAnchorMutable(const uint8_t bssid[6]) {
+    return const_cast<FtmAnchor*>(findAnchor(bssid));
+}
+
+void FtmScheduler::update(uint32_t now) {
+    if (inFlightRequest != 0 || anchorCount == 0) {
+        return;
+    }
+
+    FtmAnchor* anchor = selectNext(now);
+    if (!anchor) {
+        return;
+    }
+
+    FtmRequest request;
+    memcpy(request.bssid, anchor->bssid, sizeof(request.bssid));
+    request.channel = anchor->channel;
+    request.useConnectedAp = false;
+    request.frameCount = anchor->burst.getFrameCount(config.burst);
+    request.burstPeriod = anchor->burst.getBurstPeriod(config.burst);
+    request.timeout = config.requestTimeout;
+
+    inFlightRequest = engine.submit(request, now, [this](const FtmResult& result) {
+        handleResult(result);
+    });
+
+    if (inFlightRequest != 0) {
+        anchor->stats.attempts++;
+    }
+}
+
+uint8_t FtmScheduler::collectRanges(Multilateration& multilateration, uint32_t now, uint32_t maxRangeAge) const {
+    uint8_t added = 0;
+
+    for (uint8_t i = 0; i < anchorCount; i++) {
+        const FtmAnchor& anchor = anchors[i];
+        if (!anchor.hasPosition || anchor.stats.successes == 0) {
+            continue;
+        }
+        if (now - anchor.stats.lastSuccessAt > maxRangeAge) {
+            continue;
+        }
+
+        if (multilateration.addRange(anchor.x, anchor.y, anchor.z, anchor.stats.filteredDistanceCm / 100.0f)) {
+            added++;
+        }
+    }
+
+    return added;
+}
+
+FtmAnchor* FtmScheduler::selectNext(uint32_t now) {
+    FtmAnchor* best = nullptr;
+    uint8_t bestIndex = 0;
+
+    for (uint8_t i = 0; i < anchorCount; i++) {
+        uint8_t index = (cursor + i) % anchorCount;
+        FtmAnchor& anchor = anchors[index];
+
+        bool due = anchor.interval == 0 || static_cast<int32_t>(now - anchor.nextDue) >= 0;
+        if (!due) {
+            continue;
+        }
+
+        if (!best || anchor.priority > best->priority) {
+            best = &anchor;
+            bestIndex = index;
+        }
+    }
+
+    if (best) {
+        cursor = (bestIndex + 1) % anchorCount;
+    }
+    return best;
+}
+
+void FtmScheduler::handleResult(FtmResult result) {
+    if (result.requestId == inFlightRequest) {
+        inFlightRequest = 0;
+    }
+
+    // Not the anchor's fault; it stays due and is retried on the next update.
+    if (result.state == FtmRequestState::CANCELLED) {
+        return;
+    }
+
+    if (rangeCorrection && result.state == FtmRequestState::COMPLETED) {
+        float corrected = rangeCorrection(result.bssid, result.distanceCm);
+        result.distanceCm = static_cast<uint32_t>(corrected + 0.5f);
+    }
+
+    FtmAnchor* anchor = findAnchorMutable(result.bssid);
+    if (anchor) {
+        FtmAnchorStats& stats = anchor->stats;
+        uint32_t now = result.completedAt;
+
+        if (result.state == FtmRequestState::COMPLETED) {
+            uint32_t delta = result.distanceCm > stats.lastDistanceCm
+                ? result.distanceCm - stats.lastDistanceCm
+                : stats.lastDistanceCm - result.distanceCm;
+            bool stable = stats.successes > 0 && delta <= config.stableThreshold;
+            float innovation = stats.successes > 0 ? result.distanceCm - anchor->filter.getEstimate() : 0.0f;
+            anchor->burst.onSuccess(innovation, config.burst);
+
+            stats.successes++;
+            stats.consecutiveFailures = 0;
+            stats.stableCount = stable ? (stats.stableCount < UINT8_MAX ? stats.stableCount + 1 : UINT8_MAX) : 0;
+            stats.lastRttNs = result.rttNs;
+            stats.lastDistanceCm = result.distanceCm;
+
+            float filtered;
+            if (anchor->filter.update(result.distanceCm, now, config.filter, filtered)) {
+                stats.filteredDistanceCm = static_cast<uint32_t>(filtered + 0.5f);
+            }
+            stats.rejected = anchor->filter.getRejectedCount();
+            stats.lastSuccessAt = now;
+            anchor->windowSessions++;
+
+            anchor->interval = stats.stableCount >= STABLE_SESSIONS
+                ? backoff(stats.stableCount - STABLE_SESSIONS + 1)
+                : config.minInterval;
+        } else {
+            stats.failures++;
+            stats.stableCount = 0;
+            anchor->burst.onFailure(config.burst);
+            if (stats.consecutiveFailures < UINT8_MAX) {
+                stats.consecutiveFailures++;
+            }
+
+            anchor->interval = backoff(stats.consecutiveFailures);
+        }
+
+        if (anchor->interval == 0) {
+            anchor->interval = 1;
+        }
+        anchor->nextDue = now + anchor->interval;
+        updateRate(*anchor, now);
+    }
+
+    if (resultCallback) {
+        resultCallback(result);
+    }
+}
+
+void FtmScheduler::updateRate(FtmAnchor& anchor, uint32_t now) {
+    if (anchor.windowStart == 0) {
+        anchor.windowStart = now;
+        return;
+    }
+
+    uint32_t elapsed = now - anchor.windowStart;
+    if (elapsed < RATE_WINDOW) {
+        return;
+    }
+
+    anchor.stats.sessionsPerSecond = anchor.windowSessions * 1000.0f / elapsed;
+    anchor.windowSessions = 0;
+    anchor.windowStart = now;
+}
+
+uint32_t FtmScheduler::backoff(uint8_t steps) const {
+    uint32_t interval = config.minInterval;
+    for (uint8_t i = 0; i < steps && interval < config.maxInterval; i++) {
+        interval *= 2;
+    }
+    return interval > config.maxInterval ? config.maxInterval : interval;
+}
@@ -1,6 +1,296 @@
 #include "Logger.h"
+#include <stdarg.h>
 
-const char* Logger::LOG_TOPIC_PREFIX = "devices";
+enum class LogArgument {
+    NONE,
+    INT,
+    LONG,
+    LONG_LONG,
+    SIZE,
+    POINTER,
+    DOUBLE,
+    STRING,
+    __DELIMITER__
+};
+
+struct LogFormatSpec {
+    const char* start;
+    uint8_t length;
+    uint8_t stars;
+    int16_t precision;
+    bool starPrecision;
+    LogArgument argument;
+};
+
+// Finds the next conversion in format and the argument type it consumes.
+// Returns the position after it, or nullptr when there is none.
+static const char* parseFormatSpec(const char* format, LogFormatSpec& spec) {
+    const char* cursor = strchr(format, '%');
+    if (!cursor) {
+        return nullptr;
+    }
+
+    spec.start = cursor++;
+    spec.stars = 0;
+    spec.precision = -1;
+    spec.starPrecision = false;
+
+    while (*cursor && strchr("-+ #0", *cursor)) {
+        cursor++;
+    }
+    if (*cursor == '*') {
+        spec.stars++;
+        cursor++;
+    }
+    while (isdigit(*cursor)) {
+        cursor++;
+    }
+    if (*cursor == '.') {
+        cursor++;
+        spec.precision = 0;
+        if (*cursor == '*') {
+            spec.stars++;
+            spec.starPrecision = true;
+            cursor++;
+        }
+        while (isdigit(*cursor)) {
+            spec.precision = spec.precision * 10 + (*cursor++ - '0');
+        }
+    }
+
+    uint8_t longs = 0;
+    bool sized = false;
+    while (*cursor && strchr("hlzjt", *cursor)) {
+        longs += *cursor == 'l';
+        sized |= *cursor != 'h' && *cursor != 'l';
+        cursor++;
+    }
+
+    char conversion = *cursor;
+    if (conversion) {
+        cursor++;
+    }
+    spec.length = cursor - spec.start;
+
+    switch (conversion) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            spec.argument = longs >= 2 ? LogArgument::LONG_LONG : longs == 1 ? LogArgument::LONG : sized ? LogArgument::SIZE : LogArgument::INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            spec.argument = LogArgument::DOUBLE;
+            break;
+        case 's':
+            spec.argument = LogArgument::STRING;
+            break;
+        case 'p':
+            spec.argument = LogArgument::POINTER;
+            break;
+        default:
+            spec.argument = LogArgument::NONE;
+            break;
+    }
+
+    return cursor;
+}
+
+template <typename T>
+static bool packArgument(char* buffer, size_t size, size_t& length, T value) {
+    if (length + sizeof(value) > size) {
+        return false;
+    }
+    memcpy(buffer + length, &value, sizeof(value));
+    length += sizeof(value);
+    return true;
+}
+
+template <typename T>
+static bool unpackArgument(const char* buffer, size_t size, size_t& offset, T& value) {
+    if (offset + sizeof(value) > size) {
+        return false;
+    }
+    memcpy(&value, buffer + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+// Arguments are stored at their native size in format order; strings are
+// copied inline since the caller's buffer is gone by the time sinks run.
+static size_t packArguments(const char* format, va_list args, char* buffer, size_t size) {
+    size_t length = 0;
+    LogFormatSpec spec;
+
+    for (const char* cursor = parseFormatSpec(format, spec); cursor; cursor = parseFormatSpec(cursor, spec)) {
+        int precision = spec.precision;
+        for (uint8_t i = 0; i < spec.stars; i++) {
+            int star = va_arg(args, int);
+            if (!packArgument(buffer, size, length, star)) {
+                return length;
+            }
+            if (spec.starPrecision && i == spec.stars - 1) {
+                precision = star;
+            }
+        }
+
+        bool packed = true;
+        switch (spec.argument) {
+            case LogArgument::INT: packed = packArgument(buffer, size, length, va_arg(args, int)); break;
+            case LogArgument::LONG: packed = packArgument(buffer, size, length, va_arg(args, long)); break;
+            case LogArgument::LONG_LONG: packed = packArgument(buffer, size, length, va_arg(args, long long)); break;
+            case LogArgument::SIZE: packed = packArgument(buffer, size, length, va_arg(args, size_t)); break;
+            case LogArgument::POINTER: packed = packArgument(buffer, size, length, va_arg(args, void*)); break;
+            case LogArgument::DOUBLE: packed = packArgument(buffer, size, length, va_arg(args, double)); break;
+            case LogArgument::STRING: {
+                const char* value = va_arg(args, const char*);
+                if (!value) {
+                    value = "(null)";
+                }
+                if (length >= size) {
+                    return length;
+                }
+                size_t limit = size - length - 1;
+                if (precision >= 0 && static_cast<size_t>(precision) < limit) {
+                    limit = precision;
+                }
+                size_t valueLength = strnlen(value, limit);
+                memcpy(buffer + length, value, valueLength);
+                buffer[length + valueLength] = '\0';
+                length += valueLength + 1;
+                break;
+            }
+            default:
+                break;
+        }
+        if (!packed) {
+            return length;
+        }
+    }
+
+    return length;
+}
+
+template <typename T>
+static int formatArgument(char* buffer, size_t size, const char* spec, const int* stars, uint8_t starCount, T value) {
+    switch (starCount) {
+        case 0: return snprintf(buffer, size, spec, value);
+        case 1: return snprintf(buffer, size, spec, stars[0], value);
+        default: return snprintf(buffer, size, spec, stars[0], stars[1], value);
+    }
+}
+
+// Formats one conversion at a time from the packed arguments. Rendering stops
+// at the first argument that did not fit into the record.
+static void renderArguments(const char* format, const char* arguments, size_t argumentsLength, char* buffer, size_t size) {
+    size_t written = 0;
+    size_t offset = 0;
+    bool complete = false;
+    const char* literal = format;
+    LogFormatSpec spec;
+
+    auto append = [&](const char* text, size_t length) {
+        if (written + length >= size) {
+            length = size - written - 1;
+        }
+        memcpy(buffer + written, text, length);
+        written += length;
+    };
+
+    for (const char* cursor = parseFormatSpec(format, spec); ; cursor = parseFormatSpec(cursor, spec)) {
+        if (!cursor) {
+            complete = true;
+            break;
+        }
+        append(literal, spec.start - literal);
+        literal = cursor;
+
+        if (spec.argument == LogArgument::NONE) {
+            if (spec.start[spec.length - 1] == '%') {
+                append("%", 1);
+            }
+            continue;
+        }
+
+        char specBuffer[16];
+        int stars[2];
+        if (spec.length >= sizeof(specBuffer)) {
+            break;
+        }
+        strlcpy(specBuffer, spec.start, spec.length + 1);
+
+        bool unpacked = true;
+        for (uint8_t i = 0; i < spec.stars && unpacked; i++) {
+            unpacked = unpackArgument(arguments, argumentsLength, offset, stars[i]);
+        }
+        if (!unpacked) {
+            break;
+        }
+
+        char* out = buffer + written;
+        size_t remaining = size - written;
+        int length = 0;
+        switch (spec.argument) {
+            case LogArgument::INT: {
+                int value;
+                unpacked = unpackArgument(arguments, argumentsLength, offset, value);
+                if (unpacked) length = formatArgument(out, remaining, specBuffer, stars, spec.stars, value);
+                break;
+            }
+            case LogArgument::LONG: {
+                long value;
+                unpacked = unpackArgument(arguments, argumentsLength, offset, value);
+                if (unpacked) length = formatArgument(out, remaining, specBuffer, stars, spec.stars, value);
+                break;
+            }
+            case LogArgument::LONG_LONG: {
+                long long value;
+                unpacked = unpackArgument(arguments, argumentsLength, offset, value);
+                if (unpacked) length = formatArgument(out, remaining, specBuffer, stars, spec.stars, value);
+                break;
+            }
+            case LogArgument::SIZE: {
+                size_t value;
+                unpacked = unpackArgument(arguments, argumentsLength, offset, value);
+                if (unpacked) length = formatArgument(out, remaining, specBuffer, stars, spec.stars, value);
+                break;
+            }
+            case LogArgument::POINTER: {
+                void* value;
+                unpacked = unpackArgument(arguments, argumentsLength, offset, value);
+                if (unpacked) length = formatArgument(out, remaining, specBuffer, stars, spec.stars, value);
+                break;
+            }
+            case LogArgument::DOUBLE: {
+                double value;
+                unpacked = unpackArgument(arguments, argumentsLength, offset, value);
+                if (unpacked) length = formatArgument(out, remaining, specBuffer, stars, spec.stars, value);
+                break;
+            }
+            case LogArgument::STRING: {
+                const char* value = arguments + offset;
+                size_t valueLength = offset < argumentsLength ? strnlen(value, argumentsLength - offset) : argumentsLength;
+                unpacked = offset + valueLength < argumentsLength;
+                offset += valueLength + 1;
+                if (unpacked) length = formatArgument(out, remaining, specBuffer, stars, spec.stars, value);
+                break;
+            }
+            default:
+                break;
+        }
+        if (!unpacked) {
+            break;
+        }
+
+        written += length < 0 ? 0 : length;
+        if (written >= size - 1) {
+            written = size - 1;
+            break;
+        }
+    }
+
+    if (complete) {
+        append(literal, strlen(literal));
+    }
+    buffer[written] = '\0';
+}
 
 const char* Logger::getLogLevelString(LogLevel level) {
     switch (level) {
@@ -12,26 +302,176 @@ const char* Logger::getLogLevelString(LogLevel level) {
     }
 }
 
+const char* Logger::getMessage(const LogRecord& record, char* buffer, size_t size) {
+    if (!record.format) {
+        return record.message;
+    }
+
+    renderArguments(record.format, record.message, record.argumentsLength, buffer, size);
+    return buffer;
+}
+
 bool Logger::isLogLevelEnabled(LogLevel level) {
-    return static_cast<int>(level) >= static_cast<int>(logLevel);
+    return static_cast<int>(level) >= LOGGING_COMPILE_LEVEL && static_cast<int>(level) >= static_cast<int>(logLevel);
 }
 
-void Logger::log(LogLevel level, const char* source, const char* message) {
+bool Logger::begin() {
+    if (drainTask) {
+        return true;
+    }
+
+    if (xTaskCreatePinnedToCore(drainTaskEntry, "log", DRAIN_TASK_STACK_SIZE, this, DRAIN_TASK_PRIORITY, &drainTask, DRAIN_TASK_CORE) != pdPASS) {
+        drainTask = nullptr;
+        error("Logger", "Failed to start drain task, logging synchronously");
+        return false;
+    }
+
+    return true;
+}
+
+bool Logger::addSink(LogSink sink) {
+    if (sinkCount >= MAX_SINKS) {
+        return false;
+    }
+
+    // The drain task may be iterating; publish the slot before the count.
+    sinks[sinkCount] = sink;
+    sinkCount++;
+    return true;
+}
+
+LogRecord* Logger::reserveRecord(LogLevel level, const char* source, uint32_t& position) {
     if (static_cast<int>(logLevel) < 0 || static_cast<int>(logLevel) > getLogLevelCount()-1) {
-        char msgBuffer[64];
-        snprintf(msgBuffer, sizeof(msgBuffer), "Invalid log level: '%d' - changing to default: INFO", logLevel);
+        int invalidLevel = static_cast<int>(logLevel);
         logLevel = LogLevel::INFO;
-        info("Logger", msgBuffer);
+        logf(LogLevel::INFO, "Logger", "Invalid log level: '%d' - changing to default: INFO", invalidLevel);
     }
 
     if (!isLogLevelEnabled(level)) {
+        return nullptr;
+    }
+
+    LogRecord* record = records.reserve(position);
+    if (!record) {
+        return nullptr;
+    }
+
+    record->timestamp = millis();
+    record->level = level;
+    record->source = source;
+    record->format = nullptr;
+    record->argumentsLength = 0;
+    TaskHandle_t localOnly = localOnlyTask.load(std::memory_order_relaxed);
+    record->localOnly = localOnly && localOnly == xTaskGetCurrentTaskHandle();
+    return record;
+}
+
+void Logger::commitRecord(const LogRecord& record, uint32_t position) {
+    LogHook hook = recordHook.load(std::memory_order_acquire);
+    if (hook) {
+        hook(record);
+    }
+
+    records.commit(position);
+
+    if (!drainTask) {
+        drain();
+    }
+}
+
+void Logger::log(LogLevel level, const char* source, const char* message) {
+    uint32_t position;
+    LogRecord* record = reserveRecord(level, source, position);
+    if (!record) {
         return;
     }
 
-    unsigned long ms = millis();
+    strlcpy(record->message, message, sizeof(record->message));
+    commitRecord(*record, position);
+}
+
+void Logger::logf(LogLevel level, const char* source, const char* format, ...) {
+    uint32_t position;
+    LogRecord* record = reserveRecord(level, source, position);
+    if (!record) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+#if LOGGING_BINARY
+    record->format = format;
+    record->argumentsLength = packArguments(format, args, record->message, sizeof(record->message));
+#else
+    vsnprintf(record->message, sizeof(record->message), format, args);
+#endif
+    va_end(args);
+
+    commitRecord(*record, position);
+}
+
+void Logger::flush(uint32_t timeout) {
+    uint32_t start = millis();
+    while (records.getCount() > 0 && millis() - start < timeout) {
+        if (!drainTask) {
+            drain();
+        } else {
+            delay(1);
+        }
+    }
+}
+
+void Logger::drainTaskEntry(void* parameter) {
+    Logger* logger = static_cast<Logger*>(parameter);
+
+    for (;;) {
+        logger->drain();
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_TASK_INTERVAL));
+    }
+}
+
+void Logger::drain() {
+    // Whoever holds the flag also drains records committed while it did;
+    // the re-check covers a commit that lands just before it lets go.
+    do {
+        if (draining.exchange(true, std::memory_order_acquire)) {
+            return;
+        }
+        drainRecords();
+        draining.store(false, std::memory_order_release);
+    } while (records.front());
+}
+
+void Logger::drainRecords() {
+    uint32_t dropped = records.getOverruns();
+    if (dropped != reportedDrops) {
+        LogRecord notice;
+        notice.timestamp = millis();
+        notice.level = LogLevel::WARNING;
+        notice.source = "Logger";
+        notice.format = nullptr;
+        notice.localOnly = false;
+        snprintf(notice.message, sizeof(notice.message), "Log buffer overflow, dropped %" PRIu32 " records", dropped - reportedDrops);
+        reportedDrops = dropped;
+        dispatch(notice);
+    }
+
+    for (LogRecord* record = records.front(); record; record = records.front()) {
+        dispatch(*record);
+        records.pop();
+    }
+}
+
+void Logger::dispatch(const LogRecord& record) {
+    for (uint8_t i = 0; i < sinkCount; i++) {
+        sinks[i](record);
+    }
+}
 
+void Logger::writeSerial(const LogRecord& record) {
+    char message[LogRecord::MESSAGE_LENGTH];
     char msgBuffer[256];
-    snprintf(msgBuffer, sizeof(msgBuffer), "[%lu] %s: %s: %s", ms, getLogLevelString(level), source, message);
+    snprintf(msgBuffer, sizeof(msgBuffer), "[%lu] %s: %s: %s", static_cast<unsigned long>(record.timestamp), getLogLevelString(record.level), record.source, getMessage(record, message, sizeof(message)));
 
     Serial.println(msgBuffer);
 }
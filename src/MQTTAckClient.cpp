@@ -0,0 +1,127 @@
+#include "MQTTAckClient.h"
+
+static const uint8_t MQTT_PUBACK = 4;
+
+MQTTAckClient::MQTTAckClient(Client& client)
+    : client(client) {
+    reset();
+}
+
+int MQTTAckClient::connect(IPAddress ip, uint16_t port) {
+    reset();
+    return client.connect(ip, port);
+}
+
+int MQTTAckClient::connect(const char* host, uint16_t port) {
+    reset();
+    return client.connect(host, port);
+}
+
+int MQTTAckClient::read() {
+    int value = client.read();
+    if (value >= 0) {
+        consume(value);
+    }
+    return value;
+}
+
+int MQTTAckClient::read(uint8_t* buffer, size_t size) {
+    int count = client.read(buffer, size);
+    for (int i = 0; i < count; i++) {
+        consume(buffer[i]);
+    }
+    return count;
+}
+
+void MQTTAckClient::stop() {
+    client.stop();
+    reset();
+}
+
+bool MQTTAckClient::writePublish(const MQTTQueuedMessage& message) {
+    uint8_t header[5 + 2 + MQTTOutboundQueue::MAX_TOPIC_LENGTH + 2];
+    size_t position = 0;
+
+    header[position++] = 0x32 | (message.duplicate ? 0x08 : 0x00) | (message.retained ? 0x01 : 0x00);
+
+    uint32_t remaining = 2 + message.topicLength + 2 + message.length;
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        header[position++] = remaining > 0 ? digit | 0x80 : digit;
+    } while (remaining > 0);
+
+    header[position++] = message.topicLength >> 8;
+    header[position++] = message.topicLength & 0xFF;
+    memcpy(&header[position], message.topic, message.topicLength);
+    position += message.topicLength;
+    header[position++] = message.packetId >> 8;
+    header[position++] = message.packetId & 0xFF;
+
+    if (client.write(header, position) != position) {
+        return false;
+    }
+    return client.write(reinterpret_cast<const uint8_t*>(message.payload), message.length) == message.length;
+}
+
+bool MQTTAckClient::popAck(uint16_t& packetId) {
+    uint16_t* ack = acks.front();
+    if (!ack) {
+        return false;
+    }
+
+    packetId = *ack;
+    acks.pop();
+    return true;
+}
+
+void MQTTAckClient::reset() {
+    state = ParseState::HEADER;
+    packetType = 0;
+    remaining = 0;
+    lengthShift = 0;
+    packetId = 0;
+    bodyRead = 0;
+}
+
+void MQTTAckClient::consume(uint8_t value) {
+    switch (state) {
+        case ParseState::HEADER:
+            packetType = value >> 4;
+            remaining = 0;
+            lengthShift = 0;
+            packetId = 0;
+            bodyRead = 0;
+            state = ParseState::LENGTH;
+            break;
+        case ParseState::LENGTH:
+            remaining |= static_cast<uint32_t>(value & 0x7F) << lengthShift;
+            lengthShift += 7;
+            if (value & 0x80) {
+                if (lengthShift > 21) {
+                    reset();
+                }
+                break;
+            }
+            state = remaining > 0 ? ParseState::BODY : ParseState::HEADER;
+            break;
+        case ParseState::BODY:
+            if (packetType == MQTT_PUBACK && bodyRead < 2) {
+                packetId = (packetId << 8) | value;
+            }
+            bodyRead = bodyRead < UINT8_MAX ? bodyRead + 1 : bodyRead;
+
+            if (--remaining == 0) {
+                uint16_t* ack = packetType == MQTT_PUBACK && bodyRead >= 2 ? acks.reserve() : nullptr;
+                if (ack) {
+                    *ack = packetId;
+                    acks.commit();
+                }
+                state = ParseState::HEADER;
+            }
+            break;
+        default:
+            reset();
+            break;
+    }
+}
@@ -0,0 +1,160 @@
+#include "MQTTBenchmark.h"
+
+bool MQTTBenchmark::start(const uint16_t* sizes, uint8_t sizeCount, uint16_t count, uint8_t window, uint8_t qos, MQTTBenchmarkCallback callback) {
+    if (isRunning() || !mqttManager.isInitialized() || sizeCount == 0) {
+        return false;
+    }
+
+    if (!subscribed) {
+        topic = mqttManager.registerTopic("bench");
+
+        char filter[MQTTOutboundQueue::MAX_TOPIC_LENGTH + 1];
+        snprintf(filter, sizeof(filter), "%s/bench", mqttManager.getDeviceTopic());
+        subscribed = mqttManager.subscribe(filter, [this](const char* topic, const uint8_t* payload, unsigned int length) {
+            receive(payload, length);
+        });
+    }
+    if (!subscribed || topic == MQTTManager::INVALID_TOPIC) {
+        log.error("MQTTBenchmark", "Failed to set up benchmark topic");
+        return false;
+    }
+
+    runCount = sizeCount > MAX_RUNS ? static_cast<uint8_t>(MAX_RUNS) : sizeCount;
+    for (uint8_t i = 0; i < runCount; i++) {
+        memset(&runs[i], 0, sizeof(runs[i]));
+        runs[i].payloadSize = sizes[i];
+        if (runs[i].payloadSize < HEADER_SIZE) {
+            runs[i].payloadSize = HEADER_SIZE;
+        } else if (runs[i].payloadSize > MQTTOutboundQueue::MAX_PAYLOAD_LENGTH) {
+            runs[i].payloadSize = MQTTOutboundQueue::MAX_PAYLOAD_LENGTH;
+        }
+    }
+
+    this->count = count;
+    if (this->count == 0) {
+        this->count = 1;
+    } else if (this->count > MAX_MESSAGES) {
+        this->count = MAX_MESSAGES;
+    }
+    this->window = window > 0 ? window : 1;
+    this->qos = qos > 0 ? 1 : 0;
+    this->callback = callback;
+
+    runIndex = 0;
+    startRun();
+    return true;
+}
+
+void MQTTBenchmark::startRun() {
+    runId++;
+    memset(receivedMask, 0, sizeof(receivedMask));
+    memset(payload, 'x', runs[runIndex].payloadSize);
+
+    runStartedAt = micros();
+    lastActivity = runStartedAt;
+    phase = MQTTBenchmarkPhase::PUBLISHING;
+}
+
+void MQTTBenchmark::update() {
+    if (phase == MQTTBenchmarkPhase::IDLE) {
+        return;
+    }
+
+    MQTTBenchmarkRun& run = runs[runIndex];
+
+    if (phase == MQTTBenchmarkPhase::PUBLISHING) {
+        // Keep at most window messages outstanding so the outbound queue never
+        // has to evict benchmark traffic.
+        while (run.sent < count && run.sent - run.received < window) {
+            uint16_t sequence = run.sent;
+            uint32_t sentAt = micros();
+            memcpy(payload, &runId, sizeof(runId));
+            memcpy(payload + 2, &sequence, sizeof(sequence));
+            memcpy(payload + 4, &sentAt, sizeof(sentAt));
+
+            bool published = mqttManager.publish(topic, payload, run.payloadSize, false, MQTTPriority::NORMAL, qos);
+            run.publishMicros += micros() - sentAt;
+            if (!published) {
+                run.stalls++;
+                break;
+            }
+
+            run.sent++;
+            lastActivity = sentAt;
+        }
+
+        if (run.sent >= count) {
+            phase = MQTTBenchmarkPhase::SETTLING;
+        }
+    }
+
+    if ((phase == MQTTBenchmarkPhase::SETTLING && run.received >= run.sent)
+        || micros() - lastActivity >= SETTLE_TIMEOUT) {
+        finishRun();
+    }
+}
+
+void MQTTBenchmark::receive(const uint8_t* message, unsigned int length) {
+    if (phase == MQTTBenchmarkPhase::IDLE || length < HEADER_SIZE) {
+        return;
+    }
+
+    uint16_t id;
+    uint16_t sequence;
+    uint32_t sentAt;
+    memcpy(&id, message, sizeof(id));
+    memcpy(&sequence, message + 2, sizeof(sequence));
+    memcpy(&sentAt, message + 4, sizeof(sentAt));
+
+    if (id != runId || sequence >= count) {
+        return;
+    }
+
+    // Overlapping subscriptions may deliver a message more than once.
+    MQTTBenchmarkRun& run = runs[runIndex];
+    uint32_t bit = 1UL << (sequence % 32);
+    if (receivedMask[sequence / 32] & bit) {
+        run.duplicates++;
+        return;
+    }
+    receivedMask[sequence / 32] |= bit;
+
+    lastActivity = micros();
+    latencies[run.received++] = lastActivity - sentAt;
+}
+
+void MQTTBenchmark::finishRun() {
+    MQTTBenchmarkRun& run = runs[runIndex];
+    run.durationMicros = lastActivity - runStartedAt;
+
+    for (uint16_t i = 1; i < run.received; i++) {
+        uint32_t latency = latencies[i];
+        int16_t j = i - 1;
+        while (j >= 0 && latencies[j] > latency) {
+            latencies[j + 1] = latencies[j];
+            j--;
+        }
+        latencies[j + 1] = latency;
+    }
+
+    if (run.received > 0) {
+        run.p50 = latencies[(run.received - 1) * 50 / 100];
+        run.p90 = latencies[(run.received - 1) * 90 / 100];
+        run.p99 = latencies[(run.received - 1) * 99 / 100];
+        run.max = latencies[run.received - 1];
+    }
+
+    LOG_INFO("MQTTBenchmark", "%u B: %u/%u received, p50 %" PRIu32 " us, p99 %" PRIu32 " us, publish %" PRIu32 " us",
+        run.payloadSize, run.received, run.sent, run.p50, run.p99, run.sent > 0 ? run.publishMicros / run.sent : 0);
+
+    runIndex++;
+    if (runIndex < runCount) {
+        startRun();
+        return;
+    }
+
+    phase = MQTTBenchmarkPhase::IDLE;
+    if (callback) {
+        callback(*this);
+    }
+}
@@ -0,0 +1,156 @@
+#include "MQTTLogSink.h"
+
+bool MQTTLogSink::begin() {
+    if (initialized) {
+        return true;
+    }
+
+    if (!mqttManager.isInitialized()) {
+        log.warning("MQTTLogSink", "MQTTManager not initialized, skipping MQTTLogSink initialization");
+        return false;
+    }
+
+    topic = mqttManager.registerTopic("log");
+    if (topic == MQTTManager::INVALID_TOPIC) {
+        log.error("MQTTLogSink", "Failed to register log topic");
+        return false;
+    }
+
+    applyFilter(configManager.getRuntimeConfig());
+    configManager.addListener(ConfigManager::sectionMask(ConfigSection::LOGGING), [this](const RuntimeConfig& previous, const RuntimeConfig& current) {
+        applyFilter(current);
+    });
+
+    if (!log.addSink([this](const LogRecord& record) {
+        enqueue(record);
+    })) {
+        log.error("MQTTLogSink", "Failed to register log sink");
+        return false;
+    }
+
+    tokens = MAX_BATCH_LENGTH;
+    lastRefill = millis();
+    initialized = true;
+
+    return true;
+}
+
+void MQTTLogSink::applyFilter(const RuntimeConfig& config) {
+    filter.write(MQTTLogFilter{config.logging.allowMqttLog, config.logging.mqttLevel});
+}
+
+void MQTTLogSink::enqueue(const LogRecord& record) {
+    const MQTTLogFilter& current = filter.read();
+    if (!current.enabled || static_cast<uint8_t>(record.level) < current.level) {
+        return;
+    }
+
+    // Publishing a batch makes the transport log, and a handler may log the
+    // batch it receives; either would be forwarded in the next batch and so
+    // on forever.
+    if (record.localOnly || strcmp(record.source, "MQTTManager") == 0 || strcmp(record.source, "MQTTLogSink") == 0) {
+        return;
+    }
+
+    LogRecord* slot = records.reserve();
+    if (!slot) {
+        return;
+    }
+    *slot = record;
+    records.commit();
+}
+
+void MQTTLogSink::update() {
+    if (!initialized) {
+        return;
+    }
+
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+    uint32_t now = millis();
+
+    for (LogRecord* record = records.front(); record; record = records.front()) {
+        if (!append(*record, now)) {
+            flush(now);
+            if (!append(*record, now)) {
+                dropped++;
+            }
+        }
+        records.pop();
+
+        if (batchCount >= config.logging.mqttBatchSize) {
+            flush(now);
+        }
+    }
+
+    if (batchCount > 0 && now - batchStartedAt >= config.logging.mqttBatchInterval) {
+        flush(now);
+    }
+}
+
+bool MQTTLogSink::append(const LogRecord& record, uint32_t now) {
+    char message[LogRecord::MESSAGE_LENGTH];
+    StaticJsonDocument<128> doc;
+    JsonArray row = doc.to<JsonArray>();
+    row.add(record.timestamp);
+    row.add(Logger::getLogLevelString(record.level));
+    row.add(record.source);
+    row.add(Logger::getMessage(record, message, sizeof(message)));
+
+    // Room for the separator and the closing bracket.
+    size_t length = measureJson(doc);
+    if (batchLength + length + 2 > MAX_BATCH_LENGTH) {
+        return false;
+    }
+
+    if (batchCount == 0) {
+        batchStartedAt = now;
+    }
+    batch[batchLength++] = batchCount == 0 ? '[' : ',';
+    batchLength += serializeJson(doc, batch + batchLength, sizeof(batch) - batchLength);
+    batchCount++;
+
+    return true;
+}
+
+void MQTTLogSink::flush(uint32_t now) {
+    if (batchCount == 0) {
+        return;
+    }
+
+    batch[batchLength++] = ']';
+    batch[batchLength] = '\0';
+
+    // A configured topic can change at runtime and is copied per batch;
+    // interned handles are never released, so only the default is one.
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+    bool published = consumeTokens(batchLength, now)
+        && (strlen(config.logging.mqttTopic) > 0
+            ? mqttManager.publish(config.logging.mqttTopic, batch, false, true, MQTTPriority::BACKGROUND)
+            : mqttManager.publish(topic, batch, batchLength, false, MQTTPriority::BACKGROUND));
+    if (!published) {
+        dropped += batchCount;
+    }
+
+    batchLength = 0;
+    batchCount = 0;
+}
+
+bool MQTTLogSink::consumeTokens(uint16_t length, uint32_t now) {
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+    uint32_t rate = config.logging.mqttRateLimit;
+    if (rate == 0) {
+        return true;
+    }
+
+    // Allow a burst of two seconds, but always at least one full batch.
+    uint32_t burst = rate * 2 > MAX_BATCH_LENGTH ? rate * 2 : MAX_BATCH_LENGTH + 0U;
+    uint64_t refilled = tokens + static_cast<uint64_t>(now - lastRefill) * rate / 1000;
+    tokens = refilled > burst ? burst : static_cast<uint32_t>(refilled);
+    lastRefill = now;
+
+    if (tokens < length) {
+        return false;
+    }
+    tokens -= length;
+    return true;
+}
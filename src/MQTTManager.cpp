@@ -1,46 +1,20 @@
 #include "MQTTManager.h"
 
-void MQTTManager::handleCallback(char* topic, uint8_t* payload, uint32_t length) {
-    char* message = new char[length + 1];
-    memcpy(message, payload, length);
-    message[length] = '\0';
-    
-    char msgBuffer[128];
-    snprintf(msgBuffer, sizeof(msgBuffer), "Received message on topic '%s': '%s'", topic, message);
-    log.debug("MQTTManager", msgBuffer);
-
-    //log.debug("MQTTManager", "Checking subscriptions:");
-    for(const auto& subscription : subscriptions) {
-        char subBuffer[128];
-        snprintf(subBuffer, sizeof(subBuffer), "Checking against subscription: '%s'", subscription.topic.c_str());
-        //log.debug("MQTTManager", subBuffer);
-        
-        if(matchTopic(subscription.topic.c_str(), topic)) {
-            log.debug("MQTTManager", "Topic match found - executing callback");
-            subscription.callback(topic, payload, length);
-        }
-    }
-    
-    delete[] message;
+void MQTTManager::handleCallback(const char* topic, const uint8_t* payload, uint32_t length) {
+    LOG_DEBUG("MQTTManager", "Received message on topic '%s': '%.*s'", topic, static_cast<int>(length), reinterpret_cast<const char*>(payload));
+
+    topicTrie.match(topic, [this, topic, payload, length](uint8_t handler) {
+        subscriptions[handler].callback(topic, payload, length);
+    });
 }
 
-bool MQTTManager::matchTopic(const char* pattern, const char* topic) {
-    while (*pattern && *topic) {
-        if (*pattern == '+') {
-            while (*topic && *topic != '/') topic++;
-            pattern++;
-            if (*topic) topic++;
-            if (*pattern) pattern++;
-            continue;
-        }
-        if (*pattern == '#') {
-            return true;
+int8_t MQTTManager::findSubscription(const char* topic) {
+    for (uint8_t i = 0; i < MAX_SUBSCRIPTIONS; i++) {
+        if (subscriptions[i].active && subscriptions[i].topic == topic) {
+            return i;
         }
-        if (*pattern != *topic) return false;
-        pattern++;
-        topic++;
     }
-    return *pattern == *topic;
+    return -1;
 }
 
 bool MQTTManager::begin(){
@@ -60,169 +34,470 @@ bool MQTTManager::begin(){
 
     initializeDeviceTopic();
 
-    snprintf(clientId, sizeof(clientId), "%s-%x", config.device.name, static_cast<uint32_t>(config.device.chipID));
+    snprintf(clientId, sizeof(clientId), "%s-%" PRIx32, config.device.name, static_cast<uint32_t>(config.device.chipID));
 
-    client.setServer(config.mqtt.broker, config.mqtt.port);
+    getNetworkSettings(config, networkSettings);
+    client.setServer(networkSettings.broker, networkSettings.port);
+    client.setBufferSize(MQTTOutboundQueue::MAX_TOPIC_LENGTH + MQTTOutboundQueue::MAX_PAYLOAD_LENGTH + 8);
     client.setCallback([this](char* topic, byte* payload, unsigned int length) {
-        handleCallback(topic, payload, length);
+        receive(topic, payload, length);
+    });
+
+    configManager.addListener(ConfigManager::sectionMask(ConfigSection::MQTT), [this](const RuntimeConfig& previous, const RuntimeConfig& current) {
+        MQTTCommand* command = reserveCommand(MQTTCommandType::CONFIGURE);
+        if (!command) {
+            return;
+        }
+
+        getNetworkSettings(current, command->settings);
+        command->topic = nullptr;
+        command->topicLength = 0;
+        command->length = 0;
+        commandQueue.commit();
     });
+
+    if (xTaskCreatePinnedToCore(networkTaskEntry, "mqtt", NETWORK_TASK_STACK_SIZE, this, NETWORK_TASK_PRIORITY, &networkTask, NETWORK_TASK_CORE) != pdPASS) {
+        log.error("MQTTManager", "Failed to start network task");
+        return false;
+    }
     
     initialized = true;
 
     return true;
 }
 
-bool MQTTManager::connect(){
-    if(!initialized) {
-        log.error("MQTTManager", "MQTTManager not initialized");
+void MQTTManager::disconnect(){
+    pushTopicCommand(MQTTCommandType::DISCONNECT, "");
+}
+
+bool MQTTManager::subscribe(const char* topic, MQTTCallback callback) {
+    if(findSubscription(topic) >= 0) {
+        log.warning("MQTTManager", "Already subscribed to topic");
         return false;
     }
 
-    RuntimeConfig& config = configManager.getRuntimeConfig();
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < MAX_SUBSCRIPTIONS && slot < 0; i++) {
+        if (!subscriptions[i].active) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        log.error("MQTTManager", "No free subscription slots");
+        return false;
+    }
 
-    if(client.connected()) {
+    if(!topicTrie.insert(topic, slot)) {
+        LOG_ERROR("MQTTManager", "Invalid or unsupported topic filter: %s", topic);
+        return false;
+    }
+
+    if(pushTopicCommand(MQTTCommandType::SUBSCRIBE, topic)){
+        subscriptions[slot] = {String(topic), callback, true};
         return true;
     }
 
-    char msgBuffer[256];
-    snprintf(msgBuffer, sizeof(msgBuffer), "Attempting to connect to MQTT-Broker '%s' (['%s', %d], ['%s', %d])", config.mqtt.broker, config.mqtt.user, strlen(config.mqtt.user), config.mqtt.password, strlen(config.mqtt.password));
-    log.debug("MQTTManager", msgBuffer);
+    topicTrie.remove(topic, slot);
+    return false;
+}
 
-    bool connectionResult;
-    if(strlen(config.mqtt.user) > 0) {
-        connectionResult = client.connect(clientId, config.mqtt.user, config.mqtt.password);
-    } else {
-        connectionResult = client.connect(clientId);
+bool MQTTManager::unsubscribe(const char* topic){
+    int8_t slot = findSubscription(topic);
+    if (slot < 0) {
+        return false;
     }
 
-    if (connectionResult) {
-        log.info("MQTTManager", "Connected to MQTT broker");
+    if(!pushTopicCommand(MQTTCommandType::UNSUBSCRIBE, topic)){
+        return false;
+    }
 
-        for(const auto& subscription : subscriptions) {
-            client.subscribe(subscription.topic.c_str());
+    topicTrie.remove(topic, slot);
+    subscriptions[slot] = {String(), nullptr, false};
+    return true;
+}
+
+MQTTTopicHandle MQTTManager::registerTopic(const char* subtopic, bool isAbsoluteTopic) {
+    if(!initialized) {
+        log.error("MQTTManager", "MQTTManager not initialized");
+        return INVALID_TOPIC;
+    }
+
+    char fullTopic[MQTTOutboundQueue::MAX_TOPIC_LENGTH + 1];
+    int length = isAbsoluteTopic
+        ? snprintf(fullTopic, sizeof(fullTopic), "%s", subtopic)
+        : snprintf(fullTopic, sizeof(fullTopic), "%s/%s", deviceTopic, subtopic);
+
+    if (length < 0 || length >= static_cast<int>(sizeof(fullTopic))) {
+        LOG_ERROR("MQTTManager", "Topic too long: %s", subtopic);
+        return INVALID_TOPIC;
+    }
+
+    for (uint8_t i = 0; i < topicCount; i++) {
+        if (topics[i].length == length && memcmp(topics[i].topic, fullTopic, length) == 0) {
+            return i;
         }
+    }
 
-        return true;
-    } else {
-        char msgBuffer[64];
-        snprintf(msgBuffer, sizeof(msgBuffer), "Connection failed, rc=%d", client.state());
-        log.error("MQTTManager", msgBuffer);
-        return false;
+    if (topicCount >= MAX_TOPICS) {
+        log.error("MQTTManager", "No free topic slots");
+        return INVALID_TOPIC;
     }
+
+    MQTTTopicEntry& entry = topics[topicCount];
+    memcpy(entry.topic, fullTopic, length + 1);
+    entry.length = length;
+    return topicCount++;
 }
 
-void MQTTManager::disconnect(){
-    if(client.connected()) {
-        client.disconnect();
-        log.info("MQTTManager", "Disconnected from MQTT broker");
+bool MQTTManager::publish(MQTTTopicHandle topic, const char* payload, size_t length, bool retained, MQTTPriority priority, uint8_t qos) {
+    if (topic >= topicCount) {
+        log.error("MQTTManager", "Invalid topic handle");
+        return false;
+    }
+    if (length > MQTTOutboundQueue::MAX_PAYLOAD_LENGTH) {
+        log.error("MQTTManager", "Payload too large");
+        return false;
+    }
+
+    MQTTCommand* command = reserveCommand(MQTTCommandType::PUBLISH);
+    if (!command) {
+        return false;
     }
+
+    const MQTTTopicEntry& entry = topics[topic];
+    command->topic = entry.topic;
+    command->topicLength = entry.length;
+    memcpy(command->payload, payload, length);
+    command->length = length;
+    command->retained = retained;
+    command->priority = priority;
+    command->qos = qos;
+    commandQueue.commit();
+    return true;
 }
 
-bool MQTTManager::subscribe(const char* topic, MQTTCallback callback) {
-    if(!client.connected()) {
-        log.error("MQTTManager", "MQTT client not connected");
+bool MQTTManager::publish(const char* subtopic, const char* payload, bool retained, bool isAbsoluteTopic, MQTTPriority priority, uint8_t qos) {
+    if(!initialized) {
+        log.error("MQTTManager", "MQTTManager not initialized");
         return false;
     }
 
-    for(const auto& subscription : subscriptions) {
-        if(subscription.topic == topic) {
-            log.warning("MQTTManager", "Already subscribed to topic");
-            return false;
-        }
+    size_t length = strlen(payload);
+    if (length > MQTTOutboundQueue::MAX_PAYLOAD_LENGTH) {
+        log.error("MQTTManager", "Payload too large");
+        return false;
+    }
+
+    MQTTCommand* command = reserveCommand(MQTTCommandType::PUBLISH);
+    if (!command) {
+        return false;
     }
 
-    if(client.subscribe(topic)){
-        subscriptions.push_back({String(topic), callback});
-        
-        char msgBuffer[128];
-        snprintf(msgBuffer, sizeof(msgBuffer), "Subscribed to topic: %s", topic);
-        log.info("MQTTManager", msgBuffer);
+    int topicLength = isAbsoluteTopic
+        ? snprintf(command->topicBuffer, sizeof(command->topicBuffer), "%s", subtopic)
+        : snprintf(command->topicBuffer, sizeof(command->topicBuffer), "%s/%s", deviceTopic, subtopic);
 
-        return true;
+    if (topicLength < 0 || topicLength >= static_cast<int>(sizeof(command->topicBuffer))) {
+        LOG_ERROR("MQTTManager", "Topic too long: %s", subtopic);
+        return false;
     }
 
-    char msgBuffer[128];
-    snprintf(msgBuffer, sizeof(msgBuffer), "Failed to subscribe to topic: %s", topic);
-    log.error("MQTTManager", msgBuffer);
+    command->topic = nullptr;
+    command->topicLength = topicLength;
+    memcpy(command->payload, payload, length);
+    command->length = length;
+    command->retained = retained;
+    command->priority = priority;
+    command->qos = qos;
+    commandQueue.commit();
+    return true;
+}
 
-    return false;
+MQTTCommand* MQTTManager::reserveCommand(MQTTCommandType type) {
+    MQTTCommand* command = commandQueue.reserve();
+    if (!command) {
+        log.error("MQTTManager", "Network command queue full");
+        return nullptr;
+    }
+
+    command->type = type;
+    return command;
 }
 
-bool MQTTManager::unsubscribe(const char* topic){
-    if(!client.connected()) {
-        log.error("MQTTManager", "MQTT client not connected");
+bool MQTTManager::pushTopicCommand(MQTTCommandType type, const char* topic) {
+    size_t length = strlen(topic);
+    if (length > MQTTOutboundQueue::MAX_TOPIC_LENGTH) {
+        log.error("MQTTManager", "Topic too long");
         return false;
     }
 
-    if(client.unsubscribe(topic)){
-        subscriptions.erase(
-            std::remove_if(
-                subscriptions.begin(), 
-                subscriptions.end(),
-                [topic](const Subscription& subscription){
-                    return subscription.topic == topic;
-                }
-            ),
-            subscriptions.end()
-        );
-        return true;
+    MQTTCommand* command = reserveCommand(type);
+    if (!command) {
+        return false;
     }
 
-    return false;
+    memcpy(command->topicBuffer, topic, length + 1);
+    command->topic = nullptr;
+    command->topicLength = length;
+    command->length = 0;
+    commandQueue.commit();
+    return true;
 }
 
-bool MQTTManager::publish(const char* subtopic, const char* payload, bool retained, bool isAbsoluteTopic) {
-    if(!client.connected()) {
-        log.error("MQTTManager", "MQTT client not connected");
-        return false;
+void MQTTManager::getNetworkSettings(const RuntimeConfig& config, MQTTNetworkSettings& settings) {
+    memcpy(settings.broker, config.mqtt.broker, sizeof(settings.broker));
+    settings.port = config.mqtt.port;
+    memcpy(settings.user, config.mqtt.user, sizeof(settings.user));
+    memcpy(settings.password, config.mqtt.password, sizeof(settings.password));
+    settings.retryInterval = config.mqtt.retryInterval;
+    settings.drainBudget = config.mqtt.drainBudget;
+    settings.inflightWindow = config.mqtt.inflightWindow;
+    settings.persistentSession = config.mqtt.persistentSession;
+}
+
+void MQTTManager::update(){
+    if (!initialized) {
+        return;
     }
 
-    char fullTopic[512];
-    if (isAbsoluteTopic) {
-        strncpy(fullTopic, subtopic, sizeof(fullTopic) - 1);
-    } else {
-        snprintf(fullTopic, sizeof(fullTopic), "%s/%s", deviceTopic, subtopic);
+    // Whatever a handler logs stays local; forwarded to the MQTT log topic it
+    // could come back as another inbound message.
+    log.setLocalOnly(true);
+    for (uint8_t i = 0; i < INBOUND_DISPATCH_BUDGET; i++) {
+        MQTTInboundMessage* message = inboundQueue.front();
+        if (!message) {
+            break;
+        }
+
+        handleCallback(message->topic, message->payload, message->length);
+        inboundQueue.pop();
+    }
+    log.setLocalOnly(false);
+}
+
+void MQTTManager::initializeDeviceTopic() {
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+    snprintf(deviceTopic, sizeof(deviceTopic), "%s/%" PRIu32, config.mqtt.baseTopic, static_cast<uint32_t>(config.device.chipID));
+}
+
+void MQTTManager::networkTaskEntry(void* parameter) {
+    static_cast<MQTTManager*>(parameter)->networkLoop();
+}
+
+void MQTTManager::networkLoop() {
+    for (;;) {
+        processCommands();
+
+        if (!client.connected()) {
+            if (connected.load()) {
+                connected.store(false);
+                log.warning("MQTTManager", "Lost connection to MQTT broker");
+            }
+
+            uint32_t now = millis();
+            if (WiFi.status() == WL_CONNECTED && (lastAttempt == 0 || now - lastAttempt >= networkSettings.retryInterval)) {
+                lastAttempt = now;
+                connect();
+            }
+        } else {
+            client.loop();
+            drainQueue();
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(NETWORK_TASK_INTERVAL));
+    }
+}
+
+bool MQTTManager::connect(){
+    const MQTTNetworkSettings& settings = networkSettings;
+
+    LOG_DEBUG("MQTTManager", "Attempting to connect to MQTT-Broker '%s' (['%s', %zu], ['%s', %zu])", settings.broker, settings.user, strlen(settings.user), settings.password, strlen(settings.password));
+
+    if (connectionAttempts.load() < UINT8_MAX) {
+        connectionAttempts++;
     }
-    fullTopic[sizeof(fullTopic) - 1] = '\0';
 
-    if(client.publish(fullTopic, payload, retained)){
-        char msgBuffer[128];
-        snprintf(msgBuffer, sizeof(msgBuffer), "Published message ('%s', '%s')", fullTopic, payload);
-        log.debug("MQTTManager", msgBuffer);
+    bool hasCredentials = strlen(settings.user) > 0;
+    bool connectionResult = client.connect(
+        clientId,
+        hasCredentials ? settings.user : nullptr,
+        hasCredentials ? settings.password : nullptr,
+        nullptr, 0, false, nullptr,
+        !settings.persistentSession);
+
+    if (connectionResult) {
+        log.info("MQTTManager", "Connected to MQTT broker");
+
+        for (uint8_t i = 0; i < filterCount; i++) {
+            client.subscribe(filters[i]);
+        }
+
+        outboundQueue.requeueInFlight();
+
+        if (!outboundQueue.isEmpty()) {
+            LOG_INFO("MQTTManager", "Draining %d queued messages", outboundQueue.getCount());
+        }
+
+        connectionAttempts.store(0);
+        connected.store(true);
         return true;
+    } else {
+        LOG_ERROR("MQTTManager", "Connection failed, rc=%d", client.state());
+        return false;
     }
+}
 
-    char msgBuffer[128];
-    snprintf(msgBuffer, sizeof(msgBuffer), "Failed to publish message to topic: %s", fullTopic);
-    log.error("MQTTManager", msgBuffer);
-    return false;
+void MQTTManager::receive(const char* topic, const uint8_t* payload, uint32_t length) {
+    size_t topicLength = strlen(topic);
+    if (topicLength > MQTTOutboundQueue::MAX_TOPIC_LENGTH || length > MQTTOutboundQueue::MAX_PAYLOAD_LENGTH) {
+        inboundDropped++;
+        return;
+    }
+
+    MQTTInboundMessage* message = inboundQueue.reserve();
+    if (!message) {
+        return;
+    }
+
+    memcpy(message->topic, topic, topicLength + 1);
+    memcpy(message->payload, payload, length);
+    message->payload[length] = '\0';
+    message->length = length;
+    inboundQueue.commit();
 }
 
-void MQTTManager::update(){
-    if (!initialized) {
+void MQTTManager::processCommands() {
+    uint32_t now = millis();
+
+    for (MQTTCommand* command = commandQueue.front(); command; command = commandQueue.front()) {
+        const char* topic = command->topic ? command->topic : command->topicBuffer;
+
+        switch (command->type) {
+            case MQTTCommandType::PUBLISH:
+                if (!outboundQueue.push(topic, command->topicLength, command->topic != nullptr, command->payload, command->length, command->retained, command->priority, command->qos, now)) {
+                    LOG_ERROR("MQTTManager", "Failed to queue message for topic: %s", topic);
+                }
+                break;
+            case MQTTCommandType::SUBSCRIBE:
+                addFilter(topic);
+                if (client.connected() && !client.subscribe(topic)) {
+                    LOG_ERROR("MQTTManager", "Failed to subscribe to topic: %s", topic);
+                } else {
+                    LOG_INFO("MQTTManager", "Subscribed to topic: %s", topic);
+                }
+                break;
+            case MQTTCommandType::UNSUBSCRIBE:
+                removeFilter(topic);
+                if (client.connected()) {
+                    client.unsubscribe(topic);
+                }
+                break;
+            case MQTTCommandType::CONFIGURE:
+                applySettings(command->settings);
+                break;
+            case MQTTCommandType::DISCONNECT:
+                if (client.connected()) {
+                    client.disconnect();
+                    connected.store(false);
+                    log.info("MQTTManager", "Disconnected from MQTT broker");
+                }
+                break;
+            default:
+                break;
+        }
+
+        commandQueue.pop();
+    }
+}
+
+void MQTTManager::applySettings(const MQTTNetworkSettings& settings) {
+    bool reconnect = strcmp(networkSettings.broker, settings.broker) != 0
+        || networkSettings.port != settings.port
+        || strcmp(networkSettings.user, settings.user) != 0
+        || strcmp(networkSettings.password, settings.password) != 0
+        || networkSettings.persistentSession != settings.persistentSession;
+
+    networkSettings = settings;
+    if (!reconnect) {
         return;
     }
 
-    if(!client.connected()){
-        RuntimeConfig& config = configManager.getRuntimeConfig();
-        uint32_t now = millis();
+    client.setServer(networkSettings.broker, networkSettings.port);
+    if (client.connected()) {
+        client.disconnect();
+    }
+    connected.store(false);
+    lastAttempt = 0;
+    log.info("MQTTManager", "Reconnecting with updated broker settings");
+}
 
-        if(now - lastAttempt >= config.mqtt.retryInterval) {
-            lastAttempt = now;
-            if (connect()) {
-                lastAttempt = 0;
-            }
+void MQTTManager::addFilter(const char* topic) {
+    for (uint8_t i = 0; i < filterCount; i++) {
+        if (strcmp(filters[i], topic) == 0) {
+            return;
+        }
+    }
+
+    if (filterCount < MAX_SUBSCRIPTIONS) {
+        strcpy(filters[filterCount++], topic);
+    }
+}
+
+void MQTTManager::removeFilter(const char* topic) {
+    for (uint8_t i = 0; i < filterCount; i++) {
+        if (strcmp(filters[i], topic) == 0) {
+            memmove(filters[i], filters[i + 1], (filterCount - i - 1) * sizeof(filters[0]));
+            filterCount--;
+            return;
         }
-    }else {
-        client.loop();
     }
 }
 
-bool MQTTManager::isConnected(){
-    return client.connected();
+void MQTTManager::drainQueue() {
+    uint32_t now = millis();
+
+    uint16_t packetId;
+    while (ackClient.popAck(packetId)) {
+        outboundQueue.acknowledge(packetId, now);
+    }
+
+    for (uint8_t i = 0; i < networkSettings.drainBudget; i++) {
+        MQTTQueuedMessage* message = outboundQueue.next(networkSettings.inflightWindow);
+        if (!message) {
+            return;
+        }
+
+        if (message->qos > 0 && !message->duplicate) {
+            message->packetId = allocatePacketId();
+        }
+
+        bool written = message->qos > 0
+            ? ackClient.writePublish(*message)
+            : client.publish(message->topic, reinterpret_cast<const uint8_t*>(message->payload), message->length, message->retained);
+
+        if (written) {
+            LOG_DEBUG("MQTTManager", "Published message ('%s', %u bytes)", message->topic, message->length);
+
+            if (message->qos > 0) {
+                outboundQueue.markInFlight(message, message->packetId, now);
+            } else {
+                outboundQueue.complete(message, true, now);
+            }
+            continue;
+        }
+
+        // A write that fails on a live connection will not succeed on retry.
+        if (!client.connected()) {
+            return;
+        }
+
+        LOG_ERROR("MQTTManager", "Failed to publish message to topic: %s", message->topic);
+        outboundQueue.complete(message, false, now);
+    }
 }
 
-void MQTTManager::initializeDeviceTopic() {
-    RuntimeConfig& config = configManager.getRuntimeConfig();
-    snprintf(deviceTopic, sizeof(deviceTopic), "%s/%u", config.mqtt.baseTopic, static_cast<uint32_t>(config.device.chipID));
-}
\ No newline at end of file
+uint16_t MQTTManager::allocatePacketId() {
+    uint16_t packetId = nextPacketId;
+    nextPacketId = nextPacketId == UINT16_MAX ? FIRST_PACKET_ID : nextPacketId + 1;
+    return packetId;
+}
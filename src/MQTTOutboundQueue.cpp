@@ -0,0 +1,182 @@
+#include "MQTTOutboundQueue.h"
+
+MQTTOutboundQueue::MQTTOutboundQueue()
+    : count(0)
+    , freeCount(0)
+    , windowStart(0)
+    , windowSent(0) {
+    memset(&stats, 0, sizeof(stats));
+    clear();
+}
+
+bool MQTTOutboundQueue::push(const char* topic, size_t topicLength, bool interned, const char* payload, size_t length, bool retained, MQTTPriority priority, uint8_t qos, uint32_t now) {
+    if (topicLength > MAX_TOPIC_LENGTH || length > MAX_PAYLOAD_LENGTH) {
+        stats.rejected++;
+        return false;
+    }
+
+    if (freeCount == 0 && !evict(priority)) {
+        stats.dropped++;
+        return false;
+    }
+
+    uint8_t index = freeSlots[--freeCount];
+    MQTTQueuedMessage& message = slots[index];
+    if (interned) {
+        message.topic = topic;
+    } else {
+        memcpy(message.topicBuffer, topic, topicLength);
+        message.topicBuffer[topicLength] = '\0';
+        message.topic = message.topicBuffer;
+    }
+    message.topicLength = topicLength;
+    memcpy(message.payload, payload, length);
+    message.payload[length] = '\0';
+    message.length = length;
+    message.retained = retained;
+    message.priority = priority;
+    message.qos = qos > 0 ? 1 : 0;
+    message.packetId = 0;
+    message.inFlight = false;
+    message.duplicate = false;
+    message.queuedAt = now;
+    message.sentAt = 0;
+
+    order[count++] = index;
+    stats.enqueued++;
+    stats.depth = count;
+    if (count > stats.highWater) {
+        stats.highWater = count;
+    }
+    return true;
+}
+
+MQTTQueuedMessage* MQTTOutboundQueue::next(uint8_t inflightWindow) {
+    for (uint8_t i = 0; i < count; i++) {
+        MQTTQueuedMessage& message = slots[order[i]];
+        if (message.inFlight) {
+            continue;
+        }
+        if (message.qos > 0 && stats.inFlight >= inflightWindow) {
+            return nullptr;
+        }
+        return &message;
+    }
+    return nullptr;
+}
+
+void MQTTOutboundQueue::markInFlight(MQTTQueuedMessage* message, uint16_t packetId, uint32_t now) {
+    if (message->duplicate) {
+        stats.retransmits++;
+    }
+    message->packetId = packetId;
+    message->inFlight = true;
+    message->sentAt = now;
+    stats.inFlight++;
+}
+
+bool MQTTOutboundQueue::acknowledge(uint16_t packetId, uint32_t now) {
+    for (uint8_t i = 0; i < count; i++) {
+        const MQTTQueuedMessage& message = slots[order[i]];
+        if (message.inFlight && message.packetId == packetId) {
+            stats.acknowledged++;
+            complete(&message, true, now);
+            return true;
+        }
+    }
+    return false;
+}
+
+void MQTTOutboundQueue::requeueInFlight() {
+    for (uint8_t i = 0; i < count; i++) {
+        MQTTQueuedMessage& message = slots[order[i]];
+        if (message.inFlight) {
+            message.inFlight = false;
+            message.duplicate = true;
+        }
+    }
+    stats.inFlight = 0;
+}
+
+void MQTTOutboundQueue::complete(const MQTTQueuedMessage* message, bool sent, uint32_t now) {
+    uint8_t position = find(message);
+    if (position == count) {
+        return;
+    }
+
+    if (message->inFlight) {
+        stats.inFlight--;
+    }
+    remove(position);
+
+    if (sent) {
+        stats.sent++;
+        windowSent++;
+        updateRate(now);
+    } else {
+        stats.failed++;
+    }
+}
+
+void MQTTOutboundQueue::clear() {
+    count = 0;
+    freeCount = CAPACITY;
+    for (uint8_t i = 0; i < CAPACITY; i++) {
+        freeSlots[i] = CAPACITY - 1 - i;
+    }
+    stats.depth = 0;
+    stats.inFlight = 0;
+}
+
+bool MQTTOutboundQueue::evict(MQTTPriority priority) {
+    uint8_t victim = count;
+    for (uint8_t i = 0; i < count; i++) {
+        MQTTPriority queued = slots[order[i]].priority;
+        if (queued > priority || slots[order[i]].inFlight) {
+            continue;
+        }
+        if (victim == count || queued < slots[order[victim]].priority) {
+            victim = i;
+        }
+    }
+
+    if (victim == count) {
+        return false;
+    }
+
+    remove(victim);
+    stats.dropped++;
+    return true;
+}
+
+uint8_t MQTTOutboundQueue::find(const MQTTQueuedMessage* message) const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (&slots[order[i]] == message) {
+            return i;
+        }
+    }
+    return count;
+}
+
+void MQTTOutboundQueue::remove(uint8_t position) {
+    freeSlots[freeCount++] = order[position];
+    memmove(&order[position], &order[position + 1], count - position - 1);
+    count--;
+    stats.depth = count;
+}
+
+void MQTTOutboundQueue::updateRate(uint32_t now) {
+    if (windowStart == 0) {
+        windowStart = now;
+        return;
+    }
+
+    uint32_t elapsed = now - windowStart;
+    if (elapsed < RATE_WINDOW) {
+        return;
+    }
+
+    stats.drainRate = windowSent * 1000.0f / elapsed;
+    windowSent = 0;
+    windowStart = now;
+}
@@ -0,0 +1,192 @@
+#include "MQTTTopicTrie.h"
+
+bool MQTTTopicTrie::insert(const char* filter, uint8_t handler) {
+    const char* levels[MAX_DEPTH];
+    uint8_t lengths[MAX_DEPTH];
+    uint8_t depth = split(filter, levels, lengths);
+    if (depth == 0) {
+        return false;
+    }
+
+    uint16_t node = 0;
+    for (uint8_t i = 0; i < depth; i++) {
+        bool isHash = lengths[i] == 1 && levels[i][0] == '#';
+        if (isHash && i != depth - 1) {
+            return false;
+        }
+
+        node = findOrCreateChild(node, levels[i], lengths[i]);
+        if (node == NONE) {
+            return false;
+        }
+    }
+
+    for (uint16_t entry = nodes[node].firstEntry; entry != NONE; entry = entries[entry].next) {
+        if (entries[entry].handler == handler) {
+            return true;
+        }
+    }
+
+    if (freeEntry == NONE) {
+        return false;
+    }
+
+    uint16_t entry = freeEntry;
+    freeEntry = entries[entry].next;
+    entries[entry].handler = handler;
+    entries[entry].next = nodes[node].firstEntry;
+    nodes[node].firstEntry = entry;
+    entryCount++;
+    return true;
+}
+
+bool MQTTTopicTrie::remove(const char* filter, uint8_t handler) {
+    const char* levels[MAX_DEPTH];
+    uint8_t lengths[MAX_DEPTH];
+    uint8_t depth = split(filter, levels, lengths);
+
+    uint16_t node = 0;
+    for (uint8_t i = 0; i < depth && node != NONE; i++) {
+        const Node& current = nodes[node];
+        if (lengths[i] == 1 && levels[i][0] == '+') {
+            node = current.plusChild;
+        } else if (lengths[i] == 1 && levels[i][0] == '#') {
+            node = current.hashChild;
+        } else {
+            node = findChild(node, levels[i], lengths[i], hashLevel(levels[i], lengths[i]));
+        }
+    }
+    if (depth == 0 || node == NONE) {
+        return false;
+    }
+
+    uint16_t* link = &nodes[node].firstEntry;
+    while (*link != NONE) {
+        uint16_t entry = *link;
+        if (entries[entry].handler == handler) {
+            *link = entries[entry].next;
+            entries[entry].next = freeEntry;
+            freeEntry = entry;
+            entryCount--;
+            return true;
+        }
+        link = &entries[entry].next;
+    }
+    return false;
+}
+
+void MQTTTopicTrie::clear() {
+    nodeCount = 0;
+    entryCount = 0;
+    nameLength = 0;
+
+    for (uint16_t i = 0; i < CHILD_TABLE_SIZE; i++) {
+        children[i] = NONE;
+    }
+    for (uint16_t i = 0; i < MAX_ENTRIES; i++) {
+        entries[i].next = i + 1 < MAX_ENTRIES ? i + 1 : NONE;
+    }
+    freeEntry = 0;
+
+    createNode(NONE, "", 0, 0);
+}
+
+uint16_t MQTTTopicTrie::findChild(uint16_t parent, const char* level, uint8_t length, uint32_t hash) const {
+    for (uint16_t slot = getSlot(parent, hash); children[slot] != NONE; slot = (slot + 1) & (CHILD_TABLE_SIZE - 1)) {
+        const Node& node = nodes[children[slot]];
+        if (node.parent == parent && node.hash == hash && node.length == length && memcmp(&names[node.name], level, length) == 0) {
+            return children[slot];
+        }
+    }
+    return NONE;
+}
+
+uint16_t MQTTTopicTrie::findOrCreateChild(uint16_t parent, const char* level, uint8_t length) {
+    bool isPlus = length == 1 && level[0] == '+';
+    bool isHash = length == 1 && level[0] == '#';
+
+    if (isPlus || isHash) {
+        uint16_t existing = isPlus ? nodes[parent].plusChild : nodes[parent].hashChild;
+        if (existing != NONE) {
+            return existing;
+        }
+
+        uint16_t node = createNode(parent, level, length, 0);
+        if (node != NONE) {
+            (isPlus ? nodes[parent].plusChild : nodes[parent].hashChild) = node;
+        }
+        return node;
+    }
+
+    uint32_t hash = hashLevel(level, length);
+    uint16_t existing = findChild(parent, level, length, hash);
+    if (existing != NONE) {
+        return existing;
+    }
+
+    uint16_t node = createNode(parent, level, length, hash);
+    if (node != NONE) {
+        uint16_t slot = getSlot(parent, hash);
+        while (children[slot] != NONE) {
+            slot = (slot + 1) & (CHILD_TABLE_SIZE - 1);
+        }
+        children[slot] = node;
+    }
+    return node;
+}
+
+uint16_t MQTTTopicTrie::createNode(uint16_t parent, const char* level, uint8_t length, uint32_t hash) {
+    if (nodeCount >= MAX_NODES || nameLength + length > NAME_ARENA_SIZE) {
+        return NONE;
+    }
+
+    Node& node = nodes[nodeCount];
+    node.name = nameLength;
+    node.length = length;
+    node.hash = hash;
+    node.parent = parent;
+    node.plusChild = NONE;
+    node.hashChild = NONE;
+    node.firstEntry = NONE;
+
+    memcpy(&names[nameLength], level, length);
+    nameLength += length;
+    return nodeCount++;
+}
+
+uint8_t MQTTTopicTrie::split(const char* topic, const char* levels[], uint8_t lengths[]) {
+    if (!topic || topic[0] == '\0') {
+        return 0;
+    }
+
+    uint8_t depth = 0;
+    const char* start = topic;
+    for (const char* p = topic; ; p++) {
+        if (*p != '/' && *p != '\0') {
+            continue;
+        }
+
+        size_t length = p - start;
+        if (depth >= MAX_DEPTH || length > UINT8_MAX) {
+            return 0;
+        }
+        levels[depth] = start;
+        lengths[depth] = length;
+        depth++;
+
+        if (*p == '\0') {
+            break;
+        }
+        start = p + 1;
+    }
+    return depth;
+}
+
+uint32_t MQTTTopicTrie::hashLevel(const char* level, uint8_t length) {
+    uint32_t hash = 2166136261u;
+    for (uint8_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(level[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
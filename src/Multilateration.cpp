@@ -0,0 +1,174 @@
+#include "Multilateration.h"
+
+static const float CONVERGENCE_STEP = 0.001f;
+static const float MIN_DISTANCE = 0.0001f;
+static const float DAMPING = 0.0001f;
+// Anchors are usually mounted in one plane, where the centroid is a saddle
+// between the mirrored solutions; start below it, as tags sit under anchors.
+static const float INITIAL_DEPTH = 1.0f;
+
+bool Multilateration::addRange(float x, float y, float z, float range) {
+    if (count >= MAX_ANCHORS || range < 0.0f) {
+        return false;
+    }
+
+    ranges[count].x = x;
+    ranges[count].y = y;
+    ranges[count].z = z;
+    ranges[count].range = range;
+    count++;
+
+    return true;
+}
+
+bool Multilateration::solve(PositionFix& fix, bool solve3d) const {
+    uint8_t dimensions = solve3d ? 3 : 2;
+    memset(&fix, 0, sizeof(fix));
+    fix.anchorCount = count;
+
+    if (count < dimensions + 1) {
+        return false;
+    }
+
+    float position[3];
+    initialGuess(position);
+    if (!solve3d) {
+        position[2] = height;
+    } else {
+        position[2] -= INITIAL_DEPTH;
+    }
+
+    float jtj[3][3];
+    float jtr[3];
+    float inverse[3][3];
+
+    for (uint8_t iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
+        buildNormalEquations(position, dimensions, jtj, jtr);
+
+        float damped[3][3];
+        memcpy(damped, jtj, sizeof(damped));
+        for (uint8_t i = 0; i < dimensions; i++) {
+            damped[i][i] += DAMPING * (jtj[i][i] + 1.0f);
+        }
+
+        if (!invert(damped, dimensions, inverse)) {
+            return false;
+        }
+
+        float stepNorm = 0.0f;
+        for (uint8_t i = 0; i < dimensions; i++) {
+            float step = 0.0f;
+            for (uint8_t j = 0; j < dimensions; j++) {
+                step -= inverse[i][j] * jtr[j];
+            }
+            position[i] += step;
+            stepNorm += step * step;
+        }
+
+        fix.iterations = iteration + 1;
+        if (stepNorm < CONVERGENCE_STEP * CONVERGENCE_STEP) {
+            fix.converged = true;
+            break;
+        }
+    }
+
+    float sumSquares = buildNormalEquations(position, dimensions, jtj, jtr);
+    if (!invert(jtj, dimensions, inverse)) {
+        return false;
+    }
+
+    float variance = count > dimensions ? sumSquares / (count - dimensions) : 0.0f;
+    for (uint8_t i = 0; i < dimensions; i++) {
+        for (uint8_t j = 0; j < dimensions; j++) {
+            fix.covariance[i][j] = inverse[i][j] * variance;
+        }
+    }
+
+    fix.x = position[0];
+    fix.y = position[1];
+    fix.z = position[2];
+    fix.residual = sqrtf(sumSquares / count);
+
+    return fix.converged;
+}
+
+void Multilateration::initialGuess(float position[3]) const {
+    position[0] = position[1] = position[2] = 0.0f;
+
+    for (uint8_t i = 0; i < count; i++) {
+        position[0] += ranges[i].x;
+        position[1] += ranges[i].y;
+        position[2] += ranges[i].z;
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        position[i] /= count;
+    }
+}
+
+float Multilateration::buildNormalEquations(const float position[3], uint8_t dimensions, float jtj[3][3], float jtr[3]) const {
+    memset(jtj, 0, sizeof(float) * 9);
+    memset(jtr, 0, sizeof(float) * 3);
+    float sumSquares = 0.0f;
+
+    for (uint8_t n = 0; n < count; n++) {
+        const Range& range = ranges[n];
+        float delta[3] = {position[0] - range.x, position[1] - range.y, position[2] - range.z};
+        float distance = sqrtf(delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2]);
+        if (distance < MIN_DISTANCE) {
+            distance = MIN_DISTANCE;
+        }
+
+        float residual = distance - range.range;
+        sumSquares += residual * residual;
+
+        float jacobian[3];
+        for (uint8_t i = 0; i < dimensions; i++) {
+            jacobian[i] = delta[i] / distance;
+        }
+
+        for (uint8_t i = 0; i < dimensions; i++) {
+            jtr[i] += jacobian[i] * residual;
+            for (uint8_t j = 0; j < dimensions; j++) {
+                jtj[i][j] += jacobian[i] * jacobian[j];
+            }
+        }
+    }
+
+    return sumSquares;
+}
+
+bool Multilateration::invert(const float m[3][3], uint8_t dimensions, float inverse[3][3]) {
+    memset(inverse, 0, sizeof(float) * 9);
+
+    if (dimensions == 2) {
+        float det = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+        if (fabsf(det) < 1e-9f) {
+            return false;
+        }
+
+        inverse[0][0] = m[1][1] / det;
+        inverse[0][1] = -m[0][1] / det;
+        inverse[1][0] = -m[1][0] / det;
+        inverse[1][1] = m[0][0] / det;
+        return true;
+    }
+
+    float det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+              - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+              + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    if (fabsf(det) < 1e-9f) {
+        return false;
+    }
+
+    inverse[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) / det;
+    inverse[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) / det;
+    inverse[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / det;
+    inverse[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) / det;
+    inverse[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / det;
+    inverse[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / det;
+    inverse[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) / det;
+    inverse[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) / det;
+    inverse[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / det;
+    return true;
+}
@@ -0,0 +1,552 @@
+#include "RPCManager.h"
+
+static const char* LOG_LEVEL_NAMES[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+bool RPCManager::begin() {
+    if (initialized) {
+        return true;
+    }
+
+    if (!mqttManager.isInitialized()) {
+        log.warning("RPCManager", "MQTTManager not initialized, skipping RPCManager initialization");
+        return false;
+    }
+
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        requests[i].state = RPCRequestState::FREE;
+    }
+    registerDefaultCommands();
+
+    responseTopic = mqttManager.registerTopic("rpc/res");
+
+    char requestTopic[MQTTOutboundQueue::MAX_TOPIC_LENGTH + 1];
+    snprintf(requestTopic, sizeof(requestTopic), "%s/rpc/req", mqttManager.getDeviceTopic());
+    if (!mqttManager.subscribe(requestTopic, [this](const char* topic, const uint8_t* payload, unsigned int length) {
+        handleRequest(payload, length);
+    })) {
+        log.error("RPCManager", "Failed to subscribe to request topic");
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(workerTaskEntry, "rpc", WORKER_TASK_STACK_SIZE, this, WORKER_TASK_PRIORITY, &workerTask, WORKER_TASK_CORE) != pdPASS) {
+        log.error("RPCManager", "Failed to start worker task");
+        return false;
+    }
+
+    initialized = true;
+
+    return true;
+}
+
+void RPCManager::registerDefaultCommands() {
+    registerCommand("range-now", RPCExecution::INLINE, [this](RPCRequest& request, JsonObjectConst params, JsonObject result) {
+        return rangeNow(request, params, result);
+    });
+    registerCommand("scan", RPCExecution::INLINE, [this](RPCRequest& request, JsonObjectConst params, JsonObject result) {
+        return scan(request, params, result);
+    });
+    registerCommand("set-log-level", RPCExecution::INLINE, [this](RPCRequest& request, JsonObjectConst params, JsonObject result) {
+        return setLogLevel(request, params, result);
+    });
+    registerCommand("reboot", RPCExecution::INLINE, [this](RPCRequest& request, JsonObjectConst params, JsonObject result) {
+        return reboot(request, params, result);
+    });
+    registerCommand("calibrate", RPCExecution::INLINE, [this](RPCRequest& request, JsonObjectConst params, JsonObject result) {
+        return calibrate(request, params, result);
+    });
+    registerCommand("replay", RPCExecution::WORKER, [this](RPCRequest& request, JsonObjectConst params, JsonObject result) {
+        return replay(request, params, result);
+    }, [this](RPCRequest& request) {
+        wifiManager.flushFtmRecord();
+        wifiManager.getFtmReplayConfig(replayConfig);
+    });
+    registerCommand("stats", RPCExecution::INLINE, [this](RPCRequest& request, JsonObjectConst params, JsonObject result) {
+        return stats(request, params, result);
+    });
+    registerCommand("bench", RPCExecution::INLINE, [this](RPCRequest& request, JsonObjectConst params, JsonObject result) {
+        return bench(request, params, result);
+    });
+}
+
+bool RPCManager::registerCommand(const char* name, RPCExecution execution, RPCHandler handler, RPCPrepare prepare) {
+    if (findCommand(name) >= 0) {
+        return true;
+    }
+
+    if (commandCount >= MAX_COMMANDS) {
+        LOG_ERROR("RPCManager", "Command table full, dropping '%s'", name);
+        return false;
+    }
+
+    RPCCommand& command = commands[commandCount++];
+    command.name = name;
+    command.execution = execution;
+    command.handler = handler;
+    command.prepare = prepare;
+    memset(&command.stats, 0, sizeof(command.stats));
+
+    return true;
+}
+
+int8_t RPCManager::findCommand(const char* name) {
+    for (uint8_t i = 0; i < commandCount; i++) {
+        if (strcmp(commands[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+RPCRequest* RPCManager::allocateRequest() {
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        if (requests[i].state == RPCRequestState::FREE) {
+            return &requests[i];
+        }
+    }
+    return nullptr;
+}
+
+void RPCManager::handleRequest(const uint8_t* payload, unsigned int length) {
+    StaticJsonDocument<REQUEST_DOC_SIZE> doc;
+    if (deserializeJson(doc, payload, length)) {
+        respondError("null", nullptr, "invalid request");
+        return;
+    }
+
+    char id[RPCRequest::MAX_ID_LENGTH + 1];
+    JsonVariantConst idValue = doc["id"];
+    if (measureJson(idValue) > RPCRequest::MAX_ID_LENGTH) {
+        respondError("null", nullptr, "id too long");
+        return;
+    }
+    serializeJson(idValue, id, sizeof(id));
+
+    const char* name = doc["cmd"];
+    if (!name) {
+        respondError(id, nullptr, "missing cmd");
+        return;
+    }
+
+    int8_t command = findCommand(name);
+    if (command < 0) {
+        respondError(id, name, "unknown command");
+        return;
+    }
+
+    JsonVariantConst params = doc["params"];
+    if (measureJson(params) > RPCRequest::MAX_PARAMS_LENGTH) {
+        respondError(id, name, "params too long");
+        return;
+    }
+
+    RPCRequest* request = allocateRequest();
+    if (!request) {
+        respondError(id, name, "busy");
+        return;
+    }
+
+    request->sequence = nextSequence++;
+    request->command = command;
+    strcpy(request->id, id);
+    serializeJson(params, request->params, sizeof(request->params));
+    request->result[0] = '\0';
+    request->success = false;
+    request->receivedAt = micros();
+    request->startedAt = request->receivedAt;
+    request->completedAt = request->receivedAt;
+    request->state = RPCRequestState::QUEUED;
+}
+
+void RPCManager::update() {
+    if (!initialized) {
+        return;
+    }
+
+    if (rebootAt != 0 && static_cast<int32_t>(millis() - rebootAt) >= 0) {
+        log.flush();
+        ESP.restart();
+    }
+
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        RPCRequest& request = requests[i];
+
+        if (request.state == RPCRequestState::QUEUED) {
+            if (commands[request.command].execution == RPCExecution::INLINE) {
+                execute(request);
+            } else if (!workerBusy) {
+                if (commands[request.command].prepare) {
+                    commands[request.command].prepare(request);
+                }
+                workerBusy = true;
+                request.state = RPCRequestState::RUNNING;
+                xTaskNotify(workerTask, i, eSetValueWithOverwrite);
+            }
+        }
+
+        if (request.state == RPCRequestState::DONE) {
+            respond(request);
+            request.state = RPCRequestState::FREE;
+        }
+    }
+
+    benchmark.update();
+    checkTimeouts();
+}
+
+void RPCManager::execute(RPCRequest& request) {
+    RPCCommand& command = commands[request.command];
+
+    StaticJsonDocument<RPCRequest::MAX_PARAMS_LENGTH * 2> paramsDoc;
+    deserializeJson(paramsDoc, request.params);
+
+    StaticJsonDocument<RESULT_DOC_SIZE> resultDoc;
+    JsonObject result = resultDoc.to<JsonObject>();
+
+    request.state = RPCRequestState::RUNNING;
+    request.startedAt = micros();
+
+    RPCStatus status = command.handler(request, paramsDoc.as<JsonObjectConst>(), result);
+    if (status == RPCStatus::PENDING && command.execution == RPCExecution::INLINE) {
+        return;
+    }
+
+    finish(request, status == RPCStatus::OK, resultDoc);
+}
+
+void RPCManager::finish(RPCRequest& request, bool success, const JsonDocument& result) {
+    request.completedAt = micros();
+    request.success = success;
+
+    if (measureJson(result) > RPCRequest::MAX_RESULT_LENGTH) {
+        strcpy(request.result, "{\"error\":\"result too large\"}");
+        request.success = false;
+    } else {
+        serializeJson(result, request.result, sizeof(request.result));
+    }
+
+    request.state = RPCRequestState::DONE;
+}
+
+bool RPCManager::complete(uint32_t sequence, bool success, const JsonDocument& result) {
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        RPCRequest& request = requests[i];
+        if (request.state == RPCRequestState::RUNNING && request.sequence == sequence
+            && commands[request.command].execution == RPCExecution::INLINE) {
+            finish(request, success, result);
+            return true;
+        }
+    }
+    return false;
+}
+
+void RPCManager::checkTimeouts() {
+    uint32_t now = micros();
+
+    for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+        RPCRequest& request = requests[i];
+        if (request.state != RPCRequestState::RUNNING || commands[request.command].execution != RPCExecution::INLINE) {
+            continue;
+        }
+
+        if ((now - request.startedAt) / 1000 >= REQUEST_TIMEOUT) {
+            StaticJsonDocument<64> doc;
+            doc["error"] = "timeout";
+            finish(request, false, doc);
+        }
+    }
+}
+
+void RPCManager::respond(RPCRequest& request) {
+    RPCCommand& command = commands[request.command];
+    uint32_t execMicros = request.completedAt - request.startedAt;
+
+    command.stats.calls++;
+    command.stats.totalMicros += execMicros;
+    if (execMicros > command.stats.maxMicros) {
+        command.stats.maxMicros = execMicros;
+    }
+    if (!request.success) {
+        command.stats.failures++;
+    }
+
+    StaticJsonDocument<RESPONSE_DOC_SIZE> doc;
+    doc["id"] = serialized(static_cast<const char*>(request.id));
+    doc["cmd"] = command.name;
+    doc["ok"] = request.success;
+    doc["queue_us"] = request.startedAt - request.receivedAt;
+    doc["exec_us"] = execMicros;
+    doc["result"] = serialized(static_cast<const char*>(request.result));
+
+    char payload[MQTTOutboundQueue::MAX_PAYLOAD_LENGTH + 1];
+    size_t length = serializeJson(doc, payload, sizeof(payload));
+    mqttManager.publish(responseTopic, payload, length, false, MQTTPriority::NORMAL, 1);
+
+    if (request.success) {
+        LOG_DEBUG("RPCManager", "Command '%s' completed in %" PRIu32 " us", command.name, execMicros);
+    } else {
+        LOG_WARNING("RPCManager", "Command '%s' failed in %" PRIu32 " us", command.name, execMicros);
+    }
+}
+
+void RPCManager::respondError(const char* id, const char* command, const char* error) {
+    StaticJsonDocument<256> doc;
+    doc["id"] = serialized(id);
+    if (command) {
+        doc["cmd"] = command;
+    }
+    doc["ok"] = false;
+    doc["result"]["error"] = error;
+
+    char payload[256];
+    size_t length = serializeJson(doc, payload, sizeof(payload));
+    mqttManager.publish(responseTopic, payload, length, false, MQTTPriority::NORMAL, 1);
+
+    LOG_WARNING("RPCManager", "Rejected request: %s", error);
+}
+
+void RPCManager::workerTaskEntry(void* parameter) {
+    RPCManager* manager = static_cast<RPCManager*>(parameter);
+    uint32_t index;
+
+    while (true) {
+        if (xTaskNotifyWait(0, UINT32_MAX, &index, portMAX_DELAY) == pdTRUE && index < MAX_REQUESTS) {
+            manager->execute(manager->requests[index]);
+            manager->workerBusy = false;
+        }
+    }
+}
+
+RPCStatus RPCManager::rangeNow(RPCRequest& request, JsonObjectConst params, JsonObject result) {
+    uint32_t sequence = request.sequence;
+    FtmCallback callback = [this, sequence](const FtmResult& ftm) {
+        StaticJsonDocument<RESULT_DOC_SIZE> doc;
+        char bssid[18];
+        snprintf(bssid, sizeof(bssid), "%02x:%02x:%02x:%02x:%02x:%02x", ftm.bssid[0], ftm.bssid[1], ftm.bssid[2], ftm.bssid[3], ftm.bssid[4], ftm.bssid[5]);
+
+        bool success = ftm.state == FtmRequestState::COMPLETED;
+        doc["bssid"] = bssid;
+        doc["status"] = ftm.status;
+        if (success) {
+            doc["distance_cm"] = ftm.distanceCm;
+            doc["rtt_ns"] = ftm.rttNs;
+            doc["rssi"] = ftm.rssi;
+            doc["frames"] = ftm.frames;
+            doc["latency_ms"] = ftm.completedAt - ftm.submittedAt;
+        } else {
+            doc["error"] = "ranging failed";
+        }
+        complete(sequence, success, doc);
+    };
+
+    uint32_t requestId;
+    const char* target = params["bssid"];
+    if (target) {
+        uint8_t bssid[6];
+        if (!FtmReplay::parseBssid(target, bssid)) {
+            result["error"] = "invalid bssid";
+            return RPCStatus::ERROR;
+        }
+        requestId = wifiManager.requestFtmReportBssid(params["channel"] | 0, bssid, callback);
+    } else {
+        requestId = wifiManager.requestFtmReportConnected(callback);
+    }
+
+    if (requestId == 0) {
+        result["error"] = "ftm request rejected";
+        return RPCStatus::ERROR;
+    }
+
+    return RPCStatus::PENDING;
+}
+
+RPCStatus RPCManager::scan(RPCRequest& request, JsonObjectConst params, JsonObject result) {
+    if (wifiManager.isScanning()) {
+        result["error"] = "scan in progress";
+        return RPCStatus::ERROR;
+    }
+
+    uint32_t sequence = request.sequence;
+    ScanCallback callback = [this, sequence](const ScanCache& cache) {
+        StaticJsonDocument<RESULT_DOC_SIZE> doc;
+        uint8_t responders = 0;
+        for (uint8_t i = 0; i < cache.getCount(); i++) {
+            if (cache.get(i)->ftmResponder) {
+                responders++;
+            }
+        }
+        doc["count"] = cache.getCount();
+        doc["responders"] = responders;
+        complete(sequence, true, doc);
+    };
+
+    uint8_t channel = params["channel"] | 0;
+    bool started = channel > 0
+        ? wifiManager.startScan(&channel, 1, callback)
+        : wifiManager.startScan(nullptr, 0, callback);
+
+    if (!started) {
+        result["error"] = "scan failed to start";
+        return RPCStatus::ERROR;
+    }
+
+    return RPCStatus::PENDING;
+}
+
+RPCStatus RPCManager::setLogLevel(RPCRequest& request, JsonObjectConst params, JsonObject result) {
+    const size_t levelCount = static_cast<size_t>(LogLevel::__DELIMITER__);
+    JsonVariantConst value = params["level"];
+    int level = -1;
+
+    if (value.is<int>()) {
+        level = value.as<int>();
+    } else if (value.is<const char*>()) {
+        for (size_t i = 0; i < levelCount; i++) {
+            if (strcasecmp(value.as<const char*>(), LOG_LEVEL_NAMES[i]) == 0) {
+                level = i;
+                break;
+            }
+        }
+    }
+
+    if (level < 0 || level >= static_cast<int>(levelCount)) {
+        result["error"] = "invalid level";
+        return RPCStatus::ERROR;
+    }
+
+    log.setLogLevel(static_cast<LogLevel>(level));
+    result["level"] = log.getLogLevelString();
+
+    return RPCStatus::OK;
+}
+
+RPCStatus RPCManager::reboot(RPCRequest& request, JsonObjectConst params, JsonObject result) {
+    log.warning("RPCManager", "Reboot requested");
+
+    // Leave the network task time to flush the response before restarting.
+    rebootAt = millis() + REBOOT_DELAY;
+    if (rebootAt == 0) {
+        rebootAt = 1;
+    }
+    result["delay_ms"] = static_cast<uint32_t>(REBOOT_DELAY);
+
+    return RPCStatus::OK;
+}
+
+RPCStatus RPCManager::calibrate(RPCRequest& request, JsonObjectConst params, JsonObject result) {
+    uint8_t bssid[6];
+    const char* target = params["bssid"];
+    if (!target || !FtmReplay::parseBssid(target, bssid)) {
+        result["error"] = "invalid bssid";
+        return RPCStatus::ERROR;
+    }
+
+    float distance = params["distance_cm"] | 0.0f;
+    if (distance <= 0) {
+        result["error"] = "invalid distance_cm";
+        return RPCStatus::ERROR;
+    }
+
+    if (CalibrationManager::getInstance().isCalibrating()) {
+        result["error"] = "calibration in progress";
+        return RPCStatus::ERROR;
+    }
+
+    uint16_t samples = params["samples"] | 20;
+    if (!wifiManager.calibrateFtmAnchor(bssid, params["channel"] | 0, distance, samples)) {
+        result["error"] = "calibration failed to start";
+        return RPCStatus::ERROR;
+    }
+
+    result["samples"] = samples;
+
+    return RPCStatus::OK;
+}
+
+RPCStatus RPCManager::replay(RPCRequest& request, JsonObjectConst params, JsonObject result) {
+    const char* defaultPath = WiFiManager::FTM_RECORD_FILE;
+    const char* path = params["path"] | defaultPath;
+
+    FtmReplayStats replayStats;
+    if (!wifiManager.replayFtmRecording(path, replayConfig, replayStats)) {
+        result["error"] = "replay failed";
+        return RPCStatus::ERROR;
+    }
+
+    result["reports"] = replayStats.reports;
+    result["parse_errors"] = replayStats.parseErrors;
+    result["fixes"] = replayStats.fixes;
+    result["engine_us"] = replayStats.engine.totalMicros;
+    result["pipeline_us"] = replayStats.pipeline.totalMicros;
+    result["solver_us"] = replayStats.solver.totalMicros;
+    if (replayStats.errorCount > 0) {
+        result["fix_error_mean"] = replayStats.errorSum / replayStats.errorCount;
+        result["fix_error_max"] = replayStats.errorMax;
+    }
+
+    return RPCStatus::OK;
+}
+
+RPCStatus RPCManager::stats(RPCRequest& request, JsonObjectConst params, JsonObject result) {
+    // [calls, failures, mean_us, max_us] per command
+    for (uint8_t i = 0; i < commandCount; i++) {
+        const RPCCommandStats& commandStats = commands[i].stats;
+        JsonArray entry = result.createNestedArray(commands[i].name);
+        entry.add(commandStats.calls);
+        entry.add(commandStats.failures);
+        entry.add(commandStats.calls > 0 ? commandStats.totalMicros / commandStats.calls : 0);
+        entry.add(commandStats.maxMicros);
+    }
+
+    return RPCStatus::OK;
+}
+
+RPCStatus RPCManager::bench(RPCRequest& request, JsonObjectConst params, JsonObject result) {
+    if (benchmark.isRunning()) {
+        result["error"] = "benchmark in progress";
+        return RPCStatus::ERROR;
+    }
+
+    uint16_t sizes[MQTTBenchmark::MAX_RUNS] = {16, 128, 480};
+    uint8_t sizeCount = 3;
+    JsonArrayConst requestedSizes = params["sizes"];
+    if (!requestedSizes.isNull()) {
+        sizeCount = 0;
+        for (JsonVariantConst size : requestedSizes) {
+            if (sizeCount < MQTTBenchmark::MAX_RUNS) {
+                sizes[sizeCount++] = size.as<uint16_t>();
+            }
+        }
+    }
+
+    // One row per payload size:
+    // [size, sent, received, msgs/s, publish us/msg, p50 us, p90 us, p99 us, max us]
+    uint32_t sequence = request.sequence;
+    MQTTBenchmarkCallback callback = [this, sequence](const MQTTBenchmark& benchmark) {
+        StaticJsonDocument<RESULT_DOC_SIZE> doc;
+        doc["qos"] = benchmark.getQos();
+        doc["debug"] = log.isLogLevelEnabled(LogLevel::DEBUG);
+
+        JsonArray runs = doc.createNestedArray("runs");
+        for (uint8_t i = 0; i < benchmark.getRunCount(); i++) {
+            const MQTTBenchmarkRun& run = benchmark.getRun(i);
+            JsonArray row = runs.createNestedArray();
+            row.add(run.payloadSize);
+            row.add(run.sent);
+            row.add(run.received);
+            row.add(run.durationMicros > 0 ? static_cast<uint32_t>(run.received * 1000000ULL / run.durationMicros) : 0);
+            row.add(run.sent > 0 ? run.publishMicros / run.sent : 0);
+            row.add(run.p50);
+            row.add(run.p90);
+            row.add(run.p99);
+            row.add(run.max);
+        }
+        complete(sequence, true, doc);
+    };
+
+    if (!benchmark.start(sizes, sizeCount, params["count"] | 50, params["window"] | 4, params["qos"] | 0, callback)) {
+        result["error"] = "benchmark failed to start";
+        return RPCStatus::ERROR;
+    }
+
+    return RPCStatus::PENDING;
+}
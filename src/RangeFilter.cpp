@@ -0,0 +1,108 @@
+#include "RangeFilter.h"
+#include <math.h>
+
+void RangeFilter::reset() {
+    windowHead = 0;
+    windowCount = 0;
+    estimate = 0.0f;
+    variance = 0.0f;
+    lastUpdate = 0;
+    initialized = false;
+    consecutiveRejects = 0;
+    rejected = 0;
+}
+
+bool RangeFilter::update(float distance, uint32_t now, const RangeFilterConfig& config, float& filtered) {
+    if ((config.stages & STAGE_GATE) && !gate(distance, config)) {
+        rejected++;
+        filtered = estimate;
+        return false;
+    }
+
+    float value = distance;
+
+    if (config.stages & STAGE_MEDIAN) {
+        uint8_t size = config.medianWindow;
+        if (size > MAX_MEDIAN_WINDOW) {
+            size = MAX_MEDIAN_WINDOW;
+        }
+        if (size > 1) {
+            value = median(value, size);
+        }
+    }
+
+    if (config.stages & STAGE_KALMAN) {
+        value = kalman(value, now, config);
+    } else {
+        estimate = value;
+    }
+
+    initialized = true;
+    filtered = value;
+    return true;
+}
+
+bool RangeFilter::gate(float distance, const RangeFilterConfig& config) {
+    if (!initialized || fabsf(distance - estimate) <= config.gateThreshold) {
+        consecutiveRejects = 0;
+        return true;
+    }
+
+    // A run of rejections means the tag really moved, so restart from here.
+    if (++consecutiveRejects > config.gateMaxRejects) {
+        uint32_t rejectedTotal = rejected;
+        reset();
+        rejected = rejectedTotal;
+        return true;
+    }
+
+    return false;
+}
+
+float RangeFilter::median(float distance, uint8_t size) {
+    if (windowCount > size) {
+        windowCount = size;
+        windowHead %= size;
+    }
+
+    window[windowHead] = distance;
+    windowHead = (windowHead + 1) % size;
+    if (windowCount < size) {
+        windowCount++;
+    }
+
+    float sorted[MAX_MEDIAN_WINDOW];
+    for (uint8_t i = 0; i < windowCount; i++) {
+        float key = window[i];
+        int8_t j = i - 1;
+        while (j >= 0 && sorted[j] > key) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = key;
+    }
+
+    if (windowCount % 2 == 1) {
+        return sorted[windowCount / 2];
+    }
+    return (sorted[windowCount / 2 - 1] + sorted[windowCount / 2]) / 2.0f;
+}
+
+float RangeFilter::kalman(float distance, uint32_t now, const RangeFilterConfig& config) {
+    if (!initialized) {
+        estimate = distance;
+        variance = config.measurementNoise;
+        lastUpdate = now;
+        return estimate;
+    }
+
+    float dt = (now - lastUpdate) / 1000.0f;
+    lastUpdate = now;
+
+    variance += config.processNoise * dt;
+    float gain = variance / (variance + config.measurementNoise);
+    estimate += gain * (distance - estimate);
+    variance *= (1.0f - gain);
+
+    return estimate;
+}
@@ -0,0 +1,44 @@
+#include "ScanCache.h"
+
+void ScanCache::upsert(const ScanResult& result) {
+    ScanResult* slot = const_cast<ScanResult*>(find(result.bssid));
+
+    if (!slot && count < MAX_RESULTS) {
+        slot = &results[count++];
+    }
+
+    if (!slot) {
+        slot = &results[0];
+        for (uint8_t i = 1; i < count; i++) {
+            if (static_cast<int32_t>(results[i].seenAt - slot->seenAt) < 0) {
+                slot = &results[i];
+            }
+        }
+    }
+
+    *slot = result;
+}
+
+void ScanCache::prune(uint32_t now, uint32_t maxAge) {
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (now - results[i].seenAt <= maxAge) {
+            results[kept++] = results[i];
+        }
+    }
+    count = kept;
+}
+
+const ScanResult* ScanCache::find(const uint8_t bssid[6]) const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (memcmp(results[i].bssid, bssid, sizeof(results[i].bssid)) == 0) {
+            return &results[i];
+        }
+    }
+    return nullptr;
+}
+
+bool ScanCache::isFresh(const uint8_t bssid[6], uint32_t now, uint32_t maxAge) const {
+    const ScanResult* result = find(bssid);
+    return result && now - result->seenAt <= maxAge;
+}
@@ -1,9 +1,5 @@
 #include "WiFiManager.h"
 
-const uint8_t FTM_FRAME_COUNT = 16;
-const uint16_t FTM_BURST_PERIOD = 2;
-const char *WIFI_FTM_SSID = "FTM";
-const char *WIFI_FTM_PASS = "password";
 
 const char* WiFiManager::getWifiStatusString(WiFiStatus status) {
     switch (status) {
@@ -30,13 +26,61 @@ bool WiFiManager::begin(){
         return false;
     } 
 
-    ftmSemaphore = xSemaphoreCreateBinary();
+    ftmEngine.setInitiator([](const FtmRequest& request) {
+        if (request.useConnectedAp) {
+            return WiFi.initiateFTM(request.frameCount, request.burstPeriod);
+        }
+        return WiFi.initiateFTM(request.frameCount, request.burstPeriod, request.channel, request.bssid);
+    });
+    ftmEngine.setTerminator([]() {
+        esp_wifi_ftm_end_session();
+    });
     WiFi.onEvent(onFtmReport, ARDUINO_EVENT_WIFI_FTM_REPORT);
 
+    ftmScheduler.setRangeCorrection([](const uint8_t bssid[6], float distanceCm) {
+        return CalibrationManager::getInstance().apply(bssid, distanceCm);
+    });
+    if (config.ftm.recordReports) {
+        LittleFS.remove(FTM_RECORD_FILE);
+    }
+    applyFtmConfig(config);
+
     WiFi.mode(WIFI_STA);
+    esp_wifi_set_vendor_ie_cb(onVendorIe, nullptr);
     return true;
 }
 
+void WiFiManager::applyFtmConfig(const RuntimeConfig& config) {
+    FtmSchedulerConfig schedulerConfig;
+    schedulerConfig.requestTimeout = config.ftm.requestTimeout;
+    schedulerConfig.minInterval = config.ftm.minInterval;
+    schedulerConfig.maxInterval = config.ftm.maxInterval;
+    schedulerConfig.stableThreshold = config.ftm.stableThreshold;
+    schedulerConfig.filter.stages = config.ftm.filterStages;
+    schedulerConfig.filter.gateThreshold = config.ftm.filterGateThreshold;
+    schedulerConfig.filter.gateMaxRejects = config.ftm.filterGateMaxRejects;
+    schedulerConfig.filter.medianWindow = config.ftm.filterMedianWindow;
+    schedulerConfig.filter.processNoise = config.ftm.filterProcessNoise;
+    schedulerConfig.filter.measurementNoise = config.ftm.filterMeasurementNoise;
+    schedulerConfig.burst.enabled = config.ftm.adaptiveBurst;
+    schedulerConfig.burst.frameCount = config.ftm.frameCount;
+    schedulerConfig.burst.burstPeriod = config.ftm.burstPeriod;
+    schedulerConfig.burst.lowDeviation = config.ftm.burstLowDeviation;
+    schedulerConfig.burst.highDeviation = config.ftm.burstHighDeviation;
+    schedulerConfig.burst.maxBurstPeriod = config.ftm.maxBurstPeriod;
+    ftmScheduler.configure(schedulerConfig);
+    estimatorSettings.write(FtmEstimatorSettings{static_cast<FtmEstimatorMethod>(config.ftm.estimator), config.ftm.estimatorParam});
+
+    if (config.ftm.recordReports) {
+        ftmScheduler.setResultCallback([this](const FtmResult& result) {
+            recordFtmResult(result);
+        });
+    } else {
+        ftmScheduler.setResultCallback(nullptr);
+        flushFtmRecord();
+    }
+}
+
 bool WiFiManager::isConnected() {
     return status == WiFiStatus::CONNECTED && WiFi.status() == WL_CONNECTED;
 }
@@ -48,9 +92,7 @@ bool WiFiManager::connect() {
 
     RuntimeConfig& config = configManager.getRuntimeConfig();
 
-    char msgBuffer[256];
-    snprintf(msgBuffer, sizeof(msgBuffer), "Attempting to connect to Wifi-AP '%s' (['%s', %d], ['%s', %d])", config.wifi.ssid, config.wifi.ssid, strlen(config.wifi.ssid), config.wifi.password, strlen(config.wifi.password));
-    log.debug("WiFiManager", msgBuffer);
+    LOG_DEBUG("WiFiManager", "Attempting to connect to Wifi-AP '%s' (['%s', %zu], ['%s', %zu])", config.wifi.ssid, config.wifi.ssid, strlen(config.wifi.ssid), config.wifi.password, strlen(config.wifi.password));
 
     //WiFi.setMinSecurity(WIFI_AUTH_WEP); 
     WiFi.begin(config.wifi.ssid, config.wifi.password);
@@ -71,14 +113,22 @@ void WiFiManager::disconnect() {
 
 void WiFiManager::update(){
     RuntimeConfig &config = configManager.getRuntimeConfig();
+    uint32_t now = millis();
+    processAdvertisements();
+    if (scanning) {
+        updateScan();
+    } else {
+        ftmScheduler.update(now);
+    }
+    ftmEngine.update(now);
+    updateFtmRecord(now);
+
     if(status == WiFiStatus::CONNECTING){
         if (WiFi.status() == WL_CONNECTED){
             status = WiFiStatus::CONNECTED;
             connectionAttempts = 0;
 
-            char msgBuffer[64];
-            snprintf(msgBuffer, sizeof(msgBuffer), "Connected to Wifi-AP with IP: %s", WiFi.localIP().toString().c_str());
-            log.debug("WiFiManager", msgBuffer);
+            LOG_DEBUG("WiFiManager", "Connected to Wifi-AP with IP: %s", WiFi.localIP().toString().c_str());
 
             return;
         }
@@ -90,18 +140,14 @@ void WiFiManager::update(){
             Serial.printf("Connection Attempts: %d (%d)\n", connectionAttempts, config.wifi.maxConnectionAttempts);
             if (connectionAttempts >= config.wifi.maxConnectionAttempts) {
                 status = WiFiStatus::CONNECTION_FAILED;
-                char msgBuffer[192];
-                snprintf(msgBuffer, sizeof(msgBuffer), "Failed to connect to Wifi-AP ('%s') due reaching max connection attempts", config.wifi.ssid);
-                log.error("WiFiManager", msgBuffer);
+                LOG_ERROR("WiFiManager", "Failed to connect to Wifi-AP ('%s') due reaching max connection attempts", config.wifi.ssid);
 
                 return;
             }
         }
     } else if (status == WiFiStatus::CONNECTED && WiFi.status() != WL_CONNECTED) {
         status = WiFiStatus::DISCONNECTED;
-        char msgBuffer[192];
-        snprintf(msgBuffer, sizeof(msgBuffer), "Lost connection to Wifi-AP ('%s')", config.wifi.ssid);
-        log.warning("WiFiManager", msgBuffer);
+        LOG_WARNING("WiFiManager", "Lost connection to Wifi-AP ('%s')", config.wifi.ssid);
 
         if (config.wifi.autoReconnect && millis() - lastAttempt >= config.wifi.reconnectInterval) {
             connect();
@@ -134,94 +180,394 @@ uint8_t* WiFiManager::getBSSID() {
     return WiFi.BSSID();
 }
 
-bool WiFiManager::getFtmReportConnected() {
+uint32_t WiFiManager::requestFtmReport(const FtmRequest& request, FtmCallback callback) {
+    uint32_t requestId = ftmEngine.submit(request, millis(), callback);
+    if (requestId == 0) {
+        log.warning("WiFiManager", "FTM request queue full, request rejected");
+        return 0;
+    }
+
+    LOG_DEBUG("WiFiManager", "Queued FTM request #%" PRIu32 " with Frame Count %d and Burst Period %d ms", requestId, request.frameCount, request.burstPeriod * 100);
 
-    Serial.print("Initiating FTM session to Connected with Frame Count ");
-    Serial.print(FTM_FRAME_COUNT);
-    Serial.print(" and Burst Period ");
-    Serial.print(FTM_BURST_PERIOD * 100);
-    Serial.println(" ms");
+    return requestId;
+}
+
+uint32_t WiFiManager::requestFtmReportConnected(FtmCallback callback) {
+    if (!isConnected()) {
+        log.error("WiFiManager", "FTM Error: Not connected to an AP");
+        return 0;
+    }
 
-    if (!WiFi.initiateFTM(FTM_FRAME_COUNT, FTM_BURST_PERIOD)) {
-        Serial.println("FTM Error: Initiate Session Failed");
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+
+    FtmRequest request;
+    memcpy(request.bssid, WiFi.BSSID(), sizeof(request.bssid));
+    request.channel = 0;
+    request.useConnectedAp = true;
+    request.frameCount = config.ftm.frameCount;
+    request.burstPeriod = config.ftm.burstPeriod;
+    request.timeout = config.ftm.requestTimeout;
+
+    return requestFtmReport(request, callback);
+}
+
+uint32_t WiFiManager::requestFtmReportBssid(uint8_t channel, const uint8_t mac[], FtmCallback callback) {
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+
+    FtmRequest request;
+    memcpy(request.bssid, mac, sizeof(request.bssid));
+    request.channel = channel;
+    request.useConnectedAp = false;
+    request.frameCount = config.ftm.frameCount;
+    request.burstPeriod = config.ftm.burstPeriod;
+    request.timeout = config.ftm.requestTimeout;
+
+    return requestFtmReport(request, callback);
+}
+
+bool WiFiManager::addFtmAnchor(const uint8_t bssid[6], uint8_t channel, uint8_t priority) {
+    if (!ftmScheduler.addAnchor(bssid, channel, priority)) {
+        log.warning("WiFiManager", "FTM anchor table full, anchor not added");
         return false;
     }
-    
-    return xSemaphoreTake(ftmSemaphore, portMAX_DELAY) == pdPASS && ftmSuccess;
+
+    const AdvertisedPosition* position = findAdvertisedPosition(bssid);
+    if (position) {
+        ftmScheduler.setAnchorPosition(bssid, position->x, position->y, position->z);
+    }
+
+    LOG_DEBUG("WiFiManager", "Added FTM anchor %02X:%02X:%02X:%02X:%02X:%02X on channel %d", bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5], channel);
+    return true;
 }
 
-//TODO single method with optional parameters
+bool WiFiManager::removeFtmAnchor(const uint8_t bssid[6]) {
+    return ftmScheduler.removeAnchor(bssid);
+}
 
-bool WiFiManager::getFtmReportBssid(uint8_t channel, byte mac[]) {
+bool WiFiManager::setFtmAnchorPosition(const uint8_t bssid[6], float x, float y, float z) {
+    return ftmScheduler.setAnchorPosition(bssid, x, y, z);
+}
 
-    Serial.print("Initiating FTM session to Other with Frame Count ");
-    Serial.print(FTM_FRAME_COUNT);
-    Serial.print(" and Burst Period ");
-    Serial.print(FTM_BURST_PERIOD * 100);
-    Serial.println(" ms");
+bool WiFiManager::calibrateFtmAnchor(const uint8_t bssid[6], uint8_t channel, float knownDistanceCm, uint16_t samples) {
+    const FtmAnchor* anchor = ftmScheduler.findAnchor(bssid);
+    if (!anchor && !addFtmAnchor(bssid, channel, UINT8_MAX)) {
+        return false;
+    }
 
-    if (!WiFi.initiateFTM(FTM_FRAME_COUNT, FTM_BURST_PERIOD, channel, mac)) {
-        Serial.println("FTM Error: Initiate Session Failed");
+    return CalibrationManager::getInstance().startCalibration(bssid, knownDistanceCm, samples);
+}
+
+void WiFiManager::getFtmReplayConfig(FtmReplayConfig& replayConfig) {
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+    replayConfig.scheduler = ftmScheduler.getConfig();
+    replayConfig.solve3d = config.position.solve3d;
+    replayConfig.tagHeight = config.position.tagHeight;
+    replayConfig.positionInterval = config.position.interval;
+    replayConfig.maxRangeAge = config.position.maxRangeAge;
+}
+
+bool WiFiManager::replayFtmRecording(const char* path, const FtmReplayConfig& replayConfig, FtmReplayStats& stats) {
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        LOG_ERROR("WiFiManager", "Failed to open FTM recording '%s'", path);
         return false;
     }
-    
-    return xSemaphoreTake(ftmSemaphore, portMAX_DELAY) == pdPASS && ftmSuccess;
+
+    FtmReplay replay([]() -> uint32_t { return micros(); });
+    replay.configure(replayConfig);
+
+    char line[FtmReplay::MAX_LINE_LENGTH];
+    while (file.available()) {
+        size_t length = file.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[length] = '\0';
+        replay.feedLine(line);
+    }
+    file.close();
+
+    stats = replay.getStats();
+
+    LOG_INFO("WiFiManager", "Replayed %" PRIu32 " reports (%" PRIu32 " errors), %" PRIu32 " fixes in %llu us",
+        stats.reports, stats.parseErrors, stats.fixes,
+        static_cast<unsigned long long>(stats.engine.totalMicros + stats.pipeline.totalMicros + stats.solver.totalMicros));
+    return true;
+}
+
+void WiFiManager::recordFtmResult(const FtmResult& result) {
+    if (result.state != FtmRequestState::COMPLETED && result.state != FtmRequestState::FAILED) {
+        return;
+    }
+
+    char line[FtmReplay::MAX_LINE_LENGTH];
+    int length;
+
+    const FtmAnchor* anchor = ftmScheduler.findAnchor(result.bssid);
+    if (anchor && result.state == FtmRequestState::COMPLETED && anchor->stats.successes == 1) {
+        length = anchor->hasPosition
+            ? snprintf(line, sizeof(line), "anchor,%02x:%02x:%02x:%02x:%02x:%02x,%d,%.3f,%.3f,%.3f\n",
+                anchor->bssid[0], anchor->bssid[1], anchor->bssid[2], anchor->bssid[3], anchor->bssid[4], anchor->bssid[5], anchor->channel,
+                anchor->x, anchor->y, anchor->z)
+            : snprintf(line, sizeof(line), "anchor,%02x:%02x:%02x:%02x:%02x:%02x,%d\n",
+                anchor->bssid[0], anchor->bssid[1], anchor->bssid[2], anchor->bssid[3], anchor->bssid[4], anchor->bssid[5], anchor->channel);
+        appendFtmRecord(line, length);
+    }
+
+    length = snprintf(line, sizeof(line), "report,%" PRIu32 ",%02x:%02x:%02x:%02x:%02x:%02x,%d,%" PRIu32 ",%" PRIu32 ",%d,%d\n",
+        result.completedAt, result.bssid[0], result.bssid[1], result.bssid[2], result.bssid[3], result.bssid[4], result.bssid[5],
+        result.status, result.rttNs, result.distanceCm, result.frames, result.rssi);
+    appendFtmRecord(line, length);
+}
+
+void WiFiManager::appendFtmRecord(const char* line, int length) {
+    if (length < 0 || length >= FtmReplay::MAX_LINE_LENGTH || recordLength + length > sizeof(recordBuffer)) {
+        recordDropped++;
+        return;
+    }
+
+    memcpy(recordBuffer + recordLength, line, length);
+    recordLength += length;
+}
+
+void WiFiManager::updateFtmRecord(uint32_t now) {
+    if (recordLength == 0) {
+        return;
+    }
+
+    bool due = recordLength >= FTM_RECORD_BUFFER_SIZE / 2 || now - recordFlushedAt >= FTM_RECORD_FLUSH_INTERVAL;
+    if ((due && !ftmEngine.isBusy()) || recordLength >= FTM_RECORD_BUFFER_SIZE * 3 / 4) {
+        flushFtmRecord();
+    }
+}
+
+void WiFiManager::flushFtmRecord() {
+    if (recordLength == 0) {
+        return;
+    }
+
+    File file = LittleFS.open(FTM_RECORD_FILE, "a");
+    if (file) {
+        file.write(reinterpret_cast<const uint8_t*>(recordBuffer), recordLength);
+        file.close();
+    } else {
+        log.error("WiFiManager", "Failed to open FTM recording");
+    }
+
+    if (recordDropped > 0) {
+        LOG_WARNING("WiFiManager", "Dropped %" PRIu32 " FTM record lines", recordDropped);
+        recordDropped = 0;
+    }
+
+    recordLength = 0;
+    recordFlushedAt = millis();
+}
+
+bool WiFiManager::pollFtmReport(uint32_t requestId, FtmResult& result) {
+    return ftmEngine.poll(requestId, result);
+}
+
+bool WiFiManager::cancelFtmReport(uint32_t requestId) {
+    return ftmEngine.cancel(requestId, millis());
 }
 
 void WiFiManager::onFtmReport(arduino_event_t *event) {
-    const char *status_str[5] = {"SUCCESS", "UNSUPPORTED", "CONF_REJECTED", "NO_RESPONSE", "FAIL"};
     wifi_event_ftm_report_t *report = &event->event_info.wifi_ftm_report;
-    WiFiManager::getInstance().ftmSuccess = report->status == FTM_STATUS_SUCCESS;
-    if (WiFiManager::getInstance().ftmSuccess) {
-        Serial.printf("FTM Estimate: Distance: %.2f m, Return Time: %lu ns\n", (float)report->dist_est / 100.0, report->rtt_est);
+
+    FtmReport ftmReport;
+    memcpy(ftmReport.peer, report->peer_mac, sizeof(ftmReport.peer));
+    ftmReport.status = report->status;
+    ftmReport.rttNs = report->rtt_est;
+    ftmReport.distanceCm = report->dist_est;
+    ftmReport.frames = 0;
+    ftmReport.rssi = 0;
+
+    if (report->status == FTM_STATUS_SUCCESS) {
+        const FtmEstimatorSettings& settings = WiFiManager::getInstance().estimatorSettings.read();
+
+        FtmEstimate estimate;
+        if (FtmEstimator::estimate(report->ftm_report_data, report->ftm_report_num_entries, settings.method, settings.param, estimate)) {
+            ftmReport.rttNs = estimate.rttPs / 1000;
+            ftmReport.distanceCm = estimate.distanceCm;
+        }
+        ftmReport.frames = estimate.validFrames;
+        ftmReport.rssi = estimate.meanRssi;
+
         free(report->ftm_report_data);
-    } else {
-        Serial.print("FTM Error: ");
-        Serial.println(status_str[report->status]);
     }
-    xSemaphoreGive(WiFiManager::getInstance().ftmSemaphore);
-}
 
-void WiFiManager::softAP(){
-    WiFi.softAP(WIFI_FTM_SSID, WIFI_FTM_PASS, 1, 0, 4, true);
+    WiFiManager::getInstance().ftmEngine.onReport(ftmReport);
 }
 
-void WiFiManager::scan(){
-    int n = WiFi.scanNetworks();
-    Serial.println("Scan done");
-    if (n == 0) {
-        Serial.println("no networks found");
+bool WiFiManager::startScan(const uint8_t* channels, uint8_t channelCount, ScanCallback callback) {
+    if (scanning) {
+        log.warning("WiFiManager", "Scan already in progress");
+        return false;
+    }
+
+    if (channelCount > MAX_SCAN_CHANNELS) {
+        channelCount = MAX_SCAN_CHANNELS;
+    }
+    if (channels && channelCount > 0) {
+        memcpy(scanChannels, channels, channelCount);
     } else {
-        Serial.print(n);
-        Serial.println(" networks found");
-        Serial.println("Nr | SSID                             | RSSI | CH | MAC               | Encryption");
-        for (int i = 0; i < n; ++i) {
-            Serial.printf("%2d", i + 1);
-            Serial.print(" | ");
-            Serial.printf("%-32.32s", WiFi.SSID(i).c_str());
-            Serial.print(" | ");
-            Serial.printf("%4ld", WiFi.RSSI(i));
-            Serial.print(" | ");
-            Serial.printf("%2ld", WiFi.channel(i));
-            Serial.print(" | ");
-            Serial.printf("%02X:%02X:%02X:%02X:%02X:%02X", WiFi.BSSID(i)[0], WiFi.BSSID(i)[1], WiFi.BSSID(i)[2], WiFi.BSSID(i)[3], WiFi.BSSID(i)[4], WiFi.BSSID(i)[5]);
-            Serial.print(" | ");
-            switch (WiFi.encryptionType(i)) {
-                case WIFI_AUTH_OPEN:            Serial.print("open"); break;
-                case WIFI_AUTH_WEP:             Serial.print("WEP"); break;
-                case WIFI_AUTH_WPA_PSK:         Serial.print("WPA"); break;
-                case WIFI_AUTH_WPA2_PSK:        Serial.print("WPA2"); break;
-                case WIFI_AUTH_WPA_WPA2_PSK:    Serial.print("WPA+WPA2"); break;
-                case WIFI_AUTH_WPA2_ENTERPRISE: Serial.print("WPA2-EAP"); break;
-                case WIFI_AUTH_WPA3_PSK:        Serial.print("WPA3"); break;
-                case WIFI_AUTH_WPA2_WPA3_PSK:   Serial.print("WPA2+WPA3"); break;
-                case WIFI_AUTH_WAPI_PSK:        Serial.print("WAPI"); break;
-                default:                        Serial.print("unknown");
-            }
-            Serial.println();
-            delay(10);
+        channelCount = 0;
+    }
+
+    scanChannelCount = channelCount;
+    scanChannelIndex = 0;
+    scanCallback = callback;
+    scanStartedAt = millis();
+
+    if (!startChannelScan()) {
+        log.error("WiFiManager", "Failed to start scan");
+        return false;
+    }
+
+    scanning = true;
+    return true;
+}
+
+bool WiFiManager::startAnchorScan(ScanCallback callback) {
+    uint8_t channels[MAX_SCAN_CHANNELS];
+    uint8_t channelCount = 0;
+
+    for (uint8_t i = 0; i < ftmScheduler.getAnchorCount(); i++) {
+        uint8_t channel = ftmScheduler.getAnchor(i)->channel;
+        if (channel == 0 || memchr(channels, channel, channelCount)) {
+            continue;
+        }
+        if (channelCount < MAX_SCAN_CHANNELS) {
+            channels[channelCount++] = channel;
         }
     }
-    Serial.println("");
+
+    return startScan(channels, channelCount, callback);
+}
+
+bool WiFiManager::startChannelScan() {
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+    uint8_t channel = scanChannelCount > 0 ? scanChannels[scanChannelIndex] : 0;
+
+    return WiFi.scanNetworks(true, false, false, config.scan.maxMsPerChannel, channel) != WIFI_SCAN_FAILED;
+}
+
+void WiFiManager::updateScan() {
+    int16_t count = WiFi.scanComplete();
+    if (count == WIFI_SCAN_RUNNING) {
+        return;
+    }
+
+    if (count > 0) {
+        collectScanResults(count);
+    }
     WiFi.scanDelete();
+
+    scanChannelIndex++;
+    if (scanChannelIndex < scanChannelCount && startChannelScan()) {
+        return;
+    }
+
+    finishScan();
+}
+
+void WiFiManager::collectScanResults(int16_t count) {
+    uint32_t now = millis();
+
+    for (int16_t i = 0; i < count; i++) {
+        wifi_ap_record_t* record = static_cast<wifi_ap_record_t*>(WiFi.getScanInfoByIndex(i));
+        if (!record) {
+            continue;
+        }
+
+        ScanResult result;
+        memcpy(result.bssid, record->bssid, sizeof(result.bssid));
+        result.channel = record->primary;
+        result.rssi = record->rssi;
+        result.ftmResponder = record->ftm_responder;
+        result.seenAt = now;
+        scanCache.upsert(result);
+    }
+}
+
+void WiFiManager::finishScan() {
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+    uint32_t now = millis();
+
+    scanning = false;
+    scanCache.prune(now, config.scan.cacheTtl);
+
+    uint8_t responders = 0;
+    for (uint8_t i = 0; i < scanCache.getCount(); i++) {
+        const ScanResult* result = scanCache.get(i);
+        if (!result->ftmResponder || now - result->seenAt > config.scan.cacheTtl) {
+            continue;
+        }
+
+        responders++;
+        const FtmAnchor* anchor = ftmScheduler.findAnchor(result->bssid);
+        if (anchor) {
+            ftmScheduler.addAnchor(result->bssid, result->channel, anchor->priority);
+        } else if (config.scan.autoAddAnchors) {
+            addFtmAnchor(result->bssid, result->channel);
+        }
+    }
+
+    LOG_DEBUG("WiFiManager", "Scan finished in %" PRIu32 " ms: %d cached results, %d FTM responders", now - scanStartedAt, scanCache.getCount(), responders);
+
+    if (scanCallback) {
+        ScanCallback callback = scanCallback;
+        scanCallback = nullptr;
+        callback(scanCache);
+    }
+}
+
+void WiFiManager::onVendorIe(void* context, wifi_vendor_ie_type_t type, const uint8_t sa[6], const vendor_ie_data_t* vendorIe, int rssi) {
+    if (type != WIFI_VND_IE_TYPE_BEACON && type != WIFI_VND_IE_TYPE_PROBE_RESP) {
+        return;
+    }
+
+    AdvertisedPosition position;
+    const uint8_t* element = reinterpret_cast<const uint8_t*>(vendorIe);
+    if (!AnchorAdvertisement::decode(element, vendorIe->length + 2, position.x, position.y, position.z)) {
+        return;
+    }
+    memcpy(position.bssid, sa, sizeof(position.bssid));
+
+    WiFiManager& instance = WiFiManager::getInstance();
+    uint8_t head = instance.advertisementHead.load(std::memory_order_relaxed);
+    uint8_t next = (head + 1) % ADVERTISEMENT_QUEUE_SIZE;
+    if (next == instance.advertisementTail.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    instance.advertisementQueue[head] = position;
+    instance.advertisementHead.store(next, std::memory_order_release);
+}
+
+void WiFiManager::processAdvertisements() {
+    uint8_t tail = advertisementTail.load(std::memory_order_relaxed);
+
+    while (tail != advertisementHead.load(std::memory_order_acquire)) {
+        const AdvertisedPosition& position = advertisementQueue[tail];
+
+        AdvertisedPosition* known = const_cast<AdvertisedPosition*>(findAdvertisedPosition(position.bssid));
+        if (!known && advertisedPositionCount < FtmScheduler::MAX_ANCHORS) {
+            known = &advertisedPositions[advertisedPositionCount++];
+        }
+        if (known) {
+            *known = position;
+        }
+
+        ftmScheduler.setAnchorPosition(position.bssid, position.x, position.y, position.z);
+
+        tail = (tail + 1) % ADVERTISEMENT_QUEUE_SIZE;
+        advertisementTail.store(tail, std::memory_order_release);
+    }
+}
+
+const AdvertisedPosition* WiFiManager::findAdvertisedPosition(const uint8_t bssid[6]) {
+    for (uint8_t i = 0; i < advertisedPositionCount; i++) {
+        if (memcmp(advertisedPositions[i].bssid, bssid, sizeof(advertisedPositions[i].bssid)) == 0) {
+            return &advertisedPositions[i];
+        }
+    }
+    return nullptr;
 }
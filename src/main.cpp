@@ -3,7 +3,11 @@
 #include <ConfigManager.h>
 #include <Device.h>
 #include <Logger.h>
+#if DEVICE_TYPE == DEVICE_TYPE_ANCHOR
+#include <states/AnchorState.h>
+#else
 #include <states/IdleState.h>
+#endif
 
 void setup() {
   Serial.begin(MONITOR_SPEED);
@@ -20,6 +24,9 @@ void setup() {
   Logger& log = Logger::getInstance();
   Device& device = Device::getInstance();
 
+  log.begin();
+  CrashLog::getInstance().begin();
+
   if(!configManager.begin()) {
     log.error("main", "Failed to initialize ConfigManager");
     while(true);
@@ -34,7 +41,11 @@ void setup() {
   configManager.print(&configManager.getRuntimeConfig());
   Serial.println(F("###################################################"));
 
+#if DEVICE_TYPE == DEVICE_TYPE_ANCHOR
+  device.changeState(AnchorState::getInstance(&device));
+#else
   device.changeState(IdleState::getInstance(&device));
+#endif
 }
 
 void loop() {
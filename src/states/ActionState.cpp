@@ -1,15 +1,117 @@
 #include "states/ActionState.h"
 #include "WiFi.h"
 #include "Logger.h"
+#include "WiFiManager.h"
 
 void ActionState::enter() {
     log.debug("ActionState", "Entering ActionState");
+
+    lastScan = millis();
+    positionTopic = MQTTManager::getInstance().registerTopic("position");
+    WiFiManager::getInstance().startScan();
 }
 
 void ActionState::update() {
+    WiFiManager::getInstance().update();
     MQTTManager::getInstance().update();
+
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+    uint32_t now = millis();
+    if (now - lastPositionUpdate >= config.position.interval) {
+        lastPositionUpdate = now;
+        updatePosition();
+    }
+
+    WiFiManager& wifiManager = WiFiManager::getInstance();
+    if (now - lastScan >= config.scan.interval && !wifiManager.isScanning()) {
+        lastScan = now;
+        wifiManager.startAnchorScan();
+    }
+
+    if (now - lastMetricsUpdate >= config.ftm.metricsInterval) {
+        lastMetricsUpdate = now;
+        publishFtmMetrics();
+    }
 }
 
 void ActionState::exit() {
     log.debug("ActionState", "Exiting ActionState");
-}
\ No newline at end of file
+}
+
+void ActionState::updatePosition() {
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+    FtmScheduler& scheduler = WiFiManager::getInstance().getFtmScheduler();
+
+    multilateration.clear();
+    multilateration.setHeight(config.position.tagHeight);
+    scheduler.collectRanges(multilateration, millis(), config.position.maxRangeAge);
+
+    uint8_t required = config.position.solve3d ? 4 : 3;
+    if (multilateration.getRangeCount() < required) {
+        return;
+    }
+
+    PositionFix fix;
+    if (!multilateration.solve(fix, config.position.solve3d)) {
+        log.debug("ActionState", "Position solver did not converge");
+        return;
+    }
+
+    publishPosition(fix);
+}
+
+void ActionState::publishPosition(const PositionFix& fix) {
+    StaticJsonDocument<256> doc;
+
+    doc["x"] = fix.x;
+    doc["y"] = fix.y;
+    doc["z"] = fix.z;
+    doc["residual"] = fix.residual;
+    doc["anchors"] = fix.anchorCount;
+    doc["iterations"] = fix.iterations;
+
+    JsonObject covariance = doc.createNestedObject("cov");
+    covariance["xx"] = fix.covariance[0][0];
+    covariance["xy"] = fix.covariance[0][1];
+    covariance["yy"] = fix.covariance[1][1];
+    covariance["zz"] = fix.covariance[2][2];
+
+    char payload[256];
+    size_t length = serializeJson(doc, payload, sizeof(payload));
+
+    if (positionTopic != MQTTManager::INVALID_TOPIC) {
+        MQTTManager::getInstance().publish(positionTopic, payload, length, false, MQTTPriority::NORMAL, 1);
+    }
+}
+
+void ActionState::publishFtmMetrics() {
+    MQTTManager& mqttManager = MQTTManager::getInstance();
+    FtmScheduler& scheduler = WiFiManager::getInstance().getFtmScheduler();
+
+    for (uint8_t i = 0; i < scheduler.getAnchorCount(); i++) {
+        const FtmAnchor* anchor = scheduler.getAnchor(i);
+        const FtmBurstMetrics& burst = anchor->burst.getMetrics();
+        StaticJsonDocument<256> doc;
+
+        doc["ch"] = anchor->channel;
+        doc["ok"] = anchor->stats.successes;
+        doc["fail"] = anchor->stats.failures;
+        doc["ratio"] = anchor->getSuccessRatio();
+        doc["rtt"] = anchor->stats.lastRttNs;
+        doc["dist"] = anchor->stats.filteredDistanceCm;
+        doc["sps"] = anchor->stats.sessionsPerSecond;
+        doc["frames"] = burst.frameCount;
+        doc["period"] = burst.burstPeriod;
+        doc["dev"] = burst.deviationCm;
+        doc["failRate"] = burst.failureRate;
+        doc["up"] = burst.rampUps;
+        doc["down"] = burst.rampDowns;
+
+        char payload[256];
+        serializeJson(doc, payload, sizeof(payload));
+
+        char subtopic[32];
+        snprintf(subtopic, sizeof(subtopic), "ftm/%02x%02x%02x%02x%02x%02x", anchor->bssid[0], anchor->bssid[1], anchor->bssid[2], anchor->bssid[3], anchor->bssid[4], anchor->bssid[5]);
+        mqttManager.publish(subtopic, payload, false, false, MQTTPriority::BACKGROUND);
+    }
+}
@@ -0,0 +1,55 @@
+#include "states/AnchorState.h"
+
+void AnchorState::enter() {
+    log.debug("AnchorState", "Entering AnchorState");
+
+    responderActive = startResponder();
+    if (!responderActive) {
+        log.error("AnchorState", "Failed to start FTM responder");
+        return;
+    }
+
+    if (!advertisePosition()) {
+        log.warning("AnchorState", "Failed to advertise anchor position");
+    }
+}
+
+void AnchorState::update() {
+
+}
+
+void AnchorState::exit() {
+    log.debug("AnchorState", "Exiting AnchorState");
+}
+
+bool AnchorState::startResponder() {
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+
+    WiFi.mode(WIFI_AP);
+    if (!WiFi.softAP(config.anchor.ssid, config.anchor.password, config.anchor.channel, 0, config.anchor.maxClients, true)) {
+        return false;
+    }
+
+    LOG_INFO("AnchorState", "FTM responder '%s' started on channel %d (max. %d clients)", config.anchor.ssid, config.anchor.channel, config.anchor.maxClients);
+
+    return true;
+}
+
+bool AnchorState::advertisePosition() {
+    RuntimeConfig& config = configManager.getRuntimeConfig();
+
+    if (AnchorAdvertisement::encode(config.anchor.x, config.anchor.y, config.anchor.z, advertisement, sizeof(advertisement)) == 0) {
+        return false;
+    }
+
+    if (esp_wifi_set_vendor_ie(true, WIFI_VND_IE_TYPE_BEACON, WIFI_VND_IE_ID_0, advertisement) != ESP_OK) {
+        return false;
+    }
+    if (esp_wifi_set_vendor_ie(true, WIFI_VND_IE_TYPE_PROBE_RESP, WIFI_VND_IE_ID_0, advertisement) != ESP_OK) {
+        return false;
+    }
+
+    LOG_INFO("AnchorState", "Advertising anchor position (%.2f, %.2f, %.2f)", config.anchor.x, config.anchor.y, config.anchor.z);
+
+    return true;
+}
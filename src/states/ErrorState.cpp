@@ -20,14 +20,13 @@ void ErrorState::setError(ErrorCode errorCode, DeviceState* sourceState, const c
 
 
 void ErrorState::reportError() {
-    char msgBuffer[256];
-    snprintf(msgBuffer, sizeof(msgBuffer), "Error occurred: %s", errorMessage);
-    log.error("ErrorState", msgBuffer);
-
-    if (mqttManager.isConnected()) {
-        RuntimeConfig& config = configManager.getRuntimeConfig();
-        String topic = config.mqtt.baseTopic + String(config.device.chipID) + "/error";
-        mqttManager.publish(topic.c_str(), errorMessage, true);  // retain flag = true
+    LOG_ERROR("ErrorState", "Error occurred: %s", errorMessage);
+
+    if (errorTopic == MQTTManager::INVALID_TOPIC && mqttManager.isInitialized()) {
+        errorTopic = mqttManager.registerTopic("error");
+    }
+    if (errorTopic != MQTTManager::INVALID_TOPIC) {
+        mqttManager.publish(errorTopic, errorMessage, strlen(errorMessage), true, MQTTPriority::CRITICAL, 1);  // retain flag = true
     }
 }
 
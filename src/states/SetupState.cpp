@@ -87,17 +87,12 @@ void SetupState::handleMqttConnection() {
     mqttManager.update();
 
     if (!mqttManager.isConnected()) {
-        if (!mqttManager.connect()) {
-            RuntimeConfig& config = configManager.getRuntimeConfig();
-            mqttConnectionAttempts++;
+        RuntimeConfig& config = configManager.getRuntimeConfig();
 
-            if (mqttConnectionAttempts >= config.mqtt.maxConnectionAttempts) {
-                handleConnectionError("MQTT connection failed", ErrorCode::MQTT_CONNECTION_FAILED);
-                return;
-            }
-            delay(500); 
-            return;
+        if (mqttManager.getConnectionAttempts() >= config.mqtt.maxConnectionAttempts) {
+            handleConnectionError("MQTT connection failed", ErrorCode::MQTT_CONNECTION_FAILED);
         }
+        return;
     }
 
     subscribeDefaultTopics();
@@ -105,35 +100,47 @@ void SetupState::handleMqttConnection() {
 }
 
 void SetupState::subscribeDefaultTopics() {
-    RuntimeConfig& config = configManager.getRuntimeConfig();
-    String deviceTopic = String(mqttManager.getDeviceTopic()) + "/#";
-    
-    mqttManager.subscribe(deviceTopic.c_str(), [this](const char* topic, const uint8_t* payload, unsigned int length) {
-        handleDeviceMessage(topic, payload, length);
-    });
-
+    // Only topics the device never publishes to, so its own telemetry does
+    // not come back through the inbound ring.
     String configTopic = String(mqttManager.getDeviceTopic())  + "/config";
     mqttManager.subscribe(configTopic.c_str(), [this](const char* topic, const uint8_t* payload, unsigned int length) {
         handleConfigMessage(topic, payload, length);
     });
-}
 
-void SetupState::handleDeviceMessage(const char* topic, const uint8_t* payload, unsigned int length) {
-    char message[length + 1];
-    memcpy(message, payload, length);
-    message[length] = '\0';
-    
-    char logMessage[1024];
-    snprintf(logMessage, sizeof(logMessage), "Received message on topic %s: %s", topic, message);
-    log.debug("SetupState", logMessage);
+    if (!RPCManager::getInstance().begin()) {
+        log.warning("SetupState", "Failed to initialize RPCManager");
+    }
+
+    if (!MQTTLogSink::getInstance().begin()) {
+        log.warning("SetupState", "Failed to initialize MQTTLogSink");
+    }
 }
 
 void SetupState::handleConfigMessage(const char* topic, const uint8_t* payload, unsigned int length) {
-    char message[length + 1];
-    memcpy(message, payload, length);
-    message[length] = '\0';
-    
-    log.info("SetupState", "Received config update");
+    char error[96];
+    bool staged = configManager.stagePatch(payload, length, error, sizeof(error));
+
+    StaticJsonDocument<192> doc;
+    doc["ok"] = staged;
+    if (!staged) {
+        doc["error"] = error;
+    }
+
+    char response[192];
+    size_t responseLength = serializeJson(doc, response, sizeof(response));
+
+    if (configAckTopic == MQTTManager::INVALID_TOPIC) {
+        configAckTopic = mqttManager.registerTopic("config/ack");
+    }
+    if (configAckTopic != MQTTManager::INVALID_TOPIC) {
+        mqttManager.publish(configAckTopic, response, responseLength, false, MQTTPriority::NORMAL, 1);
+    }
+
+    if (staged) {
+        log.info("SetupState", "Staged config update");
+    } else {
+        LOG_WARNING("SetupState", "Rejected config update: %s", error);
+    }
 }
 
 void SetupState::handleConnectionError(const char* message, ErrorCode errorCode) {
@@ -3,6 +3,7 @@
 void UpdateState::enter() {
     log.debug("UpdateState", "Entering Update State");
     currentPhase = UpdatePhase::CHECK_VERSION;
+    updateTopic = mqttManager.registerTopic("update");
 }
 
 void UpdateState::update(){
@@ -32,6 +33,7 @@ void UpdateState::update(){
         case UpdatePhase::COMPLETED:
             if(Update.isFinished()) {
                 reportProgress("Update completed, restarting device...", 100);
+                log.flush();
                 delay(1000);
                 ESP.restart();
             }
@@ -225,28 +227,25 @@ bool UpdateState::compareVersion(const char* versionA, const char* versionB) {
 }
 
 void UpdateState::reportProgress(const char* status, int progress){
-    if(mqttManager.isConnected()) {
-        StaticJsonDocument<256> doc;
-        doc["status"] = status;
+    StaticJsonDocument<256> doc;
+    doc["status"] = status;
 
-        if(progress >= 0) {
-            doc["progress"] = progress;
-        }
-        if(newVersion.length() > 0) {
-            doc["version"] = newVersion;
-        }
+    if(progress >= 0) {
+        doc["progress"] = progress;
+    }
+    if(newVersion.length() > 0) {
+        doc["version"] = newVersion;
+    }
 
-        String topic = String(mqttManager.getDeviceTopic())  + "/update";
-        String payload;
-        serializeJson(doc, payload);
+    char payload[256];
+    size_t length = serializeJson(doc, payload, sizeof(payload));
 
-        mqttManager.publish(topic.c_str(), payload.c_str());
+    if (updateTopic != MQTTManager::INVALID_TOPIC) {
+        mqttManager.publish(updateTopic, payload, length);
     }
 
     if(progress >= 0) {
-        char msgBuffer[128];
-        snprintf(msgBuffer, sizeof(msgBuffer), "%s (%d%%)", status, progress);
-        log.info("UpdateState", msgBuffer);
+        LOG_INFO("UpdateState", "%s (%d%%)", status, progress);
     } else {
         log.info("UpdateState", status);
     }
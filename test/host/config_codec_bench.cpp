@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "ConfigCodec.h"
+
+// Round-trips a populated RuntimeConfig through the tagged format, checks
+// corruption and legacy migration, and reports size and encode/decode cost.
+
+static const uint32_t ITERATIONS = 20000;
+
+struct Buffer {
+    std::vector<uint8_t> data;
+    size_t position = 0;
+
+    ConfigWriter writer() {
+        return [this](const uint8_t* bytes, size_t length) {
+            data.insert(data.end(), bytes, bytes + length);
+            return length;
+        };
+    }
+
+    ConfigReader reader() {
+        return [this](uint8_t* bytes, size_t length) {
+            size_t available = data.size() - position;
+            size_t count = length < available ? length : available;
+            memcpy(bytes, data.data() + position, count);
+            position += count;
+            return count;
+        };
+    }
+};
+
+static double getNanos(std::chrono::steady_clock::time_point start, uint32_t iterations) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static RuntimeConfig getSampleConfig() {
+    RuntimeConfig config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.device.name, "station-01");
+    strcpy(config.device.firmwareVersion, "1.4.0");
+    config.device.chipID = 0x0000A1B2C3D4E5F6ULL;
+    strcpy(config.device.macAddress, "F6:E5:D4:C3:B2:A1");
+    config.device.statusUpdateInterval = 60000;
+    strcpy(config.wifi.ssid, "gps-no");
+    strcpy(config.wifi.password, "correct horse battery staple");
+    config.wifi.autoReconnect = true;
+    config.wifi.maxConnectionAttempts = 20;
+    config.wifi.reconnectInterval = 5000;
+    config.wifi.checkInterval = 500;
+    strcpy(config.mqtt.broker, "broker.local");
+    config.mqtt.port = 1883;
+    strcpy(config.mqtt.baseTopic, "gpsno/devices");
+    config.mqtt.drainBudget = 4;
+    config.ftm.frameCount = 16;
+    config.ftm.requestTimeout = 3000;
+    config.ftm.filterProcessNoise = 100.0f;
+    config.ftm.filterMeasurementNoise = 400.0f;
+    config.position.tagHeight = 1.0f;
+    config.logging.allowMqttLog = true;
+    config.logging.logLevel = 1;
+    strcpy(config.update.apiUrl, "https://api.github.com/repos/Legincy/gps-no-fw/releases/latest");
+    config.update.interval = 10000;
+    strcpy(config.hash, "0123456789abcdef0123456789abcdef");
+    return config;
+}
+
+static bool checkRoundTrip(const RuntimeConfig& config, const Buffer& encoded) {
+    Buffer input = encoded;
+    RuntimeConfig decoded;
+    memset(&decoded, 0, sizeof(decoded));
+    ConfigDecodeInfo info;
+    if (!ConfigCodec::decode(input.reader(), decoded, info)) {
+        fprintf(stderr, "FAIL: round trip did not decode\n");
+        return false;
+    }
+    if (info.missing != 0 || info.skipped != 0 || memcmp(&decoded, &config, sizeof(config)) != 0) {
+        fprintf(stderr, "FAIL: round trip changed the config (%u missing, %u skipped)\n", info.missing, info.skipped);
+        return false;
+    }
+    return true;
+}
+
+static bool checkCorruption(const Buffer& encoded) {
+    for (size_t i = 0; i < encoded.data.size(); i++) {
+        Buffer input = encoded;
+        input.data[i] ^= 0x10;
+        RuntimeConfig decoded = {};
+        ConfigDecodeInfo info;
+        if (ConfigCodec::decode(input.reader(), decoded, info)) {
+            fprintf(stderr, "FAIL: flipped bit at byte %zu was accepted\n", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool checkLegacy(const RuntimeConfig& defaults) {
+    LegacyRuntimeConfigV0 legacy;
+    memset(&legacy, 0, sizeof(legacy));
+    strcpy(legacy.device.name, "legacy");
+    legacy.device.statusUpdateInterval = 30000;
+    strcpy(legacy.wifi.ssid, "old-ssid");
+    legacy.wifi.reconnectInterval = 7000;
+    strcpy(legacy.mqtt.broker, "old-broker");
+    legacy.mqtt.port = 8883;
+    legacy.error.recoveryInterval = 9000;
+    strcpy(legacy.logging.mqttTopic, "old/log");
+    strcpy(legacy.update.apiToken, "token");
+    strcpy(legacy.hash, "fedcba9876543210fedcba9876543210");
+
+    Buffer input;
+    input.data.assign(reinterpret_cast<uint8_t*>(&legacy), reinterpret_cast<uint8_t*>(&legacy) + sizeof(legacy));
+
+    RuntimeConfig config = defaults;
+    ConfigDecodeInfo info;
+    if (ConfigCodec::decode(input.reader(), config, info) || info.version != 0) {
+        fprintf(stderr, "FAIL: legacy dump was taken for a tagged file\n");
+        return false;
+    }
+
+    input.position = 0;
+    if (!ConfigCodec::decodeLegacy(input.reader(), input.data.size(), config)) {
+        fprintf(stderr, "FAIL: legacy dump of %zu bytes was rejected\n", input.data.size());
+        return false;
+    }
+    if (ConfigCodec::decodeLegacy(input.reader(), sizeof(RuntimeConfig), config)) {
+        fprintf(stderr, "FAIL: dump of the current struct size was taken for a legacy file\n");
+        return false;
+    }
+
+    bool migrated = strcmp(config.device.name, "legacy") == 0
+        && config.device.statusUpdateInterval == 30000
+        && strcmp(config.wifi.ssid, "old-ssid") == 0
+        && config.wifi.reconnectInterval == 7000
+        && strcmp(config.mqtt.broker, "old-broker") == 0
+        && config.mqtt.port == 8883
+        && config.error.recoveryInterval == 9000
+        && strcmp(config.logging.mqttTopic, "old/log") == 0
+        && strcmp(config.update.apiToken, "token") == 0
+        && strcmp(config.hash, legacy.hash) == 0
+        && config.mqtt.drainBudget == defaults.mqtt.drainBudget
+        && config.ftm.requestTimeout == defaults.ftm.requestTimeout
+        && config.position.tagHeight == defaults.position.tagHeight;
+    if (!migrated) {
+        fprintf(stderr, "FAIL: legacy fields were not carried over onto the defaults\n");
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    RuntimeConfig config = getSampleConfig();
+
+    Buffer encoded;
+    if (!ConfigCodec::encode(config, encoded.writer())) {
+        fprintf(stderr, "FAIL: encode\n");
+        return 1;
+    }
+
+    if (!checkRoundTrip(config, encoded) || !checkCorruption(encoded) || !checkLegacy(config)) {
+        return 1;
+    }
+
+    Buffer output;
+    output.data.reserve(encoded.data.size());
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        output.data.clear();
+        ConfigCodec::encode(config, output.writer());
+    }
+    double encodeNanos = getNanos(start, ITERATIONS);
+
+    RuntimeConfig decoded;
+    ConfigDecodeInfo info;
+    Buffer input = encoded;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        input.position = 0;
+        ConfigCodec::decode(input.reader(), decoded, info);
+    }
+    double decodeNanos = getNanos(start, ITERATIONS);
+
+    printf("tagged file %zu bytes, struct %zu bytes, legacy dump %zu bytes\n", encoded.data.size(), sizeof(RuntimeConfig), sizeof(LegacyRuntimeConfigV0));
+    printf("encode %.0f ns, decode %.0f ns\n", encodeNanos, decodeNanos);
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <string.h>
+#include "ConfigDefines.h"
+#include "FtmScheduler.h"
+
+// Cancelling the scheduler's in-flight request must hand it back to the
+// scheduler, which would otherwise wait for it forever. A cancelled or timed
+// out session may still report late; that report must not complete the
+// request started after it.
+
+static int failures = 0;
+
+static void check(bool condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "FAIL: %s\n", message);
+        failures++;
+    }
+}
+
+static void report(FtmRangingEngine& engine, uint32_t distanceCm) {
+    FtmReport ftmReport;
+    memset(&ftmReport, 0, sizeof(ftmReport));
+    ftmReport.status = FtmRangingEngine::FTM_STATUS_OK;
+    ftmReport.distanceCm = distanceCm;
+    engine.onReport(ftmReport);
+}
+
+static void checkLateReports() {
+    uint32_t starts = 0;
+    uint32_t terminations = 0;
+
+    FtmRangingEngine engine;
+    engine.setInitiator([&starts](const FtmRequest&) {
+        starts++;
+        return true;
+    });
+    engine.setTerminator([&terminations]() {
+        terminations++;
+    });
+
+    FtmRequest request;
+    memset(&request, 0, sizeof(request));
+    request.useConnectedAp = true;
+    request.timeout = 1000;
+    FtmResult result;
+
+    // Cancelled, then the cancelled session reports.
+    uint32_t cancelled = engine.submit(request, 0);
+    engine.update(0);
+    engine.cancel(cancelled, 10);
+    check(terminations == 1, "cancel did not end the driver session");
+
+    uint32_t next = engine.submit(request, 20);
+    engine.update(20);
+    check(starts == 1, "next request started while the cancelled session was live");
+
+    report(engine, 999);
+    engine.update(30);
+    check(engine.getStats().staleReports == 1, "late report after cancel was not discarded");
+    check(starts == 2, "next request did not start after the late report");
+    check(!engine.poll(next, result), "late report after cancel completed the next request");
+
+    report(engine, 150);
+    engine.update(40);
+    check(engine.poll(next, result) && result.distanceCm == 150, "next request lost its own report");
+
+    // Timed out, then the timed out session reports.
+    engine.submit(request, 100);
+    engine.update(100);
+    engine.update(1100);
+    check(terminations == 2, "timeout did not end the driver session");
+
+    next = engine.submit(request, 1100);
+    engine.update(1100);
+    check(starts == 3, "next request started while the timed out session was live");
+
+    report(engine, 777);
+    engine.update(1150);
+    check(engine.getStats().staleReports == 2, "late report after timeout was not discarded");
+    check(!engine.poll(next, result), "late report after timeout completed the next request");
+
+    report(engine, 200);
+    engine.update(1160);
+    check(engine.poll(next, result) && result.distanceCm == 200, "next request lost its own report after timeout");
+
+    // Cancelled, and the session never reports.
+    cancelled = engine.submit(request, 2000);
+    engine.update(2000);
+    engine.cancel(cancelled, 2000);
+    engine.submit(request, 2000);
+    engine.update(2000 + FtmRangingEngine::SESSION_GRACE_PERIOD - 1);
+    check(starts == 5, "next request started inside the grace period");
+    engine.update(2000 + FtmRangingEngine::SESSION_GRACE_PERIOD);
+    check(starts == 6, "next request did not start after the grace period");
+}
+
+int main() {
+    FtmRangingEngine engine;
+    engine.setInitiator([](const FtmRequest&) {
+        return true;
+    });
+
+    FtmSchedulerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.requestTimeout = FTM_REQUEST_TIMEOUT;
+    config.minInterval = FTM_MIN_INTERVAL;
+    config.maxInterval = FTM_MAX_INTERVAL;
+    config.stableThreshold = FTM_STABLE_THRESHOLD;
+    config.burst.frameCount = FTM_FRAME_COUNT;
+    config.burst.burstPeriod = FTM_BURST_PERIOD;
+
+    FtmScheduler scheduler(engine);
+    scheduler.configure(config);
+
+    const uint8_t bssid[6] = {0x24, 0x0a, 0xc4, 0x00, 0x10, 0x01};
+    scheduler.addAnchor(bssid, 6);
+
+    scheduler.update(0);
+    engine.update(0);
+    check(engine.getStats().submitted == 1 && engine.isBusy(), "scheduler did not start a session");
+
+    check(engine.cancel(1, 10), "in-flight request could not be cancelled");
+    check(!engine.isBusy(), "engine still busy after cancel");
+    check(engine.getStats().cancelled == 1, "cancel was not counted");
+
+    scheduler.update(20);
+    check(engine.getStats().submitted == 2, "scheduler wedged on the cancelled request");
+    check(scheduler.getAnchor(0)->stats.failures == 0, "cancel was counted as an anchor failure");
+
+    FtmRequest request;
+    memset(&request, 0, sizeof(request));
+    request.timeout = FTM_REQUEST_TIMEOUT;
+    uint32_t polled = engine.submit(request, 30);
+    check(engine.cancel(polled, 40), "polled request could not be cancelled");
+    FtmResult result;
+    check(!engine.poll(polled, result) && result.state == FtmRequestState::FREE, "cancelled polled request kept its slot");
+
+    checkLateReports();
+
+    if (failures == 0) {
+        printf("cancel handling ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
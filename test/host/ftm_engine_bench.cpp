@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "FtmRangingEngine.h"
+
+// Drives FtmRangingEngine with a fake driver on a simulated millisecond
+// clock. The driver answers each started session after a fixed airtime,
+// fails some and never answers others, so the run covers completion,
+// failure and timeout. Checks that every request resolves and that only
+// unanswered sessions time out even when requests queue for longer than
+// their timeout, then reports simulated latency/throughput and the host
+// cost of the engine calls.
+
+static const uint32_t REQUESTS = 200000;
+static const uint32_t AIRTIME = 30;
+static const uint32_t TIMEOUT = 100;
+static const uint32_t FAIL_EVERY = 17;
+static const uint32_t LOSE_EVERY = 23;
+
+struct FakeDriver {
+    bool active = false;
+    uint32_t sessions = 0;
+    uint32_t startedAt = 0;
+    bool lost = false;
+    FtmReport report;
+
+    bool start(const FtmRequest& request, uint32_t now) {
+        sessions++;
+        active = true;
+        startedAt = now;
+        lost = sessions % LOSE_EVERY == 0;
+
+        memset(&report, 0, sizeof(report));
+        memcpy(report.peer, request.bssid, sizeof(report.peer));
+        report.status = sessions % FAIL_EVERY == 0 ? 1 : FtmRangingEngine::FTM_STATUS_OK;
+        report.rttNs = 33;
+        report.distanceCm = 500;
+        report.frames = request.frameCount;
+        report.rssi = -55;
+        return true;
+    }
+
+    // Returns the report once the simulated session is over.
+    bool poll(uint32_t now, FtmReport& out) {
+        if (!active || now - startedAt < AIRTIME) {
+            return false;
+        }
+        active = false;
+        if (lost) {
+            return false;
+        }
+        out = report;
+        return true;
+    }
+};
+
+int main() {
+    FtmRangingEngine engine;
+    FakeDriver driver;
+    uint32_t now = 0;
+
+    engine.setInitiator([&driver, &now](const FtmRequest& request) {
+        return driver.start(request, now);
+    });
+
+    FtmRequest request;
+    memset(&request, 0, sizeof(request));
+    request.frameCount = 16;
+    request.timeout = TIMEOUT;
+
+    uint32_t submitted = 0;
+    uint32_t resolved = 0;
+    uint32_t completed = 0;
+    uint32_t failed = 0;
+    uint32_t timedOut = 0;
+    uint64_t queuedMillis = 0;
+    FtmCallback callback = [&](const FtmResult& result) {
+        resolved++;
+        queuedMillis += result.startedAt - result.submittedAt;
+        switch (result.state) {
+            case FtmRequestState::COMPLETED: completed++; break;
+            case FtmRequestState::TIMED_OUT: timedOut++; break;
+            default: failed++; break;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t calls = 0;
+
+    while (resolved < REQUESTS) {
+        // Keep the queue full so requests wait several timeouts before starting.
+        while (submitted < REQUESTS && engine.getQueuedCount() + (engine.isBusy() ? 1 : 0) < FtmRangingEngine::MAX_REQUESTS) {
+            request.bssid[5] = submitted & 0xFF;
+            if (engine.submit(request, now, callback) == 0) {
+                break;
+            }
+            submitted++;
+            calls++;
+        }
+
+        FtmReport report;
+        if (driver.poll(now, report)) {
+            engine.onReport(report);
+            calls++;
+        }
+        engine.update(now);
+        calls++;
+        now++;
+    }
+
+    double hostNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    const FtmEngineStats& stats = engine.getStats();
+
+    uint32_t expectedLost = driver.sessions / LOSE_EVERY;
+    bool passed = true;
+    if (resolved != submitted || stats.completed + stats.failed + stats.timedOut != submitted) {
+        fprintf(stderr, "FAIL: %u submitted, %u resolved\n", submitted, resolved);
+        passed = false;
+    }
+    if (timedOut != expectedLost) {
+        fprintf(stderr, "FAIL: %u timeouts, expected %u lost sessions\n", timedOut, expectedLost);
+        passed = false;
+    }
+    if (stats.droppedReports != 0) {
+        fprintf(stderr, "FAIL: %u reports dropped\n", stats.droppedReports);
+        passed = false;
+    }
+
+    printf("%u requests: %u completed, %u failed, %u timed out over %u simulated ms\n", submitted, completed, failed, timedOut, now);
+    printf("throughput %.1f sessions/s at %u ms airtime, mean queue wait %.0f ms, mean latency %.1f ms, max %u ms\n",
+        submitted * 1000.0 / now, AIRTIME, static_cast<double>(queuedMillis) / resolved,
+        stats.completed > 0 ? static_cast<double>(stats.totalLatency) / stats.completed : 0.0, stats.maxLatency);
+    printf("host cost %.1f ns per engine call (%llu calls)\n", hostNanos / calls, static_cast<unsigned long long>(calls));
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "ConfigDefines.h"
+#include "FtmReplay.h"
+
+// Replays a recorded CSV session with the firmware's default FTM settings
+// and fails if the fix count or position error regress past the limits.
+//
+//   ftm_replay <recording.csv> [--min-fixes n] [--max-mean-error m] [--max-error m]
+
+static uint32_t hostMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static FtmReplayConfig getDefaultConfig() {
+    FtmReplayConfig replayConfig;
+    replayConfig.solve3d = POSITION_SOLVE_3D;
+    replayConfig.tagHeight = POSITION_TAG_HEIGHT;
+    replayConfig.positionInterval = POSITION_INTERVAL;
+    replayConfig.maxRangeAge = POSITION_MAX_RANGE_AGE;
+
+    FtmSchedulerConfig& config = replayConfig.scheduler;
+    config.requestTimeout = FTM_REQUEST_TIMEOUT;
+    config.minInterval = FTM_MIN_INTERVAL;
+    config.maxInterval = FTM_MAX_INTERVAL;
+    config.stableThreshold = FTM_STABLE_THRESHOLD;
+    config.filter.stages = FTM_FILTER_STAGES;
+    config.filter.gateThreshold = FTM_FILTER_GATE_THRESHOLD;
+    config.filter.gateMaxRejects = FTM_FILTER_GATE_MAX_REJECTS;
+    config.filter.medianWindow = FTM_FILTER_MEDIAN_WINDOW;
+    config.filter.processNoise = FTM_FILTER_PROCESS_NOISE;
+    config.filter.measurementNoise = FTM_FILTER_MEASUREMENT_NOISE;
+    config.burst.enabled = FTM_ADAPTIVE_BURST;
+    config.burst.frameCount = FTM_FRAME_COUNT;
+    config.burst.burstPeriod = FTM_BURST_PERIOD;
+    config.burst.lowDeviation = FTM_BURST_LOW_DEVIATION;
+    config.burst.highDeviation = FTM_BURST_HIGH_DEVIATION;
+    config.burst.maxBurstPeriod = FTM_MAX_BURST_PERIOD;
+    return replayConfig;
+}
+
+static double getMeanMicros(const FtmReplayStageStats& stage) {
+    return stage.count > 0 ? static_cast<double>(stage.totalMicros) / stage.count : 0.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <recording.csv> [--min-fixes n] [--max-mean-error m] [--max-error m]\n", argv[0]);
+        return 2;
+    }
+
+    uint32_t minFixes = 0;
+    float maxMeanError = 0.0f;
+    float maxError = 0.0f;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--min-fixes") == 0) {
+            minFixes = strtoul(argv[i + 1], nullptr, 10);
+        } else if (strcmp(argv[i], "--max-mean-error") == 0) {
+            maxMeanError = strtof(argv[i + 1], nullptr);
+        } else if (strcmp(argv[i], "--max-error") == 0) {
+            maxError = strtof(argv[i + 1], nullptr);
+        } else {
+            fprintf(stderr, "unknown option '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+
+    FILE* file = fopen(argv[1], "r");
+    if (!file) {
+        fprintf(stderr, "cannot open '%s'\n", argv[1]);
+        return 2;
+    }
+
+    FtmReplay* replay = new FtmReplay(hostMicros);
+    replay->configure(getDefaultConfig());
+
+    char line[FtmReplay::MAX_LINE_LENGTH];
+    while (fgets(line, sizeof(line), file)) {
+        replay->feedLine(line);
+    }
+    fclose(file);
+
+    const FtmReplayStats& stats = replay->getStats();
+    float meanError = stats.errorCount > 0 ? stats.errorSum / stats.errorCount : 0.0f;
+
+    printf("lines %u, parse errors %u, anchors %u, reports %u, fixes %u over %u ms\n",
+        stats.lines, stats.parseErrors, stats.anchors, stats.reports, stats.fixes, stats.lastTimestamp - stats.firstTimestamp);
+    printf("engine %.2f us/report, pipeline %.2f us/report, solver %.2f us/solve\n",
+        getMeanMicros(stats.engine), getMeanMicros(stats.pipeline), getMeanMicros(stats.solver));
+    if (stats.errorCount > 0) {
+        printf("fix error mean %.3f m, max %.3f m over %u fixes\n", meanError, stats.errorMax, stats.errorCount);
+    }
+
+    bool passed = true;
+    if (stats.parseErrors > 0) {
+        fprintf(stderr, "FAIL: %u lines could not be parsed\n", stats.parseErrors);
+        passed = false;
+    }
+    if (stats.fixes < minFixes) {
+        fprintf(stderr, "FAIL: %u fixes, expected at least %u\n", stats.fixes, minFixes);
+        passed = false;
+    }
+    if (maxMeanError > 0.0f && (stats.errorCount == 0 || meanError > maxMeanError)) {
+        fprintf(stderr, "FAIL: mean fix error %.3f m exceeds %.3f m\n", meanError, maxMeanError);
+        passed = false;
+    }
+    if (maxError > 0.0f && stats.errorMax > maxError) {
+        fprintf(stderr, "FAIL: max fix error %.3f m exceeds %.3f m\n", stats.errorMax, maxError);
+        passed = false;
+    }
+
+    delete replay;
+    return passed ? 0 : 1;
+}
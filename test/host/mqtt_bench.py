@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Runs the on-device MQTT loopback benchmark through the bench RPC command
+and prints one row per payload size.
+
+    mqtt_bench.py --broker 192.168.1.10 --device gpsno/devices/3735928559
+    mqtt_bench.py ... --sizes 16 128 480 --count 100 --window 8 --qos 1
+    mqtt_bench.py ... --compare-debug   # once at DEBUG, once at INFO
+
+Needs paho-mqtt (pip install paho-mqtt).
+"""
+
+import argparse
+import json
+import queue
+import sys
+import time
+import uuid
+
+import paho.mqtt.client as mqtt
+
+COLUMNS = ["size", "sent", "received", "msgs/s", "publish us", "p50 us", "p90 us", "p99 us", "max us"]
+
+
+class RpcClient:
+    def __init__(self, args):
+        self.device = args.device.rstrip("/")
+        self.timeout = args.timeout
+        self.responses = queue.Queue()
+
+        if hasattr(mqtt, "CallbackAPIVersion"):
+            self.client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION2, client_id="mqtt-bench-" + uuid.uuid4().hex[:8])
+        else:
+            self.client = mqtt.Client(client_id="mqtt-bench-" + uuid.uuid4().hex[:8])
+        if args.user:
+            self.client.username_pw_set(args.user, args.password)
+        self.client.on_message = lambda client, userdata, message: self.responses.put(message.payload)
+        self.client.connect(args.broker, args.port)
+        self.client.subscribe(self.device + "/rpc/res", qos=1)
+        self.client.loop_start()
+        time.sleep(0.5)
+
+    def call(self, command, params):
+        request_id = uuid.uuid4().hex[:12]
+        request = {"id": request_id, "cmd": command, "params": params}
+        self.client.publish(self.device + "/rpc/req", json.dumps(request), qos=1)
+
+        deadline = time.monotonic() + self.timeout
+        while time.monotonic() < deadline:
+            try:
+                payload = self.responses.get(timeout=deadline - time.monotonic())
+            except queue.Empty:
+                break
+            response = json.loads(payload)
+            if response.get("id") != request_id:
+                continue
+            if not response.get("ok"):
+                raise RuntimeError("%s failed: %s" % (command, response.get("result")))
+            return response["result"]
+        raise TimeoutError("no response to %s within %d s" % (command, self.timeout))
+
+    def close(self):
+        self.client.loop_stop()
+        self.client.disconnect()
+
+
+def print_result(result):
+    print("qos %d, debug logging %s" % (result["qos"], "on" if result["debug"] else "off"))
+    print("".join("%12s" % column for column in COLUMNS))
+    for row in result["runs"]:
+        print("".join("%12d" % value for value in row))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--broker", required=True)
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--user")
+    parser.add_argument("--password")
+    parser.add_argument("--device", required=True, help="device topic, <baseTopic>/<chipId>")
+    parser.add_argument("--sizes", type=int, nargs="+", help="payload sizes, at most 4")
+    parser.add_argument("--count", type=int, default=50, help="messages per size, at most 100")
+    parser.add_argument("--window", type=int, default=4, help="messages outstanding at once")
+    parser.add_argument("--qos", type=int, choices=[0, 1], default=0)
+    parser.add_argument("--compare-debug", action="store_true", help="run at DEBUG and at INFO log level")
+    parser.add_argument("--timeout", type=int, default=120, help="seconds to wait for each run")
+    parser.add_argument("--json", action="store_true", help="print raw results as JSON lines")
+    args = parser.parse_args()
+
+    params = {"count": args.count, "window": args.window, "qos": args.qos}
+    if args.sizes:
+        params["sizes"] = args.sizes
+
+    rpc = RpcClient(args)
+    try:
+        levels = ["DEBUG", "INFO"] if args.compare_debug else [None]
+        for level in levels:
+            if level:
+                rpc.call("set-log-level", {"level": level})
+            result = rpc.call("bench", params)
+            if args.json:
+                print(json.dumps(result))
+            else:
+                print_result(result)
+                print()
+    except (RuntimeError, TimeoutError) as error:
+        print(error, file=sys.stderr)
+        return 1
+    finally:
+        rpc.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
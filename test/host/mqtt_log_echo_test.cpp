@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include "ConfigManager.h"
+#include "Logger.h"
+#include "LoopbackBroker.h"
+#include "MQTTLogSink.h"
+#include "MQTTManager.h"
+
+// A handler subscribed to the MQTT log topic that logs what it receives must
+// not have that record forwarded: it would come back as the next batch, be
+// logged again and keep the device publishing to itself. The record still
+// reaches the local sinks.
+
+static const uint32_t CONNECT_TIMEOUT = 5000;
+static const uint32_t BATCH_INTERVAL = 50;
+static const uint32_t OBSERVE_PERIOD = 1500;
+
+static int failures = 0;
+static std::atomic<uint32_t> localRecords(0);
+
+static void check(bool condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "FAIL: %s\n", message);
+        failures++;
+    }
+}
+
+static int finish() {
+    fflush(stderr);
+    // The network and log tasks never return; skip static destructors.
+    _exit(failures == 0 ? 0 : 1);
+}
+
+int main() {
+    LoopbackBroker broker;
+    if (!broker.begin()) {
+        fprintf(stderr, "FAIL: broker did not start\n");
+        return 1;
+    }
+
+    RuntimeConfig& config = ConfigManager::getInstance().getRuntimeConfig();
+    strlcpy(config.mqtt.broker, "127.0.0.1", sizeof(config.mqtt.broker));
+    config.mqtt.port = broker.getPort();
+    config.mqtt.retryInterval = 100;
+    config.logging.logLevel = static_cast<uint8_t>(LogLevel::DEBUG);
+    config.logging.mqttLevel = static_cast<uint8_t>(LogLevel::DEBUG);
+    config.logging.mqttBatchInterval = BATCH_INTERVAL;
+    config.logging.mqttRateLimit = 0;
+
+    Logger& log = Logger::getInstance();
+    MQTTManager& mqttManager = MQTTManager::getInstance();
+    MQTTLogSink& logSink = MQTTLogSink::getInstance();
+    log.begin();
+    log.addSink([](const LogRecord& record) {
+        if (strcmp(record.source, "LogEchoTest") == 0 && record.localOnly) {
+            localRecords++;
+        }
+    });
+    check(mqttManager.begin(), "MQTTManager did not start");
+    check(logSink.begin(), "MQTTLogSink did not start");
+    if (failures > 0) {
+        return finish();
+    }
+
+    uint32_t batches = 0;
+    std::string filter = std::string(mqttManager.getDeviceTopic()) + "/log";
+    mqttManager.subscribe(filter.c_str(), [&batches](const char* topic, const uint8_t* payload, unsigned int length) {
+        batches++;
+        LOG_DEBUG("LogEchoTest", "Received log batch (%u bytes)", length);
+    });
+
+    uint32_t startedAt = millis();
+    while (!mqttManager.isConnected()) {
+        if (millis() - startedAt > CONNECT_TIMEOUT) {
+            check(false, "no connection to the loopback broker");
+            return finish();
+        }
+        delay(10);
+    }
+
+    log.info("LogEchoTest", "seed");
+
+    startedAt = millis();
+    while (millis() - startedAt < OBSERVE_PERIOD) {
+        mqttManager.update();
+        logSink.update();
+        delay(1);
+    }
+    log.flush();
+
+    if (batches != 1) {
+        fprintf(stderr, "FAIL: expected only the seed batch, received %u\n", batches);
+        failures++;
+    }
+    check(localRecords.load() == batches, "records logged by the handler did not reach the local sinks");
+
+    if (failures == 0) {
+        printf("log echo: %u batch, %u local-only records\n", batches, localRecords.load());
+    }
+    fflush(stdout);
+    return finish();
+}
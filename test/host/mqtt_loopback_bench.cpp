@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ConfigManager.h"
+#include "Logger.h"
+#include "LoopbackBroker.h"
+#include "MQTTBenchmark.h"
+#include "MQTTManager.h"
+
+// Drives the firmware MQTTManager and MQTTBenchmark against a loopback broker:
+// publish() -> command ring -> outbound queue -> network drain -> broker ->
+// PubSubClient loop -> inbound ring -> update() dispatch. Prints one JSON line
+// per run, then one per payload size and QoS comparing LOG_DEBUG off and on.
+//
+// cpu_us_per_msg is process CPU time minus the broker thread and the idle
+// cost of the same loop, divided by round trips, so it covers the application
+// loop, the network task and the log drain task. Each configuration runs
+// --repeat times with LOG_DEBUG off and on interleaved, so drift in the host
+// load lands on both sides, and the comparison lines average the repeats.
+//
+//     mqtt_loopback_bench [--count N] [--window N] [--repeat N]
+
+static const uint16_t SIZES[] = {16, 128, 480};
+static const uint8_t SIZE_COUNT = sizeof(SIZES) / sizeof(SIZES[0]);
+static const uint32_t CONNECT_TIMEOUT = 5000;
+static const uint32_t IDLE_PERIOD = 2000;
+static const uint32_t RUN_TIMEOUT = 30000;
+static const uint8_t MAX_REPEATS = 16;
+
+struct RunResult {
+    MQTTBenchmarkRun run;
+    double cpuPerMessage;
+};
+
+static uint64_t processCpuMicros() {
+    timespec time;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return static_cast<uint64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+}
+
+static void step(MQTTManager& mqttManager, MQTTBenchmark& benchmark) {
+    mqttManager.update();
+    benchmark.update();
+    delay(1);
+}
+
+// CPU per microsecond of wall time spent by everything except the broker
+// while the loop has nothing to do.
+static double measureIdle(MQTTManager& mqttManager, MQTTBenchmark& benchmark, LoopbackBroker& broker) {
+    uint64_t startedAt = micros();
+    uint64_t cpu = processCpuMicros() - broker.getCpuMicros();
+    while (micros() - startedAt < IDLE_PERIOD * 1000UL) {
+        step(mqttManager, benchmark);
+    }
+    uint64_t elapsed = micros() - startedAt;
+    return static_cast<double>(processCpuMicros() - broker.getCpuMicros() - cpu) / elapsed;
+}
+
+static bool runOnce(MQTTManager& mqttManager, MQTTBenchmark& benchmark, LoopbackBroker& broker, double idleRate,
+                    uint16_t size, uint16_t count, uint8_t window, uint8_t qos, RunResult& result) {
+    uint64_t startedAt = micros();
+    uint64_t cpu = processCpuMicros() - broker.getCpuMicros();
+
+    if (!benchmark.start(&size, 1, count, window, qos, nullptr)) {
+        fprintf(stderr, "FAIL: benchmark did not start\n");
+        return false;
+    }
+    while (benchmark.isRunning()) {
+        if (micros() - startedAt > RUN_TIMEOUT * 1000UL) {
+            fprintf(stderr, "FAIL: %u B run did not finish\n", size);
+            return false;
+        }
+        step(mqttManager, benchmark);
+    }
+
+    uint64_t elapsed = micros() - startedAt;
+    double used = static_cast<double>(processCpuMicros() - broker.getCpuMicros() - cpu) - idleRate * elapsed;
+    result.run = benchmark.getRun(0);
+    result.cpuPerMessage = result.run.received > 0 ? (used > 0 ? used : 0) / result.run.received : 0;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    uint16_t count = MQTTBenchmark::MAX_MESSAGES;
+    uint8_t window = 8;
+    uint8_t repeats = 2;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--count N] [--window N] [--repeat N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (count == 0 || count > MQTTBenchmark::MAX_MESSAGES || repeats == 0 || repeats > MAX_REPEATS) {
+        fprintf(stderr, "count must be 1-%u and repeat 1-%u\n", MQTTBenchmark::MAX_MESSAGES, MAX_REPEATS);
+        return 2;
+    }
+
+    LoopbackBroker broker;
+    if (!broker.begin()) {
+        fprintf(stderr, "FAIL: broker did not start\n");
+        return 1;
+    }
+
+    RuntimeConfig& config = ConfigManager::getInstance().getRuntimeConfig();
+    strlcpy(config.mqtt.broker, "127.0.0.1", sizeof(config.mqtt.broker));
+    config.mqtt.port = broker.getPort();
+    config.mqtt.retryInterval = 100;
+
+    Logger& log = Logger::getInstance();
+    MQTTManager& mqttManager = MQTTManager::getInstance();
+    MQTTBenchmark benchmark;
+    log.begin();
+    if (!mqttManager.begin()) {
+        fprintf(stderr, "FAIL: MQTTManager did not start\n");
+        return 1;
+    }
+
+    uint32_t connectStartedAt = millis();
+    while (!mqttManager.isConnected()) {
+        if (millis() - connectStartedAt > CONNECT_TIMEOUT) {
+            fprintf(stderr, "FAIL: no connection to the loopback broker\n");
+            return 1;
+        }
+        delay(10);
+    }
+
+    bool passed = true;
+    static RunResult results[2][2][SIZE_COUNT][MAX_REPEATS];
+    double idleRate = measureIdle(mqttManager, benchmark, broker);
+    for (uint8_t qos = 0; qos < 2 && passed; qos++) {
+        for (uint8_t i = 0; i < SIZE_COUNT && passed; i++) {
+            for (uint8_t repeat = 0; repeat < repeats && passed; repeat++) {
+                for (uint8_t debug = 0; debug < 2 && passed; debug++) {
+                    log.setLogLevel(debug ? LogLevel::DEBUG : LogLevel::INFO);
+                    RunResult& result = results[debug][qos][i][repeat];
+                    passed = runOnce(mqttManager, benchmark, broker, idleRate, SIZES[i], count, window, qos, result);
+                    if (!passed) {
+                        break;
+                    }
+
+                    const MQTTBenchmarkRun& run = result.run;
+                    double seconds = run.durationMicros / 1e6;
+                    printf("{\"bench\":\"mqtt_loopback\",\"debug\":%s,\"qos\":%u,\"size\":%u,\"repeat\":%u,\"sent\":%u,\"received\":%u,\"duplicates\":%u,\"stalls\":%u,"
+                           "\"msgs_per_s\":%.1f,\"p50_us\":%u,\"p90_us\":%u,\"p99_us\":%u,\"max_us\":%u,\"cpu_us_per_msg\":%.2f,\"publish_us_per_msg\":%.2f}\n",
+                        debug ? "true" : "false", qos, run.payloadSize, repeat, run.sent, run.received, run.duplicates, run.stalls,
+                        seconds > 0 ? run.received / seconds : 0.0, run.p50, run.p90, run.p99, run.max,
+                        result.cpuPerMessage, run.sent > 0 ? static_cast<double>(run.publishMicros) / run.sent : 0.0);
+
+                    if (run.sent != count || run.received != run.sent || run.duplicates > 0) {
+                        fprintf(stderr, "FAIL: %u B qos %u: %u sent, %u received, %u duplicates\n", run.payloadSize, qos, run.sent, run.received, run.duplicates);
+                        passed = false;
+                    }
+                }
+            }
+        }
+    }
+
+    if (passed) {
+        for (uint8_t qos = 0; qos < 2; qos++) {
+            for (uint8_t i = 0; i < SIZE_COUNT; i++) {
+                double cpu[2] = {0, 0};
+                double p50[2] = {0, 0};
+                double p99[2] = {0, 0};
+                for (uint8_t debug = 0; debug < 2; debug++) {
+                    for (uint8_t repeat = 0; repeat < repeats; repeat++) {
+                        const RunResult& result = results[debug][qos][i][repeat];
+                        cpu[debug] += result.cpuPerMessage / repeats;
+                        p50[debug] += static_cast<double>(result.run.p50) / repeats;
+                        p99[debug] += static_cast<double>(result.run.p99) / repeats;
+                    }
+                }
+                printf("{\"bench\":\"mqtt_loopback_debug_cost\",\"qos\":%u,\"size\":%u,\"repeats\":%u,\"cpu_us_per_msg_off\":%.2f,\"cpu_us_per_msg_on\":%.2f,"
+                       "\"p50_us_off\":%.0f,\"p50_us_on\":%.0f,\"p99_us_off\":%.0f,\"p99_us_on\":%.0f}\n",
+                    qos, SIZES[i], repeats, cpu[0], cpu[1], p50[0], p50[1], p99[0], p99[1]);
+            }
+        }
+    }
+
+    // The network and log tasks never return; skip static destructors that
+    // would tear down the singletons underneath them.
+    broker.end();
+    fflush(stdout);
+    fflush(stderr);
+    _exit(passed ? 0 : 1);
+}
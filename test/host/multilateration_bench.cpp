@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include "Multilateration.h"
+
+// Solves a fixed tag position from 4, 8 and 16 noisy anchor ranges in 2D
+// and 3D, checks the fix against the truth and reports solves per second.
+
+static const uint32_t ITERATIONS = 50000;
+static const float RANGE_NOISE = 0.1f;
+static const float TAG[3] = {3.2f, 4.7f, 1.0f};
+
+static bool run(uint8_t anchors, bool solve3d, float maxError, std::mt19937& rng) {
+    std::normal_distribution<float> noise(0.0f, RANGE_NOISE);
+
+    Multilateration multilateration;
+    multilateration.setHeight(TAG[2]);
+    for (uint8_t i = 0; i < anchors; i++) {
+        float x = (i * 37) % 10;
+        float y = (i * 53) % 10;
+        float z = i % 2 == 0 ? 2.5f : 0.3f;
+        float dx = x - TAG[0];
+        float dy = y - TAG[1];
+        float dz = z - TAG[2];
+        multilateration.addRange(x, y, z, sqrtf(dx * dx + dy * dy + dz * dz) + noise(rng));
+    }
+
+    PositionFix fix;
+    if (!multilateration.solve(fix, solve3d)) {
+        fprintf(stderr, "FAIL: %u anchors %s did not solve\n", anchors, solve3d ? "3D" : "2D");
+        return false;
+    }
+
+    float dx = fix.x - TAG[0];
+    float dy = fix.y - TAG[1];
+    float dz = solve3d ? fix.z - TAG[2] : 0.0f;
+    float error = sqrtf(dx * dx + dy * dy + dz * dz);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        multilateration.solve(fix, solve3d);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%2u anchors %s: error %.3f m, residual %.3f m, %u iterations, %.0f solves/s\n",
+        anchors, solve3d ? "3D" : "2D", error, fix.residual, fix.iterations, ITERATIONS / seconds);
+
+    if (error > maxError) {
+        fprintf(stderr, "FAIL: %u anchors %s error %.3f m exceeds %.3f m\n", anchors, solve3d ? "3D" : "2D", error, maxError);
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    std::mt19937 rng(1);
+    bool passed = true;
+
+    const uint8_t counts[] = {4, 8, 16};
+    for (uint8_t anchors : counts) {
+        passed &= run(anchors, false, 0.3f, rng);
+        passed &= run(anchors, true, 0.5f, rng);
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <set>
+#include <vector>
+#include "MQTTAckClient.h"
+#include "MQTTOutboundQueue.h"
+
+// Publishes a mixed QoS 0/1 stream through MQTTOutboundQueue and
+// MQTTAckClient to a fake broker, following the network task's drain loop.
+// The broker parses every PUBLISH, acknowledges QoS 1 after a delay, mixes
+// in traffic the ack parser must skip, and drops the connection once. Checks
+// that the in-flight window is never exceeded, that every message arrives
+// in order, and that only unacknowledged messages are resent, with DUP set
+// and their original packet id.
+
+static const uint32_t MESSAGES = 2000;
+static const uint32_t ACK_DELAY = 5;
+static const uint8_t DRAIN_BUDGET = 4;
+static const uint32_t DISCONNECT_AT = MESSAGES / 2;
+static const char* TOPIC = "gpsno/devices/1/bench";
+
+class FakeBroker : public Client {
+public:
+    uint8_t window = 0;
+    bool failed = false;
+    uint32_t delivered = 0;
+    uint32_t duplicates = 0;
+    uint32_t maxInFlight = 0;
+    std::set<uint16_t> unacked;
+    std::set<uint16_t> dropped;
+
+    int connect(IPAddress, uint16_t) override { return 1; }
+    int connect(const char*, uint16_t) override { return 1; }
+    size_t write(uint8_t value) override { return write(&value, 1); }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        received.insert(received.end(), buffer, buffer + size);
+        parse();
+        return size;
+    }
+
+    int available() override { return static_cast<int>(outbound.size()); }
+
+    int read() override {
+        if (outbound.empty()) {
+            return -1;
+        }
+        uint8_t value = outbound.front();
+        outbound.pop_front();
+        return value;
+    }
+
+    int read(uint8_t* buffer, size_t size) override {
+        size_t count = 0;
+        while (count < size && !outbound.empty()) {
+            buffer[count++] = outbound.front();
+            outbound.pop_front();
+        }
+        return static_cast<int>(count);
+    }
+
+    int peek() override { return outbound.empty() ? -1 : outbound.front(); }
+    void flush() override {}
+    void stop() override {}
+    uint8_t connected() override { return 1; }
+    operator bool() override { return true; }
+
+    void tick(uint32_t now) {
+        while (!pendingAcks.empty() && now - pendingAcks.front().receivedAt >= ACK_DELAY) {
+            uint16_t packetId = pendingAcks.front().packetId;
+            pendingAcks.pop_front();
+            unacked.erase(packetId);
+
+            // Broker-originated traffic around the ack: a QoS 0 PUBLISH whose
+            // body is full of PUBACK-looking bytes, and a PINGRESP.
+            const uint8_t noise[] = {0x30, 0x06, 0x00, 0x01, 't', 0x40, 0x02, 0x40};
+            outbound.insert(outbound.end(), noise, noise + sizeof(noise));
+            const uint8_t ack[] = {0x40, 0x02, static_cast<uint8_t>(packetId >> 8), static_cast<uint8_t>(packetId & 0xFF)};
+            outbound.insert(outbound.end(), ack, ack + sizeof(ack));
+            const uint8_t ping[] = {0xD0, 0x00};
+            outbound.insert(outbound.end(), ping, ping + sizeof(ping));
+        }
+    }
+
+    // Loses the session's unacknowledged state and anything still on the wire.
+    void drop() {
+        dropped = unacked;
+        unacked.clear();
+        pendingAcks.clear();
+        outbound.clear();
+    }
+
+    void setNow(uint32_t now) { this->now = now; }
+
+private:
+    struct PendingAck {
+        uint16_t packetId;
+        uint32_t receivedAt;
+    };
+
+    std::vector<uint8_t> received;
+    std::deque<uint8_t> outbound;
+    std::deque<PendingAck> pendingAcks;
+    uint32_t now = 0;
+
+    void fail(const char* message) {
+        fprintf(stderr, "FAIL: %s\n", message);
+        failed = true;
+    }
+
+    void parse() {
+        for (;;) {
+            size_t position = 1;
+            uint32_t remaining = 0;
+            uint8_t shift = 0;
+            for (;;) {
+                if (position >= received.size()) {
+                    return;
+                }
+                uint8_t digit = received[position++];
+                remaining |= static_cast<uint32_t>(digit & 0x7F) << shift;
+                shift += 7;
+                if (!(digit & 0x80)) {
+                    break;
+                }
+            }
+            if (received.size() < position + remaining) {
+                return;
+            }
+
+            handle(received[0], &received[position], remaining);
+            received.erase(received.begin(), received.begin() + position + remaining);
+        }
+    }
+
+    void handle(uint8_t header, const uint8_t* body, uint32_t length) {
+        if ((header & 0xF0) != 0x30) {
+            fail("unexpected packet type");
+            return;
+        }
+
+        uint8_t qos = (header >> 1) & 0x03;
+        bool duplicate = header & 0x08;
+        uint16_t topicLength = (body[0] << 8) | body[1];
+        if (topicLength != strlen(TOPIC) || memcmp(body + 2, TOPIC, topicLength) != 0) {
+            fail("topic mangled");
+            return;
+        }
+
+        size_t position = 2 + topicLength;
+        uint16_t packetId = 0;
+        if (qos > 0) {
+            packetId = (body[position] << 8) | body[position + 1];
+            position += 2;
+        }
+
+        char payload[16] = {0};
+        uint32_t payloadLength = length - position;
+        uint32_t sequence = 0;
+        if (payloadLength == 0 || payloadLength >= sizeof(payload)) {
+            fail("payload mangled");
+            return;
+        }
+        memcpy(payload, body + position, payloadLength);
+        if (sscanf(payload, "%u", &sequence) != 1) {
+            fail("payload mangled");
+            return;
+        }
+
+        if (duplicate) {
+            duplicates++;
+            if (qos == 0 || dropped.erase(packetId) == 0) {
+                fail("DUP set on a message the broker never lost");
+            }
+        } else if (sequence != delivered) {
+            fprintf(stderr, "FAIL: message %u arrived, expected %u\n", sequence, delivered);
+            failed = true;
+        } else {
+            delivered++;
+        }
+
+        if (qos > 0) {
+            unacked.insert(packetId);
+            pendingAcks.push_back({packetId, now});
+            if (unacked.size() > maxInFlight) {
+                maxInFlight = unacked.size();
+            }
+            if (unacked.size() > window) {
+                fail("in-flight window exceeded");
+            }
+        }
+    }
+};
+
+// QoS 0 goes out through PubSubClient on the device.
+static bool writeQos0(Client& client, const MQTTQueuedMessage& message) {
+    uint8_t packet[4 + MQTTOutboundQueue::MAX_TOPIC_LENGTH + MQTTOutboundQueue::MAX_PAYLOAD_LENGTH];
+    size_t position = 0;
+    packet[position++] = 0x30;
+    packet[position++] = 2 + message.topicLength + message.length;
+    packet[position++] = 0x00;
+    packet[position++] = message.topicLength;
+    memcpy(packet + position, message.topic, message.topicLength);
+    position += message.topicLength;
+    memcpy(packet + position, message.payload, message.length);
+    position += message.length;
+    return client.write(packet, position) == position;
+}
+
+static bool run(uint8_t window) {
+    FakeBroker broker;
+    broker.window = window;
+    MQTTAckClient ackClient(broker);
+    MQTTOutboundQueue* queue = new MQTTOutboundQueue();
+
+    uint32_t pushed = 0;
+    uint32_t qos1 = 0;
+    uint16_t nextPacketId = 0x8000;
+    bool disconnected = false;
+    uint32_t now = 0;
+
+    while ((pushed < MESSAGES || !queue->isEmpty()) && now < MESSAGES * 50 && !broker.failed) {
+        broker.setNow(now);
+        broker.tick(now);
+
+        // PubSubClient's loop() reads everything that arrived.
+        uint8_t buffer[32];
+        while (ackClient.available() > 0) {
+            ackClient.read(buffer, sizeof(buffer));
+        }
+
+        uint16_t packetId;
+        while (ackClient.popAck(packetId)) {
+            queue->acknowledge(packetId, now);
+        }
+
+        if (!disconnected && broker.delivered >= DISCONNECT_AT) {
+            disconnected = true;
+            broker.drop();
+            ackClient.stop();
+            queue->requeueInFlight();
+        }
+
+        while (pushed < MESSAGES && queue->getCount() < MQTTOutboundQueue::CAPACITY) {
+            char payload[16];
+            uint8_t qos = pushed % 4 == 3 ? 0 : 1;
+            int length = snprintf(payload, sizeof(payload), "%u", pushed);
+            queue->push(TOPIC, strlen(TOPIC), true, payload, length, false, MQTTPriority::NORMAL, qos, now);
+            qos1 += qos;
+            pushed++;
+        }
+
+        for (uint8_t i = 0; i < DRAIN_BUDGET; i++) {
+            MQTTQueuedMessage* message = queue->next(window);
+            if (!message) {
+                break;
+            }
+            if (message->qos > 0 && !message->duplicate) {
+                message->packetId = nextPacketId++;
+            }
+
+            bool written = message->qos > 0
+                ? ackClient.writePublish(*message)
+                : writeQos0(broker, *message);
+
+            if (written && message->qos > 0) {
+                queue->markInFlight(message, message->packetId, now);
+            } else {
+                queue->complete(message, written, now);
+            }
+        }
+
+        now++;
+    }
+
+    const MQTTQueueStats& stats = queue->getStats();
+    bool passed = !broker.failed;
+    if (broker.delivered != MESSAGES) {
+        fprintf(stderr, "FAIL: window %u delivered %u of %u messages\n", window, broker.delivered, MESSAGES);
+        passed = false;
+    }
+    if (stats.acknowledged != qos1 || stats.inFlight != 0) {
+        fprintf(stderr, "FAIL: window %u acknowledged %u of %u QoS 1 messages\n", window, stats.acknowledged, qos1);
+        passed = false;
+    }
+    if (broker.maxInFlight != window || !broker.dropped.empty() || stats.retransmits != broker.duplicates) {
+        fprintf(stderr, "FAIL: window %u peaked at %u in flight, %zu lost messages not resent\n", window, broker.maxInFlight, broker.dropped.size());
+        passed = false;
+    }
+
+    printf("window %u: %u messages in %u ticks (%.2f/tick) at %u-tick ack delay, %u resent after disconnect\n",
+        window, broker.delivered, now, static_cast<double>(broker.delivered) / now, ACK_DELAY, stats.retransmits);
+
+    delete queue;
+    return passed;
+}
+
+int main() {
+    bool passed = true;
+    const uint8_t windows[] = {1, 4, 8};
+    for (uint8_t window : windows) {
+        passed &= run(window);
+    }
+    return passed ? 0 : 1;
+}
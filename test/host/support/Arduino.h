@@ -0,0 +1,56 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <functional>
+#include <string>
+
+// Host stand-in for the parts of the Arduino core that the MQTT and logging
+// modules use. Time starts at zero when the process starts, like on boot.
+
+typedef uint8_t byte;
+
+#define F(text) text
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+#define HOST_NEEDS_STRLCPY
+extern "C" size_t strlcpy(char* destination, const char* source, size_t size);
+#endif
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+class String {
+public:
+    String() {}
+    String(const char* text) : text(text ? text : "") {}
+    String(const std::string& text) : text(text) {}
+
+    const char* c_str() const { return text.c_str(); }
+    size_t length() const { return text.size(); }
+    bool operator==(const char* other) const { return text == other; }
+    bool operator==(const String& other) const { return text == other.text; }
+    String operator+(const char* other) const { return String(text + other); }
+    String operator+(const String& other) const { return String(text + other.text); }
+
+private:
+    std::string text;
+};
+
+// Discards output unless GPSNO_HOST_SERIAL is set, so benchmarks still pay
+// for formatting but not for the terminal.
+class HardwareSerial {
+public:
+    size_t println(const char* text);
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef ARDUINO_JSON_H
+#define ARDUINO_JSON_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+// Host stand-in for the ArduinoJson 6 calls MQTTLogSink makes: a document
+// holding one flat array of numbers and strings.
+
+class JsonArray {
+public:
+    JsonArray(std::string* elements = nullptr) : elements(elements) {}
+
+    bool add(uint32_t value) {
+        char text[16];
+        snprintf(text, sizeof(text), "%u", static_cast<unsigned>(value));
+        return append(text);
+    }
+
+    bool add(const char* value) {
+        std::string text = "\"";
+        for (const char* cursor = value; *cursor; cursor++) {
+            unsigned char c = *cursor;
+            if (c == '"' || c == '\\') {
+                text += '\\';
+                text += c;
+            } else if (c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                text += escaped;
+            } else {
+                text += c;
+            }
+        }
+        text += '"';
+        return append(text);
+    }
+
+private:
+    std::string* elements;
+
+    bool append(const std::string& text) {
+        if (!elements) {
+            return false;
+        }
+        if (!elements->empty()) {
+            *elements += ',';
+        }
+        *elements += text;
+        return true;
+    }
+};
+
+template <size_t Capacity>
+class StaticJsonDocument {
+public:
+    template <typename T>
+    T to() {
+        elements.clear();
+        return T(&elements);
+    }
+
+    std::string serialize() const { return "[" + elements + "]"; }
+
+private:
+    std::string elements;
+};
+
+template <typename Document>
+size_t measureJson(const Document& document) {
+    return document.serialize().size();
+}
+
+template <typename Document>
+size_t serializeJson(const Document& document, char* output, size_t size) {
+    std::string text = document.serialize();
+    if (size == 0) {
+        return 0;
+    }
+    size_t length = text.size() < size - 1 ? text.size() : size - 1;
+    memcpy(output, text.data(), length);
+    output[length] = '\0';
+    return length;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include "ConfigManager.h"
+
+// Host link seam for ConfigManager: defaults come from ConfigDefines without
+// flash, efuse or WiFi, and patches are never applied, so only the parts the
+// MQTT and logging modules call are defined here.
+
+void ConfigManager::loadDefaults() {
+    memset(&config, 0, sizeof(config));
+
+    strlcpy(config.device.name, DEVICE_NAME, sizeof(config.device.name));
+    config.device.chipID = 1;
+
+    strlcpy(config.mqtt.broker, MQTT_BROKER, sizeof(config.mqtt.broker));
+    config.mqtt.port = MQTT_PORT;
+    strlcpy(config.mqtt.user, MQTT_USER, sizeof(config.mqtt.user));
+    strlcpy(config.mqtt.password, MQTT_PASSWORD, sizeof(config.mqtt.password));
+    config.mqtt.retryInterval = MQTT_RETRY_INTERVAL;
+    config.mqtt.maxConnectionAttempts = MQTT_MAX_CONNECTION_ATTEMPTS;
+    strlcpy(config.mqtt.baseTopic, MQTT_BASE_TOPIC, sizeof(config.mqtt.baseTopic));
+    config.mqtt.drainBudget = MQTT_DRAIN_BUDGET;
+    config.mqtt.inflightWindow = MQTT_INFLIGHT_WINDOW;
+    config.mqtt.persistentSession = MQTT_PERSISTENT_SESSION;
+
+    config.logging.allowMqttLog = LOGGING_ALLOW_MQTT_LOG;
+    config.logging.logLevel = LOGGING_LEVEL;
+    strlcpy(config.logging.mqttTopic, LOGGING_MQTT_TOPIC, sizeof(config.logging.mqttTopic));
+    config.logging.mqttLevel = LOGGING_MQTT_LEVEL;
+    config.logging.mqttBatchSize = LOGGING_MQTT_BATCH_SIZE;
+    config.logging.mqttBatchInterval = LOGGING_MQTT_BATCH_INTERVAL;
+    config.logging.mqttRateLimit = LOGGING_MQTT_RATE_LIMIT;
+}
+
+bool ConfigManager::addListener(uint16_t sections, ConfigListener listener) {
+    if (listenerCount >= MAX_LISTENERS) {
+        return false;
+    }
+
+    listeners[listenerCount].sections = sections;
+    listeners[listenerCount].listener = listener;
+    listenerCount++;
+    return true;
+}
@@ -0,0 +1,86 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdarg.h>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+WiFiClass WiFi;
+
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+#ifdef HOST_NEEDS_STRLCPY
+extern "C" size_t strlcpy(char* destination, const char* source, size_t size) {
+    size_t length = strlen(source);
+    if (size > 0) {
+        size_t copied = length < size - 1 ? length : size - 1;
+        memcpy(destination, source, copied);
+        destination[copied] = '\0';
+    }
+    return length;
+}
+#endif
+
+static bool serialEnabled() {
+    static const bool enabled = getenv("GPSNO_HOST_SERIAL") != nullptr;
+    return enabled;
+}
+
+size_t HardwareSerial::println(const char* text) {
+    if (!serialEnabled()) {
+        return 0;
+    }
+    return fprintf(stderr, "%s\n", text);
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    if (!serialEnabled()) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int length = vfprintf(stderr, format, args);
+    va_end(args);
+    return length < 0 ? 0 : length;
+}
+
+// Tasks never return and are never deleted, so they run as detached threads
+// and the handle only has to be unique and non-null.
+static thread_local char currentTask;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackSize, void* parameter, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    static char taskHandles[16];
+    static uint8_t taskCount = 0;
+    if (taskCount >= sizeof(taskHandles)) {
+        return pdFAIL;
+    }
+
+    if (handle) {
+        *handle = &taskHandles[taskCount];
+    }
+    taskCount++;
+    std::thread(function, parameter).detach();
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return &currentTask;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
@@ -0,0 +1,6 @@
+#ifndef LITTLEFS_H
+#define LITTLEFS_H
+
+// Included by ConfigManager.h; the host harness never touches flash.
+
+#endif
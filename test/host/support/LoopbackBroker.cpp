@@ -0,0 +1,339 @@
+#include "LoopbackBroker.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static const uint8_t CONNECT = 0x10;
+static const uint8_t CONNACK = 0x20;
+static const uint8_t PUBLISH = 0x30;
+static const uint8_t PUBACK = 0x40;
+static const uint8_t SUBSCRIBE = 0x80;
+static const uint8_t SUBACK = 0x90;
+static const uint8_t UNSUBSCRIBE = 0xA0;
+static const uint8_t UNSUBACK = 0xB0;
+static const uint8_t PINGREQ = 0xC0;
+static const uint8_t PINGRESP = 0xD0;
+static const uint8_t DISCONNECT = 0xE0;
+
+static const int POLL_INTERVAL = 20;
+
+LoopbackBroker::LoopbackBroker()
+    : listener(-1)
+    , port(0)
+    , running(false)
+    , published(0)
+    , delivered(0) {}
+
+LoopbackBroker::~LoopbackBroker() {
+    end();
+}
+
+bool LoopbackBroker::begin() {
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        return false;
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listener, 4) != 0
+        || getsockname(listener, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0) {
+        close(listener);
+        listener = -1;
+        return false;
+    }
+
+    port = ntohs(address.sin_port);
+    running = true;
+    thread = std::thread(&LoopbackBroker::run, this);
+    return true;
+}
+
+void LoopbackBroker::end() {
+    if (!running.exchange(false)) {
+        return;
+    }
+
+    thread.join();
+    for (Connection& connection : connections) {
+        close(connection.socket);
+    }
+    connections.clear();
+    close(listener);
+    listener = -1;
+}
+
+uint64_t LoopbackBroker::getCpuMicros() {
+    clockid_t clock;
+    timespec time;
+    if (!running || pthread_getcpuclockid(thread.native_handle(), &clock) != 0 || clock_gettime(clock, &time) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+}
+
+void LoopbackBroker::run() {
+    std::vector<pollfd> descriptors;
+
+    while (running) {
+        descriptors.clear();
+        descriptors.push_back({listener, POLLIN, 0});
+        for (const Connection& connection : connections) {
+            descriptors.push_back({connection.socket, POLLIN, 0});
+        }
+
+        if (poll(descriptors.data(), descriptors.size(), POLL_INTERVAL) <= 0) {
+            continue;
+        }
+
+        // Connections are only added or removed below, after the loop over
+        // the descriptors that were polled.
+        std::vector<int> closed;
+        for (size_t i = 1; i < descriptors.size(); i++) {
+            if (descriptors[i].revents && !receive(connections[i - 1])) {
+                closed.push_back(connections[i - 1].socket);
+            }
+        }
+        for (int socket : closed) {
+            for (size_t i = 0; i < connections.size(); i++) {
+                if (connections[i].socket == socket) {
+                    close(socket);
+                    connections.erase(connections.begin() + i);
+                    break;
+                }
+            }
+        }
+
+        if (descriptors[0].revents & POLLIN) {
+            int socket = accept(listener, nullptr, nullptr);
+            if (socket >= 0) {
+                int enabled = 1;
+                setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+                connections.push_back({socket, {}, {}});
+            }
+        }
+    }
+}
+
+bool LoopbackBroker::receive(Connection& connection) {
+    uint8_t buffer[4096];
+    ssize_t count = recv(connection.socket, buffer, sizeof(buffer), 0);
+    if (count <= 0) {
+        return count < 0 && (errno == EAGAIN || errno == EINTR);
+    }
+    connection.input.insert(connection.input.end(), buffer, buffer + count);
+
+    size_t offset = 0;
+    for (;;) {
+        size_t available = connection.input.size() - offset;
+        const uint8_t* packet = connection.input.data() + offset;
+        if (available < 2) {
+            break;
+        }
+
+        uint32_t length = 0;
+        uint8_t shift = 0;
+        size_t headerLength = 1;
+        bool complete = false;
+        while (headerLength < available && headerLength <= 4) {
+            uint8_t value = packet[headerLength++];
+            length |= static_cast<uint32_t>(value & 0x7F) << shift;
+            shift += 7;
+            if (!(value & 0x80)) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete) {
+            if (headerLength > 4) {
+                return false;
+            }
+            break;
+        }
+        if (available < headerLength + length) {
+            break;
+        }
+
+        if (!handlePacket(connection, packet[0], packet + headerLength, length)) {
+            return false;
+        }
+        offset += headerLength + length;
+    }
+
+    connection.input.erase(connection.input.begin(), connection.input.begin() + offset);
+    return true;
+}
+
+static std::string readString(const uint8_t* body, uint32_t length, uint32_t& offset) {
+    if (offset + 2 > length) {
+        offset = length + 1;
+        return std::string();
+    }
+    uint16_t size = (body[offset] << 8) | body[offset + 1];
+    offset += 2;
+    if (offset + size > length) {
+        offset = length + 1;
+        return std::string();
+    }
+    std::string text(reinterpret_cast<const char*>(body + offset), size);
+    offset += size;
+    return text;
+}
+
+bool LoopbackBroker::handlePacket(Connection& connection, uint8_t header, const uint8_t* body, uint32_t length) {
+    switch (header & 0xF0) {
+        case CONNECT: {
+            const uint8_t ack[] = {0x00, 0x00};
+            sendPacket(connection.socket, CONNACK, ack, sizeof(ack));
+            return true;
+        }
+        case PUBLISH: {
+            uint32_t offset = 0;
+            std::string topic = readString(body, length, offset);
+            uint8_t qos = (header >> 1) & 0x03;
+            if (qos > 0) {
+                if (offset + 2 > length) {
+                    return false;
+                }
+                sendPacket(connection.socket, PUBACK, body + offset, 2);
+                offset += 2;
+            }
+            if (offset > length) {
+                return false;
+            }
+            published++;
+            route(topic, body + offset, length - offset);
+            return true;
+        }
+        case SUBSCRIBE:
+        case UNSUBSCRIBE: {
+            bool subscribe = (header & 0xF0) == SUBSCRIBE;
+            if (length < 2) {
+                return false;
+            }
+            std::vector<uint8_t> ack(body, body + 2);
+            uint32_t offset = 2;
+            while (offset < length) {
+                std::string filter = readString(body, length, offset);
+                if (subscribe) {
+                    offset++;
+                    if (offset > length) {
+                        return false;
+                    }
+                    connection.filters.push_back(filter);
+                    ack.push_back(0x00);
+                } else {
+                    for (size_t i = 0; i < connection.filters.size(); i++) {
+                        if (connection.filters[i] == filter) {
+                            connection.filters.erase(connection.filters.begin() + i);
+                            break;
+                        }
+                    }
+                }
+            }
+            if (offset > length) {
+                return false;
+            }
+            sendPacket(connection.socket, subscribe ? SUBACK : UNSUBACK, ack.data(), ack.size());
+            return true;
+        }
+        case PINGREQ:
+            sendPacket(connection.socket, PINGRESP, nullptr, 0);
+            return true;
+        case PUBACK:
+            return true;
+        case DISCONNECT:
+        default:
+            return false;
+    }
+}
+
+// Each matching connection gets one copy, however many of its filters match.
+void LoopbackBroker::route(const std::string& topic, const uint8_t* payload, uint32_t length) {
+    std::vector<uint8_t> body;
+    body.push_back(topic.size() >> 8);
+    body.push_back(topic.size() & 0xFF);
+    body.insert(body.end(), topic.begin(), topic.end());
+    body.insert(body.end(), payload, payload + length);
+
+    for (const Connection& connection : connections) {
+        for (const std::string& filter : connection.filters) {
+            if (matches(filter, topic)) {
+                sendPacket(connection.socket, PUBLISH, body.data(), body.size());
+                delivered++;
+                break;
+            }
+        }
+    }
+}
+
+bool LoopbackBroker::matches(const std::string& filter, const std::string& topic) {
+    size_t f = 0;
+    size_t t = 0;
+    while (f < filter.size()) {
+        size_t filterEnd = filter.find('/', f);
+        if (filterEnd == std::string::npos) {
+            filterEnd = filter.size();
+        }
+        std::string level = filter.substr(f, filterEnd - f);
+        if (level == "#") {
+            return true;
+        }
+        if (t > topic.size()) {
+            return false;
+        }
+
+        size_t topicEnd = topic.find('/', t);
+        if (topicEnd == std::string::npos) {
+            topicEnd = topic.size();
+        }
+        if (level != "+" && level != topic.substr(t, topicEnd - t)) {
+            return false;
+        }
+
+        f = filterEnd + 1;
+        t = topicEnd + 1;
+    }
+    return t > topic.size();
+}
+
+void LoopbackBroker::send(int socket, const uint8_t* data, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t result = ::send(socket, data + written, length - written, MSG_NOSIGNAL);
+        if (result <= 0) {
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        written += result;
+    }
+}
+
+void LoopbackBroker::sendPacket(int socket, uint8_t header, const uint8_t* body, size_t length) {
+    uint8_t fixedHeader[5];
+    size_t headerLength = 0;
+    fixedHeader[headerLength++] = header;
+    size_t remaining = length;
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        fixedHeader[headerLength++] = remaining > 0 ? digit | 0x80 : digit;
+    } while (remaining > 0);
+
+    std::vector<uint8_t> packet(fixedHeader, fixedHeader + headerLength);
+    packet.insert(packet.end(), body, body + length);
+    send(socket, packet.data(), packet.size());
+}
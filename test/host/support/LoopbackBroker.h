@@ -0,0 +1,50 @@
+#ifndef LOOPBACK_BROKER_H
+#define LOOPBACK_BROKER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Minimal MQTT 3.1.1 broker on 127.0.0.1 for host tests: clean sessions only,
+// deliveries are QoS 0, and retained messages are not stored. Runs on its own
+// thread so its CPU time can be told apart from the client's.
+class LoopbackBroker {
+public:
+    LoopbackBroker();
+    ~LoopbackBroker();
+
+    bool begin();
+    void end();
+    uint16_t getPort() const { return port; }
+
+    uint32_t getPublished() const { return published.load(); }
+    uint32_t getDelivered() const { return delivered.load(); }
+    uint64_t getCpuMicros();
+
+private:
+    struct Connection {
+        int socket;
+        std::vector<uint8_t> input;
+        std::vector<std::string> filters;
+    };
+
+    int listener;
+    uint16_t port;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<uint32_t> published;
+    std::atomic<uint32_t> delivered;
+    std::vector<Connection> connections;
+
+    void run();
+    bool receive(Connection& connection);
+    bool handlePacket(Connection& connection, uint8_t header, const uint8_t* body, uint32_t length);
+    void route(const std::string& topic, const uint8_t* payload, uint32_t length);
+    static bool matches(const std::string& filter, const std::string& topic);
+    static void send(int socket, const uint8_t* data, size_t length);
+    static void sendPacket(int socket, uint8_t header, const uint8_t* body, size_t length);
+};
+
+#endif
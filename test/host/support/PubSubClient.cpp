@@ -0,0 +1,311 @@
+#include "PubSubClient.h"
+
+static const uint8_t CONNECT = 0x10;
+static const uint8_t CONNACK = 0x20;
+static const uint8_t PUBLISH = 0x30;
+static const uint8_t PUBACK = 0x40;
+static const uint8_t SUBSCRIBE = 0x80;
+static const uint8_t UNSUBSCRIBE = 0xA0;
+static const uint8_t PINGREQ = 0xC0;
+static const uint8_t PINGRESP = 0xD0;
+static const uint8_t DISCONNECT = 0xE0;
+
+// Packets are assembled after a 5-byte gap, the most a fixed header needs.
+static const size_t HEADER_SPACE = 5;
+
+PubSubClient::PubSubClient(Client& client)
+    : client(client)
+    , buffer(nullptr)
+    , bufferSize(0)
+    , nextMessageId(1)
+    , lastInActivity(0)
+    , lastOutActivity(0)
+    , pingOutstanding(false)
+    , connectionState(MQTT_DISCONNECTED)
+    , domain(nullptr)
+    , port(0) {
+    setBufferSize(256);
+}
+
+PubSubClient::~PubSubClient() {
+    free(buffer);
+}
+
+PubSubClient& PubSubClient::setServer(const char* domain, uint16_t port) {
+    this->domain = domain;
+    this->port = port;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
+    this->callback = callback;
+    return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size) {
+    uint8_t* resized = static_cast<uint8_t*>(realloc(buffer, size));
+    if (!resized) {
+        return false;
+    }
+    buffer = resized;
+    bufferSize = size;
+    return true;
+}
+
+bool PubSubClient::connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, bool willRetain, const char* willMessage, bool cleanSession) {
+    if (connected()) {
+        return false;
+    }
+    if (!client.connect(domain, port)) {
+        connectionState = MQTT_CONNECT_FAILED;
+        return false;
+    }
+
+    nextMessageId = 1;
+    size_t position = HEADER_SPACE;
+    const uint8_t protocol[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04};
+    memcpy(buffer + position, protocol, sizeof(protocol));
+    position += sizeof(protocol);
+
+    uint8_t flags = cleanSession ? 0x02 : 0x00;
+    if (user) {
+        flags |= 0x80;
+        if (pass) {
+            flags |= 0x40;
+        }
+    }
+    buffer[position++] = flags;
+    buffer[position++] = KEEP_ALIVE >> 8;
+    buffer[position++] = KEEP_ALIVE & 0xFF;
+
+    position = writeString(id, position);
+    if (user) {
+        position = writeString(user, position);
+        if (pass) {
+            position = writeString(pass, position);
+        }
+    }
+    if (!writePacket(CONNECT, position - HEADER_SPACE)) {
+        client.stop();
+        connectionState = MQTT_CONNECT_FAILED;
+        return false;
+    }
+
+    lastInActivity = millis();
+    while (!client.available()) {
+        if (millis() - lastInActivity >= SOCKET_TIMEOUT) {
+            client.stop();
+            connectionState = MQTT_CONNECTION_TIMEOUT;
+            return false;
+        }
+        delay(1);
+    }
+
+    uint32_t length = readPacket();
+    if (length == 4 && (buffer[0] & 0xF0) == CONNACK && buffer[3] == 0) {
+        lastInActivity = millis();
+        pingOutstanding = false;
+        connectionState = MQTT_CONNECTED;
+        return true;
+    }
+
+    connectionState = length == 4 ? buffer[3] : MQTT_CONNECT_FAILED;
+    client.stop();
+    return false;
+}
+
+void PubSubClient::disconnect() {
+    const uint8_t packet[] = {DISCONNECT, 0x00};
+    client.write(packet, sizeof(packet));
+    connectionState = MQTT_DISCONNECTED;
+    client.flush();
+    client.stop();
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+    if (!connected() || HEADER_SPACE + 2 + strlen(topic) + length > bufferSize) {
+        return false;
+    }
+
+    size_t position = writeString(topic, HEADER_SPACE);
+    memcpy(buffer + position, payload, length);
+    position += length;
+    return writePacket(PUBLISH | (retained ? 0x01 : 0x00), position - HEADER_SPACE);
+}
+
+bool PubSubClient::subscribe(const char* topic) {
+    if (!connected() || HEADER_SPACE + 2 + 2 + strlen(topic) + 1 > bufferSize) {
+        return false;
+    }
+
+    size_t position = HEADER_SPACE;
+    uint16_t messageId = nextMessageId++;
+    buffer[position++] = messageId >> 8;
+    buffer[position++] = messageId & 0xFF;
+    position = writeString(topic, position);
+    buffer[position++] = 0;
+    return writePacket(SUBSCRIBE | 0x02, position - HEADER_SPACE);
+}
+
+bool PubSubClient::unsubscribe(const char* topic) {
+    if (!connected() || HEADER_SPACE + 2 + 2 + strlen(topic) > bufferSize) {
+        return false;
+    }
+
+    size_t position = HEADER_SPACE;
+    uint16_t messageId = nextMessageId++;
+    buffer[position++] = messageId >> 8;
+    buffer[position++] = messageId & 0xFF;
+    position = writeString(topic, position);
+    return writePacket(UNSUBSCRIBE | 0x02, position - HEADER_SPACE);
+}
+
+bool PubSubClient::loop() {
+    if (!connected()) {
+        return false;
+    }
+
+    uint32_t now = millis();
+    if (now - lastInActivity > KEEP_ALIVE * 1000UL || now - lastOutActivity > KEEP_ALIVE * 1000UL) {
+        if (pingOutstanding) {
+            connectionState = MQTT_CONNECTION_TIMEOUT;
+            client.stop();
+            return false;
+        }
+        const uint8_t packet[] = {PINGREQ, 0x00};
+        client.write(packet, sizeof(packet));
+        lastOutActivity = now;
+        lastInActivity = now;
+        pingOutstanding = true;
+    }
+
+    if (!client.available()) {
+        return true;
+    }
+
+    uint32_t length = readPacket();
+    if (length == 0) {
+        return connected();
+    }
+    lastInActivity = millis();
+
+    uint8_t type = buffer[0] & 0xF0;
+    if (type == PUBLISH && callback) {
+        uint8_t headerLength = 1;
+        while (buffer[headerLength] & 0x80) {
+            headerLength++;
+        }
+        headerLength++;
+
+        uint16_t topicLength = (buffer[headerLength] << 8) | buffer[headerLength + 1];
+        // Shift the topic down a byte to make room for its terminator.
+        memmove(buffer + headerLength, buffer + headerLength + 2, topicLength);
+        buffer[headerLength + topicLength] = '\0';
+        char* topic = reinterpret_cast<char*>(buffer + headerLength);
+
+        size_t payloadStart = headerLength + topicLength + 2;
+        if ((buffer[0] & 0x06) == 0x02) {
+            uint16_t messageId = (buffer[payloadStart] << 8) | buffer[payloadStart + 1];
+            payloadStart += 2;
+            callback(topic, buffer + payloadStart, length - payloadStart);
+
+            const uint8_t ack[] = {PUBACK, 0x02, static_cast<uint8_t>(messageId >> 8), static_cast<uint8_t>(messageId & 0xFF)};
+            client.write(ack, sizeof(ack));
+            lastOutActivity = millis();
+        } else {
+            callback(topic, buffer + payloadStart, length - payloadStart);
+        }
+    } else if (type == PINGREQ) {
+        const uint8_t packet[] = {PINGRESP, 0x00};
+        client.write(packet, sizeof(packet));
+    } else if (type == PINGRESP) {
+        pingOutstanding = false;
+    }
+    return true;
+}
+
+bool PubSubClient::connected() {
+    if (!client.connected()) {
+        if (connectionState == MQTT_CONNECTED) {
+            connectionState = MQTT_CONNECTION_LOST;
+            client.flush();
+            client.stop();
+        }
+        return false;
+    }
+    return connectionState == MQTT_CONNECTED;
+}
+
+bool PubSubClient::readByte(uint8_t& value) {
+    uint32_t start = millis();
+    while (!client.available()) {
+        if (millis() - start >= SOCKET_TIMEOUT) {
+            return false;
+        }
+        delay(1);
+    }
+    value = client.read();
+    return true;
+}
+
+// Reads one whole packet into buffer and returns its length including the
+// fixed header. Oversized packets are consumed and dropped.
+uint32_t PubSubClient::readPacket() {
+    uint32_t length = 0;
+    uint8_t value;
+    if (!readByte(value)) {
+        return 0;
+    }
+    buffer[length++] = value;
+
+    uint32_t remaining = 0;
+    uint8_t shift = 0;
+    do {
+        if (length == 5 || !readByte(value)) {
+            return 0;
+        }
+        buffer[length++] = value;
+        remaining |= static_cast<uint32_t>(value & 0x7F) << shift;
+        shift += 7;
+    } while (value & 0x80);
+
+    uint32_t total = length + remaining;
+    for (uint32_t i = 0; i < remaining; i++) {
+        if (!readByte(value)) {
+            return 0;
+        }
+        if (length < bufferSize) {
+            buffer[length] = value;
+        }
+        length++;
+    }
+    return total <= bufferSize ? total : 0;
+}
+
+size_t PubSubClient::writeString(const char* text, size_t position) {
+    size_t length = strlen(text);
+    buffer[position++] = length >> 8;
+    buffer[position++] = length & 0xFF;
+    memcpy(buffer + position, text, length);
+    return position + length;
+}
+
+bool PubSubClient::writePacket(uint8_t header, size_t length) {
+    uint8_t lengthBytes[4];
+    uint8_t lengthCount = 0;
+    size_t remaining = length;
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        lengthBytes[lengthCount++] = remaining > 0 ? digit | 0x80 : digit;
+    } while (remaining > 0);
+
+    size_t start = HEADER_SPACE - 1 - lengthCount;
+    buffer[start] = header;
+    memcpy(buffer + start + 1, lengthBytes, lengthCount);
+
+    size_t size = 1 + lengthCount + length;
+    bool written = client.write(buffer + start, size) == size;
+    lastOutActivity = millis();
+    return written;
+}
@@ -0,0 +1,60 @@
+#ifndef PUBSUBCLIENT_H
+#define PUBSUBCLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+// Host stand-in for knolleary/PubSubClient with the same behaviour where the
+// firmware depends on it: QoS 0 publish only, SUBSCRIBE does not wait for
+// SUBACK, connect() blocks for CONNACK, and loop() handles at most one
+// inbound packet per call.
+
+#define MQTT_CONNECTED 0
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+class PubSubClient {
+public:
+    PubSubClient(Client& client);
+    ~PubSubClient();
+
+    PubSubClient& setServer(const char* domain, uint16_t port);
+    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+    bool setBufferSize(uint16_t size);
+
+    bool connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, bool willRetain, const char* willMessage, bool cleanSession);
+    void disconnect();
+    bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained);
+    bool subscribe(const char* topic);
+    bool unsubscribe(const char* topic);
+    bool loop();
+    bool connected();
+    int state() { return connectionState; }
+
+private:
+    static const uint16_t KEEP_ALIVE = 15;
+    static const uint32_t SOCKET_TIMEOUT = 15000;
+
+    Client& client;
+    uint8_t* buffer;
+    uint16_t bufferSize;
+    uint16_t nextMessageId;
+    uint32_t lastInActivity;
+    uint32_t lastOutActivity;
+    bool pingOutstanding;
+    int connectionState;
+    const char* domain;
+    uint16_t port;
+    std::function<void(char*, uint8_t*, unsigned int)> callback;
+
+    bool readByte(uint8_t& value);
+    uint32_t readPacket();
+    size_t writeString(const char* text, size_t position);
+    bool writePacket(uint8_t header, size_t length);
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include <WiFiClient.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+        return 0;
+    }
+
+    socket = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (socket < 0) {
+        return 0;
+    }
+    if (::connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        stop();
+        return 0;
+    }
+
+    // lwIP on the device sends small writes straight away too.
+    int enabled = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (socket >= 0 && written < size) {
+        ssize_t result = send(socket, buffer + written, size - written, MSG_NOSIGNAL);
+        if (result > 0) {
+            written += result;
+        } else if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            usleep(100);
+        } else {
+            break;
+        }
+    }
+    return written;
+}
+
+int WiFiClient::available() {
+    int count = 0;
+    if (socket < 0 || ioctl(socket, FIONREAD, &count) != 0) {
+        count = 0;
+    }
+    return bufferEnd - bufferStart + count;
+}
+
+bool WiFiClient::fill() {
+    if (bufferStart < bufferEnd) {
+        return true;
+    }
+    if (socket < 0) {
+        return false;
+    }
+
+    ssize_t result = recv(socket, buffer, sizeof(buffer), 0);
+    if (result <= 0) {
+        return false;
+    }
+    bufferStart = 0;
+    bufferEnd = result;
+    return true;
+}
+
+int WiFiClient::read() {
+    if (!fill()) {
+        return -1;
+    }
+    return buffer[bufferStart++];
+}
+
+int WiFiClient::read(uint8_t* destination, size_t size) {
+    if (!fill()) {
+        return -1;
+    }
+
+    size_t count = bufferEnd - bufferStart;
+    if (count > size) {
+        count = size;
+    }
+    memcpy(destination, buffer + bufferStart, count);
+    bufferStart += count;
+    return count;
+}
+
+int WiFiClient::peek() {
+    if (!fill()) {
+        return -1;
+    }
+    return buffer[bufferStart];
+}
+
+void WiFiClient::stop() {
+    if (socket >= 0) {
+        close(socket);
+        socket = -1;
+    }
+    bufferStart = 0;
+    bufferEnd = 0;
+}
+
+// Connected until the peer has closed and everything it sent has been read.
+uint8_t WiFiClient::connected() {
+    if (socket < 0) {
+        return 0;
+    }
+    if (bufferStart < bufferEnd) {
+        return 1;
+    }
+
+    uint8_t value;
+    ssize_t result = recv(socket, &value, 1, MSG_PEEK);
+    if (result > 0 || (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef WIFI_CLIENT_H
+#define WIFI_CLIENT_H
+
+#include <Client.h>
+
+// Non-blocking TCP client over a POSIX socket, with Arduino WiFiClient
+// semantics: read() returns -1 when nothing is buffered. Like the ESP32
+// WiFiClient it reads the socket through a receive buffer, so byte-wise
+// reads do not cost a syscall each.
+class WiFiClient : public Client {
+public:
+    WiFiClient() : socket(-1), bufferStart(0), bufferEnd(0) {}
+    ~WiFiClient() override { stop(); }
+
+    int connect(IPAddress ip, uint16_t port) override { return 0; }
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t value) override { return write(&value, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return socket >= 0; }
+
+private:
+    static const size_t RX_BUFFER_SIZE = 1436;
+
+    int socket;
+    uint8_t buffer[RX_BUFFER_SIZE];
+    size_t bufferStart;
+    size_t bufferEnd;
+
+    bool fill();
+};
+
+#endif
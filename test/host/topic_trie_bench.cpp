@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "MQTTTopicTrie.h"
+
+// Dispatch cost of MQTTTopicTrie against the linear matchTopic() scan it
+// replaced, for 10, 100 and 1000 subscriptions. Built with enlarged pools;
+// the firmware keeps the defaults from MQTTTopicTrie.h. Both matchers must
+// agree on the number of matching filters for every probe topic.
+
+static const uint32_t DISPATCHES = 200000;
+
+// MQTTManager::matchTopic() before the trie
+static bool matchTopic(const char* pattern, const char* topic) {
+    while (*pattern && *topic) {
+        if (*pattern == '+') {
+            while (*topic && *topic != '/') topic++;
+            pattern++;
+            if (*topic) topic++;
+            if (*pattern) pattern++;
+            continue;
+        }
+        if (*pattern == '#') {
+            return true;
+        }
+        if (*pattern != *topic) return false;
+        pattern++;
+        topic++;
+    }
+    return *pattern == *topic;
+}
+
+static uint16_t matchLinear(const std::vector<std::string>& filters, const char* topic) {
+    uint16_t count = 0;
+    for (const std::string& filter : filters) {
+        if (matchTopic(filter.c_str(), topic)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static bool run(uint16_t subscriptions) {
+    MQTTTopicTrie* trie = new MQTTTopicTrie();
+    std::vector<std::string> filters;
+
+    for (uint16_t i = 0; i < subscriptions; i++) {
+        char filter[64];
+        const char* leaf = i % 3 == 0 ? "+" : (i % 3 == 1 ? "#" : "set");
+        if (i % 10 == 9) {
+            snprintf(filter, sizeof(filter), "gpsno/devices/+/rpc/%u", i);
+        } else {
+            snprintf(filter, sizeof(filter), "gpsno/devices/%u/cmd/%s", i, leaf);
+        }
+        if (!trie->insert(filter, i % 250)) {
+            fprintf(stderr, "FAIL: trie full at %u filters\n", i);
+            delete trie;
+            return false;
+        }
+        filters.push_back(filter);
+    }
+
+    const char* probes[] = {
+        "gpsno/devices/5/cmd/set",
+        "gpsno/devices/7/cmd/reboot/now",
+        "gpsno/devices/8/rpc/19",
+        "gpsno/anchors/1/status",
+    };
+    for (const char* probe : probes) {
+        uint16_t trieCount = trie->match(probe, [](uint8_t) {});
+        uint16_t linearCount = matchLinear(filters, probe);
+        if (trieCount != linearCount) {
+            fprintf(stderr, "FAIL: '%s' matched %u filters in the trie, %u linearly\n", probe, trieCount, linearCount);
+            delete trie;
+            return false;
+        }
+    }
+
+    const char* topic = "gpsno/devices/5/cmd/set";
+    volatile uint32_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < DISPATCHES; i++) {
+        trie->match(topic, [&sink](uint8_t handler) { sink += handler; });
+    }
+    double trieNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / DISPATCHES;
+
+    uint32_t linearDispatches = DISPATCHES / (subscriptions / 10 + 1);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < linearDispatches; i++) {
+        sink += matchLinear(filters, topic);
+    }
+    double linearNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / linearDispatches;
+
+    printf("%4u subs: trie %.0f ns/msg, linear %.0f ns/msg\n", subscriptions, trieNanos, linearNanos);
+    delete trie;
+    return true;
+}
+
+int main() {
+    bool passed = true;
+    const uint16_t counts[] = {10, 100, 1000};
+    for (uint16_t subscriptions : counts) {
+        passed &= run(subscriptions);
+    }
+    return passed ? 0 : 1;
+}